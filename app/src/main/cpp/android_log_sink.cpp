@@ -0,0 +1,121 @@
+#include "android_log_sink.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <chrono>
+#include <cstring>
+#include <pthread.h>
+#include <thread>
+
+namespace {
+int toAndroidPriority(logs::level level) {
+  switch (level) {
+  case logs::level::always:
+  case logs::level::fatal:
+    return ANDROID_LOG_FATAL;
+  case logs::level::error:
+    return ANDROID_LOG_ERROR;
+  case logs::level::todo:
+    return ANDROID_LOG_WARN;
+  case logs::level::success:
+    return ANDROID_LOG_INFO;
+  case logs::level::warning:
+    return ANDROID_LOG_WARN;
+  case logs::level::notice:
+    return ANDROID_LOG_DEBUG;
+  case logs::level::trace:
+    return ANDROID_LOG_VERBOSE;
+  }
+
+  return ANDROID_LOG_DEFAULT;
+}
+} // namespace
+
+AndroidLogSink::AndroidLogSink() {
+  // Detached and never stopped: emulator threads may keep logging while the
+  // process is torn down
+  std::thread([this] {
+    pthread_setname_np(pthread_self(), "Log Sink");
+    drain();
+  }).detach();
+
+  logs::listener::add(this);
+}
+
+void AndroidLogSink::log(u64 stamp, const logs::message &msg,
+                         const std::string &prefix, const std::string &text) {
+  const auto level = static_cast<logs::level>(msg);
+  const int priority = toAndroidPriority(level);
+  const auto fill = [&](Slot &slot) {
+    slot.priority = priority;
+    slot.size = static_cast<u32>(std::min(text.size(), kMaxTextSize));
+    std::memcpy(slot.text, text.data(), slot.size);
+    slot.text[slot.size] = '\0';
+  };
+
+  u64 position;
+  if (!ring.push(fill, position)) {
+    droppedCount++;
+    return;
+  }
+
+  if (text.size() > kMaxTextSize) {
+    truncatedCount++;
+  }
+
+  if (pending++ == 0) {
+    pending.notify_one();
+  }
+
+  // The process is likely about to abort, make sure the message reaches logcat
+  if (level == logs::level::fatal) {
+    flush(position);
+  }
+}
+
+void AndroidLogSink::drain() {
+  u64 reportedDropped = 0;
+  u64 reportedTruncated = 0;
+  const auto write = [](Slot &slot) {
+    __android_log_write(slot.priority, "RPCS3", slot.text);
+  };
+
+  while (true) {
+    while (ring.pop(write)) {
+    }
+
+    if (const u64 droppedNow = droppedCount; droppedNow != reportedDropped) {
+      __android_log_print(ANDROID_LOG_WARN, "RPCS3",
+                          "Log sink: %llu messages dropped",
+                          static_cast<unsigned long long>(droppedNow -
+                                                          reportedDropped));
+      reportedDropped = droppedNow;
+    }
+
+    if (const u64 truncatedNow = truncatedCount;
+        truncatedNow != reportedTruncated) {
+      __android_log_print(ANDROID_LOG_WARN, "RPCS3",
+                          "Log sink: %llu messages truncated to %zu bytes",
+                          static_cast<unsigned long long>(truncatedNow -
+                                                          reportedTruncated),
+                          kMaxTextSize);
+      reportedTruncated = truncatedNow;
+    }
+
+    // Producers increment pending after publishing a slot, a non-zero value
+    // means something may have arrived since the last pop()
+    if (pending.exchange(0) == 0) {
+      pending.wait(0);
+    }
+  }
+}
+
+void AndroidLogSink::flush(u64 position) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+  while (ring.consumed() <= position &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
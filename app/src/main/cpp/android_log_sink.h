@@ -0,0 +1,60 @@
+#pragma once
+
+#include "log_ring.h"
+#include "util/atomic.hpp"
+#include "util/logs.hpp"
+#include "util/types.hpp"
+
+#include <atomic>
+#include <string>
+
+// logs::listener which forwards messages to logcat from a background thread.
+// Emulator threads (PPU, SPU, RSX...) only copy the text into a bounded
+// multi-producer ring, so a burst of messages never blocks them on logd.
+// When the ring is full the message is dropped and counted instead.
+//
+// Per-channel filtering is done by logs::set_level, disabled levels are
+// rejected by the channel before the message is formatted.
+class AndroidLogSink final : public logs::listener {
+public:
+  static constexpr usz kSlotCount = 1024;
+
+  // The longest text logd keeps in one entry: LOGGER_ENTRY_MAX_PAYLOAD (4068)
+  // less the priority byte, the "RPCS3" tag and both terminators. Longer
+  // messages are truncated and counted. The ring takes about 4 MB
+  static constexpr usz kMaxTextSize = 4068 - 1 - sizeof("RPCS3") - 1;
+
+  AndroidLogSink();
+
+  AndroidLogSink(const AndroidLogSink &) = delete;
+  AndroidLogSink &operator=(const AndroidLogSink &) = delete;
+
+  void log(u64 stamp, const logs::message &msg, const std::string &prefix,
+           const std::string &text) override;
+
+  // Number of messages lost because the ring was full
+  u64 dropped() const { return droppedCount.load(); }
+
+  // Number of messages cut to kMaxTextSize
+  u64 truncated() const { return truncatedCount.load(); }
+
+private:
+  struct Slot {
+    int priority = 0;
+    u32 size = 0;
+    char text[kMaxTextSize + 1];
+  };
+
+  void drain();
+
+  // Waits until the drain thread wrote everything up to position
+  void flush(u64 position);
+
+  LogRing<Slot> ring{kSlotCount};
+  std::atomic<u64> droppedCount = 0;
+  std::atomic<u64> truncatedCount = 0;
+
+  // Messages published since the drain thread last checked, it is only
+  // notified on the transition from zero
+  atomic_t<u32> pending = 0;
+};
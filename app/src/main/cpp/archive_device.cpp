@@ -0,0 +1,305 @@
+#include "archive_device.h"
+
+#include "util/logs.hpp"
+
+LOG_CHANNEL(archive_log, "Archive");
+
+namespace {
+std::vector<std::string> splitPath(std::string_view path) {
+  std::vector<std::string> parts;
+
+  while (!path.empty()) {
+    const auto slash = path.find('/');
+    const auto part = path.substr(0, slash);
+
+    if (part == "..") {
+      if (!parts.empty()) {
+        parts.pop_back();
+      }
+    } else if (!part.empty() && part != ".") {
+      parts.emplace_back(part);
+    }
+
+    if (slash == std::string_view::npos) {
+      break;
+    }
+
+    path.remove_prefix(slash + 1);
+  }
+
+  return parts;
+}
+
+std::string joinPath(const std::vector<std::string> &parts) {
+  std::string result;
+
+  for (auto &part : parts) {
+    if (!result.empty()) {
+      result += '/';
+    }
+
+    result += part;
+  }
+
+  return result;
+}
+
+class ArchiveFile final : public fs::file_base {
+public:
+  ArchiveFile(std::shared_ptr<ArchiveDevice> device, usz entry,
+              const fs::stat_t &info)
+      : device(std::move(device)), entry(entry), info(info) {}
+
+  fs::stat_t get_stat() override { return info; }
+
+  bool trunc(u64) override {
+    fs::g_tls_error = fs::error::readonly;
+    return false;
+  }
+
+  u64 read(void *buffer, u64 size) override {
+    const u64 result = device->read(entry, pos, buffer, size);
+    pos += result;
+    return result;
+  }
+
+  u64 read_at(u64 offset, void *buffer, u64 size) override {
+    return device->read(entry, offset, buffer, size);
+  }
+
+  u64 write(const void *, u64) override {
+    fs::g_tls_error = fs::error::readonly;
+    return 0;
+  }
+
+  u64 seek(s64 offset, fs::seek_mode whence) override {
+    const s64 base = whence == fs::seek_set   ? 0
+                     : whence == fs::seek_cur ? static_cast<s64>(pos)
+                                              : static_cast<s64>(info.size);
+
+    if (base + offset < 0) {
+      fs::g_tls_error = fs::error::inval;
+      return -1;
+    }
+
+    pos = base + offset;
+    return pos;
+  }
+
+  u64 size() override { return info.size; }
+
+private:
+  std::shared_ptr<ArchiveDevice> device;
+  usz entry;
+  fs::stat_t info;
+  u64 pos = 0;
+};
+
+class ArchiveDir final : public fs::dir_base {
+public:
+  explicit ArchiveDir(std::vector<fs::dir_entry> entries)
+      : entries(std::move(entries)) {}
+
+  bool read(fs::dir_entry &entry) override {
+    if (index >= entries.size()) {
+      return false;
+    }
+
+    entry = entries[index++];
+    return true;
+  }
+
+  void rewind() override { index = 0; }
+
+private:
+  std::vector<fs::dir_entry> entries;
+  usz index = 0;
+};
+} // namespace
+
+std::string ArchiveDevice::mount(std::shared_ptr<ArchiveDevice> device) {
+  std::string root = device->root();
+  archive_log.notice("Mounting archive at %s", root);
+  fs::set_virtual_device(device->fs_prefix, device);
+  return root;
+}
+
+void ArchiveDevice::unmount(const ArchiveDevice &device) {
+  archive_log.notice("Unmounting archive at %s", device.root());
+  fs::set_virtual_device(device.fs_prefix, nullptr);
+}
+
+void ArchiveDevice::build(const std::vector<Entry> &entries, s64 mtime) {
+  modified = mtime;
+  addDirectory("");
+
+  for (usz i = 0; i < entries.size(); i++) {
+    const auto &entry = entries[i];
+    auto parts = splitPath(entry.name);
+
+    if (parts.empty()) {
+      archive_log.warning("Skipping entry with name '%s'", entry.name);
+      continue;
+    }
+
+    const std::string path = joinPath(parts);
+
+    if (entry.directory) {
+      addDirectory(path);
+      continue;
+    }
+
+    const std::string name = std::move(parts.back());
+    parts.pop_back();
+
+    auto &parent = addDirectory(joinPath(parts));
+    auto [node, inserted] = nodes.try_emplace(path);
+
+    if (inserted) {
+      parent.children.push_back(name);
+    } else if (node->second.directory) {
+      archive_log.warning("Skipping file '%s' which is also a directory",
+                          path);
+      continue;
+    } else {
+      totalSize -= node->second.size;
+    }
+
+    node->second.entry = i;
+    node->second.size = entry.size;
+    node->second.directory = false;
+    totalSize += entry.size;
+  }
+}
+
+ArchiveDevice::Node &ArchiveDevice::addDirectory(const std::string &path) {
+  if (auto it = nodes.find(path); it != nodes.end()) {
+    return it->second;
+  }
+
+  if (!path.empty()) {
+    const auto slash = path.rfind('/');
+    const std::string parentPath =
+        slash == std::string::npos ? "" : path.substr(0, slash);
+    const std::string name =
+        slash == std::string::npos ? path : path.substr(slash + 1);
+
+    addDirectory(parentPath).children.push_back(name);
+  }
+
+  auto &node = nodes[path];
+  node.directory = true;
+  return node;
+}
+
+std::string ArchiveDevice::relative(const std::string &path) const {
+  std::string_view view = path;
+
+  if (view.starts_with(fs_prefix)) {
+    view.remove_prefix(fs_prefix.size());
+  }
+
+  return joinPath(splitPath(view));
+}
+
+const ArchiveDevice::Node *ArchiveDevice::find(const std::string &path) const {
+  const auto it = nodes.find(relative(path));
+  if (it == nodes.end()) {
+    fs::g_tls_error = fs::error::noent;
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+fs::stat_t ArchiveDevice::statOf(const Node &node) const {
+  fs::stat_t info{};
+  info.is_directory = node.directory;
+  info.is_writable = false;
+  info.size = node.size;
+  info.atime = modified;
+  info.mtime = modified;
+  info.ctime = modified;
+  return info;
+}
+
+bool ArchiveDevice::stat(const std::string &path, fs::stat_t &info) {
+  const Node *node = find(path);
+  if (node == nullptr) {
+    return false;
+  }
+
+  info = statOf(*node);
+  return true;
+}
+
+bool ArchiveDevice::statfs(const std::string &path, fs::device_stat &info) {
+  if (find(path) == nullptr) {
+    return false;
+  }
+
+  info.block_size = 4096;
+  info.total_size = totalSize;
+  info.total_free = 0;
+  info.avail_free = 0;
+  return true;
+}
+
+std::unique_ptr<fs::file_base>
+ArchiveDevice::open(const std::string &path, bs_t<fs::open_mode> mode) {
+  if (mode & fs::write || mode & fs::append || mode & fs::create ||
+      mode & fs::trunc) {
+    fs::g_tls_error = fs::error::readonly;
+    return nullptr;
+  }
+
+  const Node *node = find(path);
+  if (node == nullptr) {
+    return nullptr;
+  }
+
+  if (node->directory) {
+    fs::g_tls_error = fs::error::isdir;
+    return nullptr;
+  }
+
+  return std::make_unique<ArchiveFile>(shared_from_this(), node->entry,
+                                       statOf(*node));
+}
+
+std::unique_ptr<fs::dir_base> ArchiveDevice::open_dir(const std::string &path) {
+  const Node *node = find(path);
+  if (node == nullptr) {
+    return nullptr;
+  }
+
+  if (!node->directory) {
+    fs::g_tls_error = fs::error::inval;
+    return nullptr;
+  }
+
+  std::string prefix = relative(path);
+  if (!prefix.empty()) {
+    prefix += '/';
+  }
+
+  // Listed like a native directory, with "." and ".."
+  std::vector<fs::dir_entry> entries;
+  entries.reserve(node->children.size() + 2);
+
+  for (const char *name : {".", ".."}) {
+    fs::dir_entry entry{};
+    static_cast<fs::stat_t &>(entry) = statOf(*node);
+    entry.name = name;
+    entries.push_back(std::move(entry));
+  }
+
+  for (auto &name : node->children) {
+    fs::dir_entry entry{};
+    static_cast<fs::stat_t &>(entry) = statOf(nodes.at(prefix + name));
+    entry.name = name;
+    entries.push_back(std::move(entry));
+  }
+
+  return std::make_unique<ArchiveDir>(std::move(entries));
+}
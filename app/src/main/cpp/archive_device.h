@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Utilities/File.h"
+#include "util/types.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Read-only VFS device over the file table of an archive, the contents
+// appear under fs_prefix as if they were extracted there. Subclasses list
+// their entries once and serve reads at arbitrary offsets, from any thread.
+// Devices are created with std::make_shared, open files keep them alive.
+class ArchiveDevice : public fs::device_base,
+                      public std::enable_shared_from_this<ArchiveDevice> {
+public:
+  struct Entry {
+    // Path below the root, separated by '/'
+    std::string name;
+    u64 size = 0;
+    bool directory = false;
+  };
+
+  // Mounts the device, returns the path of the archive root
+  static std::string mount(std::shared_ptr<ArchiveDevice> device);
+
+  // Removes the device from the VFS. Files opened through it keep working
+  // until they are closed
+  static void unmount(const ArchiveDevice &device);
+
+  std::string root() const { return fs_prefix + "/"; }
+
+  // Reads up to size bytes of the entry with the given index into the list
+  // passed to build(), returns the bytes read
+  virtual u64 read(usz entry, u64 offset, void *buffer, u64 size) = 0;
+
+  bool stat(const std::string &path, fs::stat_t &info) override;
+  bool statfs(const std::string &path, fs::device_stat &info) override;
+  std::unique_ptr<fs::file_base> open(const std::string &path,
+                                      bs_t<fs::open_mode> mode) override;
+  std::unique_ptr<fs::dir_base> open_dir(const std::string &path) override;
+
+protected:
+  // Call once from the subclass constructor. Later entries with the same
+  // name replace earlier ones, as they would on extraction
+  void build(const std::vector<Entry> &entries, s64 mtime);
+
+private:
+  struct Node {
+    // Index into the entries, unused for directories
+    usz entry = 0;
+    u64 size = 0;
+    bool directory = false;
+    std::vector<std::string> children;
+  };
+
+  // Path below the root, normalized to the keys of nodes
+  std::string relative(const std::string &path) const;
+
+  const Node *find(const std::string &path) const;
+  fs::stat_t statOf(const Node &node) const;
+  Node &addDirectory(const std::string &path);
+
+  // Keyed by the path relative to the root, without leading or trailing
+  // slashes. The root itself is ""
+  std::unordered_map<std::string, Node> nodes;
+  u64 totalSize = 0;
+  s64 modified = 0;
+};
@@ -0,0 +1,189 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+constexpr u64 kThreadSamplePeriod = 1'000'000'000;
+
+f64 toSeconds(u64 ns) { return static_cast<f64>(ns) / 1e9; }
+f64 toMilliseconds(u64 ns) { return static_cast<f64>(ns) / 1e6; }
+
+void appendJsonString(std::string &out, const std::string &value) {
+  out += '"';
+
+  for (char c : value) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+  }
+
+  out += '"';
+}
+
+void appendJsonNumber(std::string &out, const char *name, f64 value,
+                      bool last = false) {
+  char buffer[128];
+  std::snprintf(buffer, sizeof(buffer), "\"%s\": %.3f%s", name, value,
+                last ? "" : ", ");
+  out += buffer;
+}
+} // namespace
+
+BenchmarkRecorder::BenchmarkRecorder(Limits limits) : limits(limits) {
+  if (limits.frames != 0) {
+    frameTimes.reserve(limits.frames);
+  }
+}
+
+void BenchmarkRecorder::start(u64 now) {
+  startTime = now;
+  lastSampleTime = now;
+  lastThreadSampleTime = now;
+
+  // Resets VmHWM, not permitted everywhere. Sampled VmRSS is the fallback
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5" << std::flush;
+  peakRssReset = clearRefs.good();
+}
+
+void BenchmarkRecorder::onFrame(u64 now) {
+  std::lock_guard lock(frameMutex);
+
+  if (lastFrameTime != 0) {
+    frameTimes.push_back(now - lastFrameTime);
+  } else {
+    firstFrameTime = now;
+  }
+
+  lastFrameTime = now;
+  frameCount++;
+}
+
+void BenchmarkRecorder::sample(u64 now, bool compiling) {
+  if (compiling) {
+    compileTime += now - lastSampleTime;
+  }
+
+  lastSampleTime = now;
+  sampledPeakRss = std::max(sampledPeakRss, readProcessMemoryKb("VmRSS:"));
+
+  // Walking every task is comparatively expensive
+  if (now - lastThreadSampleTime >= kThreadSamplePeriod) {
+    lastThreadSampleTime = now;
+    sampleThreads();
+  }
+}
+
+void BenchmarkRecorder::stop(u64 now) {
+  lastSampleTime = now;
+  sampledPeakRss = std::max(sampledPeakRss, readProcessMemoryKb("VmRSS:"));
+  sampleThreads();
+}
+
+bool BenchmarkRecorder::done(u64 now) const {
+  if (limits.frames != 0 && frameCount >= limits.frames + 1) {
+    return true;
+  }
+
+  // The time limit starts with the first frame, boot and compilation are
+  // reported separately
+  std::lock_guard lock(frameMutex);
+  return limits.seconds != 0 && firstFrameTime != 0 &&
+         now - firstFrameTime >= limits.seconds * 1'000'000'000;
+}
+
+void BenchmarkRecorder::sampleThreads() {
+  forEachThreadCpuTime([this](int tid, ThreadClass cls, u64 ticks) {
+    // Thread ids are reused, keep the larger value for a tid
+    auto &time = threadTimes[tid];
+    time.cls = cls;
+    time.ticks = std::max(time.ticks, ticks);
+  });
+}
+
+std::string BenchmarkRecorder::toJson(const std::string &title,
+                                      bool completed) const {
+  std::vector<u64> sorted;
+  u64 first, last, count;
+
+  {
+    std::lock_guard lock(frameMutex);
+    sorted = frameTimes;
+    first = firstFrameTime;
+    last = lastFrameTime;
+    count = frameCount;
+  }
+
+  std::sort(sorted.begin(), sorted.end());
+
+  auto percentile = [&](f64 p) -> u64 {
+    if (sorted.empty()) {
+      return 0;
+    }
+
+    return sorted[std::min<usz>(sorted.size() - 1,
+                                static_cast<usz>(p * sorted.size()))];
+  };
+
+  const u64 duration = last - first;
+  const f64 intervals = static_cast<f64>(sorted.size());
+  const f64 fps = duration != 0 ? intervals / toSeconds(duration) : 0;
+  const f64 averageFrameTime =
+      sorted.empty() ? 0 : toMilliseconds(duration) / intervals;
+
+  f64 cpuTime[kThreadClassCount] = {};
+  const f64 ticksPerSecond = static_cast<f64>(clockTicksPerSecond());
+
+  for (auto &[tid, time] : threadTimes) {
+    cpuTime[static_cast<usz>(time.cls)] +=
+        static_cast<f64>(time.ticks) / ticksPerSecond;
+  }
+
+  const u64 peakRss =
+      peakRssReset ? std::max(readProcessMemoryKb("VmHWM:"), sampledPeakRss)
+                   : sampledPeakRss;
+
+  std::string out = "{\n  \"title\": ";
+  appendJsonString(out, title);
+  out += ",\n  \"completed\": ";
+  out += completed ? "true" : "false";
+  out += ",\n  \"frames\": " + std::to_string(count) + ",\n  ";
+  appendJsonNumber(out, "duration_s", toSeconds(duration));
+  appendJsonNumber(out, "fps", fps);
+  appendJsonNumber(out, "time_to_first_frame_s",
+                   first != 0 ? toSeconds(first - startTime) : 0);
+  appendJsonNumber(out, "compile_time_s", toSeconds(compileTime), true);
+  out += ",\n  \"frame_time_ms\": {";
+  appendJsonNumber(out, "avg", averageFrameTime);
+  appendJsonNumber(out, "p50", toMilliseconds(percentile(0.5)));
+  appendJsonNumber(out, "p90", toMilliseconds(percentile(0.9)));
+  appendJsonNumber(out, "p99", toMilliseconds(percentile(0.99)));
+  appendJsonNumber(out, "max",
+                   toMilliseconds(sorted.empty() ? 0 : sorted.back()), true);
+  out += "},\n  \"cpu_time_s\": {";
+  appendJsonNumber(out, "ppu", cpuTime[static_cast<usz>(ThreadClass::ppu)]);
+  appendJsonNumber(out, "spu", cpuTime[static_cast<usz>(ThreadClass::spu)]);
+  appendJsonNumber(out, "rsx", cpuTime[static_cast<usz>(ThreadClass::rsx)]);
+  appendJsonNumber(out, "other", cpuTime[static_cast<usz>(ThreadClass::other)],
+                   true);
+  out += "},\n  \"peak_rss_kb\": " + std::to_string(peakRss) + "\n}\n";
+  return out;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "proc_stats.h"
+#include "util/types.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Collects performance numbers while a title runs headless: frame times,
+// CPU time of PPU, SPU and RSX threads, time spent compiling and peak RSS.
+// Only depends on the standard library and Linux procfs, so any frontend
+// can drive it. Times are steady clock nanoseconds.
+class BenchmarkRecorder {
+public:
+  struct Limits {
+    // Zero means no limit, at least one of them should be set
+    u64 frames = 0;
+    u64 seconds = 0;
+  };
+
+  explicit BenchmarkRecorder(Limits limits);
+
+  // Called right before the title boots
+  void start(u64 now);
+
+  // Called by the renderer once per flip
+  void onFrame(u64 now);
+
+  // Called periodically by the thread driving the benchmark. Thread CPU
+  // times are sampled here, so threads which exit early are still counted
+  void sample(u64 now, bool compiling);
+
+  bool done(u64 now) const;
+
+  // Takes the final sample, call before the emulator stops
+  void stop(u64 now);
+
+  // Final report, call after the emulator stopped
+  std::string toJson(const std::string &title, bool completed) const;
+
+private:
+  struct ThreadTime {
+    ThreadClass cls;
+    u64 ticks;
+  };
+
+  void sampleThreads();
+
+  Limits limits;
+  u64 startTime = 0;
+  u64 lastSampleTime = 0;
+  u64 lastThreadSampleTime = 0;
+  u64 compileTime = 0;
+  u64 firstFrameTime = 0;
+  u64 sampledPeakRss = 0;
+  bool peakRssReset = false;
+
+  mutable std::mutex frameMutex;
+  std::vector<u64> frameTimes;
+  u64 lastFrameTime = 0;
+  std::atomic<u64> frameCount = 0;
+
+  std::unordered_map<int, ThreadTime> threadTimes;
+};
@@ -0,0 +1,314 @@
+#include "binary_log.h"
+#include "binary_log_format.h"
+
+#include "Utilities/File.h"
+
+#include <algorithm>
+#include <chrono>
+#include <pthread.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+// Producers wake the writer once per this many messages, it drains the ring
+// at least every kFlushPeriod otherwise
+constexpr u64 kWakeInterval = BinaryLogListener::kSlotCount / 8;
+constexpr auto kFlushPeriod = std::chrono::milliseconds(500);
+
+// Encoded records are written once this much accumulated, or on a timeout
+constexpr usz kFlushSize = 64 * 1024;
+
+std::string logFilePath(const std::string &dir, u32 index) {
+  if (index == 0) {
+    return dir + "RPCS3.blog";
+  }
+
+  return dir + "RPCS3." + std::to_string(index) + ".blog";
+}
+
+void encodeChannel(std::string &out, u32 id, std::string_view name) {
+  out += static_cast<char>(binlog::RecordType::channel);
+  binlog::putVarint(out, id);
+  binlog::putString(out, name);
+}
+
+void encodeMessage(std::string &out, u64 stamp, u32 channelId,
+                   logs::level level, std::string_view prefix,
+                   std::string_view text) {
+  out += static_cast<char>(binlog::RecordType::message);
+  binlog::putVarint(out, stamp);
+  binlog::putVarint(out, channelId);
+  out += static_cast<char>(level);
+  binlog::putString(out, prefix);
+  binlog::putString(out, text);
+}
+} // namespace
+
+// Current file, only touched by the writer thread
+struct BinaryLogListener::Output {
+  fs::file file;
+  z_stream stream{};
+  bool compress = false;
+  u64 size = 0;
+
+  ~Output() { close(); }
+
+  bool open(const std::string &path, bool compressed) {
+    close();
+
+    file = fs::file(path, fs::rewrite);
+    if (!file) {
+      return false;
+    }
+
+    compress = compressed;
+    size = 0;
+
+    const binlog::FileHeader header{
+        .magic = binlog::kMagic,
+        .version = binlog::kVersion,
+        .flags = compress ? binlog::kFlagCompressed : 0,
+    };
+
+    size += file.write(&header, sizeof(header));
+
+    if (compress && deflateInit(&stream, Z_BEST_SPEED) != Z_OK) {
+      file.close();
+      return false;
+    }
+
+    return true;
+  }
+
+  // Z_SYNC_FLUSH keeps the file decodable up to the last write if the
+  // process dies without closing it
+  void write(std::string_view data, int flush = Z_SYNC_FLUSH) {
+    if (!file) {
+      return;
+    }
+
+    if (!compress) {
+      size += file.write(data.data(), data.size());
+      return;
+    }
+
+    stream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+
+    Bytef buffer[64 * 1024];
+
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = sizeof(buffer);
+      deflate(&stream, flush);
+      size += file.write(buffer, sizeof(buffer) - stream.avail_out);
+    } while (stream.avail_out == 0);
+  }
+
+  void close() {
+    if (!file) {
+      return;
+    }
+
+    if (compress) {
+      write({}, Z_FINISH);
+      deflateEnd(&stream);
+    }
+
+    file.close();
+  }
+};
+
+BinaryLogListener::BinaryLogListener() {
+  // Detached and never stopped: emulator threads may keep logging while the
+  // process is torn down
+  std::thread([this] {
+    pthread_setname_np(pthread_self(), "Binary Log");
+    writeLoop();
+  }).detach();
+
+  logs::listener::add(this);
+}
+
+void BinaryLogListener::open(const std::string &dir, bool compress) {
+  {
+    std::lock_guard lock(mutex);
+
+    if (opened) {
+      return;
+    }
+
+    this->dir = dir;
+    this->compress = compress;
+    opened = true;
+  }
+
+  writerCv.notify_one();
+}
+
+void BinaryLogListener::log(u64 stamp, const logs::message &msg,
+                            const std::string &prefix,
+                            const std::string &text) {
+  const auto level = static_cast<logs::level>(msg);
+  const auto fill = [&](Slot &slot) {
+    slot.stamp = stamp;
+    slot.channel = msg->name;
+    slot.level = level;
+    slot.prefix.assign(prefix);
+    slot.text.assign(text);
+  };
+
+  u64 position;
+  if (!ring.push(fill, position)) {
+    droppedCount++;
+    return;
+  }
+
+  if (level == logs::level::fatal) {
+    sync();
+  } else if (position % kWakeInterval == 0) {
+    // Without the mutex a wakeup can be missed, the writer then picks the
+    // messages up on its next timeout
+    writerCv.notify_one();
+  }
+}
+
+void BinaryLogListener::sync() {
+  std::unique_lock lock(mutex);
+
+  if (!opened) {
+    return;
+  }
+
+  const u64 target = ring.claimed();
+  syncTarget = std::max(syncTarget, target);
+  writerCv.notify_one();
+  syncCv.wait_for(lock, std::chrono::seconds(1),
+                  [&] { return synced >= target; });
+}
+
+void BinaryLogListener::writeLoop() {
+  // Channel ids and the records not written yet belong to this thread
+  std::unordered_map<const char *, u32> channelIds;
+  std::vector<const char *> channelNames;
+  std::string pending;
+  u64 lastStamp = 0;
+  u64 reportedDropped = 0;
+  bool writing = false;
+
+  const auto encode = [&](Slot &slot) {
+    u32 channelId = 0;
+
+    if (slot.channel && *slot.channel) {
+      auto [it, inserted] = channelIds.try_emplace(
+          slot.channel, static_cast<u32>(channelNames.size() + 1));
+
+      if (inserted) {
+        channelNames.push_back(slot.channel);
+        encodeChannel(pending, it->second, slot.channel);
+      }
+
+      channelId = it->second;
+    }
+
+    if (!writing && pending.size() >= kMaxPendingSize) {
+      droppedCount++;
+      return;
+    }
+
+    encodeMessage(pending, slot.stamp, channelId, slot.level, slot.prefix,
+                  slot.text);
+    lastStamp = slot.stamp;
+  };
+
+  std::string logDir;
+  bool compressed = false;
+
+  // Every start gets a fresh file, the previous ones move down the list
+  auto rotate = [&] {
+    fs::remove_file(logFilePath(logDir, kMaxFiles - 1));
+
+    for (u32 i = kMaxFiles - 1; i > 0; i--) {
+      fs::rename(logFilePath(logDir, i - 1), logFilePath(logDir, i), true);
+    }
+  };
+
+  Output output;
+  u64 syncHandled = 0;
+
+  std::unique_lock lock(mutex);
+
+  while (true) {
+    const bool woken = writerCv.wait_for(lock, kFlushPeriod, [&] {
+      return (opened && !writing) || syncTarget > syncHandled ||
+             ring.claimed() - ring.consumed() >= kWakeInterval;
+    });
+
+    const u64 syncRequest = syncTarget;
+    const bool opening = opened && !writing;
+
+    if (opening) {
+      logDir = dir;
+      compressed = compress;
+    }
+
+    lock.unlock();
+
+    while (ring.pop(encode)) {
+    }
+
+    const u64 consumed = ring.consumed();
+
+    if (const u64 droppedNow = droppedCount; droppedNow != reportedDropped) {
+      encodeMessage(pending, lastStamp, 0, logs::level::warning, {},
+                    "Binary log: " +
+                        std::to_string(droppedNow - reportedDropped) +
+                        " messages dropped");
+      reportedDropped = droppedNow;
+    }
+
+    if (opening || (writing && output.size >= kMaxFileSize)) {
+      if (opening) {
+        fs::create_path(logDir);
+        writing = true;
+      }
+
+      output.close();
+      rotate();
+
+      // A new file has to define every channel the pending records use
+      if (output.open(logFilePath(logDir, 0), compressed)) {
+        std::string definitions;
+
+        for (u32 i = 0; i < channelNames.size(); i++) {
+          encodeChannel(definitions, i + 1, channelNames[i]);
+        }
+
+        output.write(definitions);
+      }
+    }
+
+    const bool syncing = syncRequest > syncHandled;
+
+    if (writing && !pending.empty() &&
+        (!woken || syncing || pending.size() >= kFlushSize)) {
+      output.write(pending);
+      pending.clear();
+    }
+
+    if (output.file && syncing) {
+      output.file.sync();
+    }
+
+    lock.lock();
+    syncHandled = syncRequest;
+
+    if (writing && pending.empty()) {
+      synced = consumed;
+      syncCv.notify_all();
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "log_ring.h"
+#include "util/logs.hpp"
+#include "util/types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+// logs::listener which keeps a compact binary copy of every message, see
+// binary_log_format.h. Emulator threads only copy the stamp, channel, level
+// and text into a lock-free ring like AndroidLogSink's; channel ids are
+// assigned and records encoded by a background writer thread. Each open()
+// starts a new RPCS3.blog under the directory, older files are renamed to
+// RPCS3.1.blog, RPCS3.2.blog... and a file is rotated the same way once it
+// grows past kMaxFileSize.
+//
+// Messages logged before open() are encoded in memory, so early boot output
+// ends up in the first file.
+class BinaryLogListener final : public logs::listener {
+public:
+  static constexpr u64 kMaxFileSize = 16 * 1024 * 1024;
+  static constexpr u32 kMaxFiles = 4;
+
+  // Messages in flight between the logging threads and the writer. When the
+  // writer falls this far behind, messages are dropped and counted
+  static constexpr usz kSlotCount = 8192;
+
+  // Records kept in memory while the writer was not opened
+  static constexpr usz kMaxPendingSize = 8 * 1024 * 1024;
+
+  BinaryLogListener();
+
+  BinaryLogListener(const BinaryLogListener &) = delete;
+  BinaryLogListener &operator=(const BinaryLogListener &) = delete;
+
+  void open(const std::string &dir, bool compress);
+
+  void log(u64 stamp, const logs::message &msg, const std::string &prefix,
+           const std::string &text) override;
+
+  // Waits until everything logged so far reached the file
+  void sync() override;
+
+  // Number of messages lost because the ring was full or the file was not
+  // opened in time
+  u64 dropped() const { return droppedCount.load(); }
+
+private:
+  struct Output;
+
+  struct Slot {
+    u64 stamp = 0;
+
+    // Channel names are static strings, they are compared by address
+    const char *channel = nullptr;
+    logs::level level{};
+    std::string prefix;
+    std::string text;
+  };
+
+  void writeLoop();
+
+  LogRing<Slot> ring{kSlotCount};
+  std::atomic<u64> droppedCount = 0;
+
+  // The writer sleeps on this between flushes, producers only notify it
+  // once per kWakeInterval messages
+  std::mutex mutex;
+  std::condition_variable writerCv;
+  std::condition_variable syncCv;
+
+  std::string dir;
+  bool compress = false;
+  bool opened = false;
+
+  // Ring positions below syncTarget have to reach the file, those below
+  // synced did
+  u64 syncTarget = 0;
+  u64 synced = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+// On-disk format of the binary log, shared with tools/log-decoder. It must
+// not depend on anything from rpcs3.
+//
+// A file starts with a FileHeader. The rest of the file is a stream of
+// records, deflated with zlib when kFlagCompressed is set. A record starts
+// with a RecordType byte:
+//
+//   channel: varint id, varint size, name
+//   message: varint stamp, varint channel id, u8 level,
+//            varint size, prefix, varint size, text
+//
+// Stamps are microseconds since the emulator started. Channel id 0 is
+// reserved for messages without a channel. Every file defines the channels
+// it uses before the first message referencing them.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace binlog {
+inline constexpr std::uint32_t kMagic = 0x474C4252; // "RBLG"
+inline constexpr std::uint32_t kVersion = 1;
+
+inline constexpr std::uint32_t kFlagCompressed = 1;
+
+struct FileHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t flags;
+};
+
+enum class RecordType : std::uint8_t {
+  channel = 0,
+  message = 1,
+};
+
+inline void putVarint(std::string &out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+
+  out += static_cast<char>(value);
+}
+
+inline void putString(std::string &out, std::string_view value) {
+  putVarint(out, value.size());
+  out += value;
+}
+
+// Reads from a byte range, every get() returns false once it is exhausted
+struct RecordReader {
+  const std::uint8_t *data;
+  std::size_t size;
+  std::size_t pos = 0;
+
+  bool getByte(std::uint8_t &value) {
+    if (pos >= size) {
+      return false;
+    }
+
+    value = data[pos++];
+    return true;
+  }
+
+  bool getVarint(std::uint64_t &value) {
+    value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      std::uint8_t byte;
+      if (!getByte(byte)) {
+        return false;
+      }
+
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool getString(std::string_view &value) {
+    std::uint64_t length;
+    if (!getVarint(length) || size - pos < length) {
+      return false;
+    }
+
+    value = {reinterpret_cast<const char *>(data + pos),
+             static_cast<std::size_t>(length)};
+    pos += length;
+    return true;
+  }
+};
+} // namespace binlog
@@ -0,0 +1,428 @@
+#include "boot_prefetch.h"
+
+#include "Utilities/File.h"
+#include "util/logs.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+LOG_CHANNEL(prefetch_log, "Prefetch");
+
+namespace {
+constexpr u32 kTraceMagic = 0x52544252; // "RBTR"
+constexpr u32 kTraceVersion = 1;
+
+// Holes up to this size are read along with their neighbours, a few more
+// pages are cheaper than another request to the storage
+constexpr u64 kMergeGap = 256 * 1024;
+
+bool isUnder(const std::string &path, const std::string &rootDir) {
+  if (!path.starts_with(rootDir)) {
+    return false;
+  }
+
+  return rootDir.ends_with('/') || path.size() == rootDir.size() ||
+         path[rootDir.size()] == '/';
+}
+
+void collectOpenFiles(const std::vector<std::string> &roots,
+                      std::vector<std::string> &files,
+                      std::unordered_set<std::string> &seen) {
+  DIR *dir = opendir("/proc/self/fd");
+  if (dir == nullptr) {
+    return;
+  }
+
+  char target[4096];
+
+  while (dirent *entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+
+    const std::string link = std::string("/proc/self/fd/") + entry->d_name;
+    const auto length = readlink(link.c_str(), target, sizeof(target) - 1);
+    if (length <= 0) {
+      continue;
+    }
+
+    std::string path(target, length);
+
+    if (seen.contains(path) ||
+        std::none_of(roots.begin(), roots.end(), [&](const std::string &root) {
+          return isUnder(path, root);
+        })) {
+      continue;
+    }
+
+    seen.insert(path);
+    files.push_back(std::move(path));
+  }
+
+  closedir(dir);
+}
+
+struct Writer {
+  std::string buffer;
+
+  template <typename T> void put(T value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  void put(const std::string &value) {
+    put<u32>(static_cast<u32>(value.size()));
+    buffer += value;
+  }
+};
+
+struct Reader {
+  const std::vector<u8> &data;
+  usz pos = 0;
+
+  template <typename T> bool get(T &value) {
+    if (data.size() - pos < sizeof(T)) {
+      return false;
+    }
+
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool get(std::string &value) {
+    u32 size;
+    if (!get(size) || data.size() - pos < size) {
+      return false;
+    }
+
+    value.assign(reinterpret_cast<const char *>(data.data() + pos), size);
+    pos += size;
+    return true;
+  }
+};
+} // namespace
+
+u64 BootTrace::totalBytes() const {
+  u64 result = 0;
+
+  for (auto &range : ranges) {
+    result += range.length;
+  }
+
+  return result;
+}
+
+void BootTrace::truncate(u64 maxBytes) {
+  u64 total = 0;
+
+  for (usz i = 0; i < ranges.size(); i++) {
+    if (ranges[i].length >= maxBytes - total) {
+      ranges[i].length = maxBytes - total;
+      ranges.resize(ranges[i].length == 0 ? i : i + 1);
+      return;
+    }
+
+    total += ranges[i].length;
+  }
+}
+
+std::optional<BootTrace> BootTrace::load(const std::string &path) {
+  fs::file file(path);
+  if (!file) {
+    return std::nullopt;
+  }
+
+  const auto data = file.to_vector<u8>();
+  Reader reader{data};
+
+  u32 magic = 0, version = 0, count = 0;
+  if (!reader.get(magic) || !reader.get(version) || !reader.get(count) ||
+      magic != kTraceMagic || version != kTraceVersion) {
+    prefetch_log.warning("Ignoring incompatible boot trace %s", path);
+    return std::nullopt;
+  }
+
+  // The count comes from the file, ranges are only added once they were read
+  BootTrace result;
+
+  for (u32 i = 0; i < count; i++) {
+    BootTrace::Range range;
+
+    if (!reader.get(range.path) || !reader.get(range.fileSize) ||
+        !reader.get(range.offset) || !reader.get(range.length)) {
+      prefetch_log.error("Boot trace %s is truncated", path);
+      return std::nullopt;
+    }
+
+    result.ranges.push_back(std::move(range));
+  }
+
+  return result;
+}
+
+bool BootTrace::save(const std::string &path) const {
+  Writer writer;
+  writer.put(kTraceMagic);
+  writer.put(kTraceVersion);
+  writer.put<u32>(static_cast<u32>(ranges.size()));
+
+  for (auto &range : ranges) {
+    writer.put(range.path);
+    writer.put(range.fileSize);
+    writer.put(range.offset);
+    writer.put(range.length);
+  }
+
+  fs::pending_file file(path);
+
+  if (!file.file ||
+      file.file.write(writer.buffer.data(), writer.buffer.size()) !=
+          writer.buffer.size() ||
+      !file.commit()) {
+    prefetch_log.error("Failed to write boot trace %s", path);
+    return false;
+  }
+
+  return true;
+}
+
+BootTraceRecorder::~BootTraceRecorder() { stop(); }
+
+void BootTraceRecorder::start(std::vector<std::string> roots,
+                              std::chrono::milliseconds window, DoneFn done) {
+  std::lock_guard lock(threadMutex);
+
+  if (thread.joinable()) {
+    stopRequested = true;
+    thread.join();
+  }
+
+  stopRequested = false;
+  thread = std::thread([this, roots = std::move(roots), window,
+                        done = std::move(done)]() mutable {
+    pthread_setname_np(pthread_self(), "Boot Recorder");
+    run(std::move(roots), window, std::move(done));
+  });
+}
+
+void BootTraceRecorder::stop() {
+  std::lock_guard lock(threadMutex);
+
+  if (thread.joinable()) {
+    stopRequested = true;
+    thread.join();
+  }
+}
+
+void BootTraceRecorder::addResidentRanges(const std::string &path,
+                                          BootTrace &trace) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    close(fd);
+    return;
+  }
+
+  const u64 size = st.st_size;
+  void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    return;
+  }
+
+  const u64 pageSize = sysconf(_SC_PAGESIZE);
+  const u64 pages = (size + pageSize - 1) / pageSize;
+  const u64 mergePages = kMergeGap / pageSize;
+  std::vector<unsigned char> resident(pages);
+
+  if (mincore(map, size, resident.data()) == 0) {
+    u64 page = 0;
+
+    while (page < pages) {
+      if ((resident[page] & 1) == 0) {
+        page++;
+        continue;
+      }
+
+      // Extend the run over resident pages and holes up to kMergeGap
+      u64 end = page + 1;
+      for (u64 next = end; next < pages && next - end <= mergePages; next++) {
+        if (resident[next] & 1) {
+          end = next + 1;
+        }
+      }
+
+      const u64 offset = page * pageSize;
+      trace.ranges.push_back({
+          .path = path,
+          .fileSize = size,
+          .offset = offset,
+          .length = std::min(end * pageSize, size) - offset,
+      });
+
+      page = end;
+    }
+  }
+
+  munmap(map, size);
+}
+
+void BootTraceRecorder::run(std::vector<std::string> roots,
+                            std::chrono::milliseconds window, DoneFn done) {
+  const auto deadline = std::chrono::steady_clock::now() + window;
+
+  // /proc/self/fd shows resolved paths
+  for (auto &root : roots) {
+    if (char *resolved = realpath(root.c_str(), nullptr)) {
+      root = resolved;
+      std::free(resolved);
+    }
+  }
+
+  std::vector<std::string> files;
+  std::unordered_set<std::string> seen;
+
+  // Most files are open for a short time only, the sampling has to be fast
+  // to catch them
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (stopRequested) {
+      return;
+    }
+
+    collectOpenFiles(roots, files, seen);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  BootTrace trace;
+
+  for (auto &file : files) {
+    BootTraceRecorder::addResidentRanges(file, trace);
+
+    if (trace.totalBytes() >= kMaxTraceBytes) {
+      trace.truncate(kMaxTraceBytes);
+      prefetch_log.warning("Boot trace truncated at %u MB",
+                           kMaxTraceBytes >> 20);
+      break;
+    }
+  }
+
+  prefetch_log.notice("Recorded boot trace: %u files, %u ranges, %u MB",
+                      files.size(), trace.ranges.size(),
+                      trace.totalBytes() >> 20);
+
+  done(std::move(trace));
+}
+
+BootPrefetcher::~BootPrefetcher() { stop(); }
+
+void BootPrefetcher::start(BootTrace trace, u32 threadCount) {
+  stop();
+
+  std::lock_guard lock(threadMutex);
+  current = std::move(trace);
+  nextRange = 0;
+  stopRequested = false;
+  prefetchedRanges = 0;
+  prefetchedBytes = 0;
+  startTime = std::chrono::steady_clock::now();
+  threadCount = std::max(threadCount, 1u);
+  activeWorkers = threadCount;
+
+  for (u32 i = 0; i < threadCount; i++) {
+    threads.emplace_back([this] {
+      pthread_setname_np(pthread_self(), "Boot Prefetch");
+      work();
+    });
+  }
+}
+
+void BootPrefetcher::stop() {
+  std::lock_guard lock(threadMutex);
+  stopRequested = true;
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  threads.clear();
+}
+
+BootPrefetcher::Stats BootPrefetcher::wait() {
+  std::lock_guard lock(threadMutex);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  threads.clear();
+
+  return {
+      .ranges = prefetchedRanges,
+      .bytes = prefetchedBytes,
+      .seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() -
+                                            startTime)
+                     .count(),
+  };
+}
+
+void BootPrefetcher::work() {
+  while (!stopRequested) {
+    const usz index = nextRange++;
+    if (index >= current.ranges.size()) {
+      break;
+    }
+
+    if (prefetch(current.ranges[index])) {
+      prefetchedRanges++;
+    }
+  }
+
+  if (--activeWorkers == 0 && !stopRequested) {
+    prefetch_log.notice(
+        "Prefetched %u of %u ranges, %u MB in %.2f s", prefetchedRanges,
+        current.ranges.size(), prefetchedBytes >> 20,
+        std::chrono::duration<f64>(std::chrono::steady_clock::now() -
+                                   startTime)
+            .count());
+  }
+}
+
+bool BootPrefetcher::prefetch(const BootTrace::Range &range) {
+  const int fd = open(range.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  // A changed file most likely moved its data around
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<u64>(st.st_size) != range.fileSize) {
+    close(fd);
+    return false;
+  }
+
+  for (u64 done = 0; done < range.length && !stopRequested;
+       done += kChunkSize) {
+    const u64 length = std::min(kChunkSize, range.length - done);
+
+    // Blocks until the pages were read, so the chunks keep the queue of the
+    // storage busy without flooding it
+    readahead(fd, range.offset + done, length);
+    prefetchedBytes += length;
+  }
+
+  close(fd);
+  return true;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// File ranges a title read during its first seconds of boot, in the order
+// the files were opened. See BootTraceRecorder and BootPrefetcher.
+struct BootTrace {
+  struct Range {
+    std::string path;
+
+    // Size of the file when it was recorded, the range is skipped once the
+    // file changed
+    u64 fileSize = 0;
+
+    u64 offset = 0;
+    u64 length = 0;
+  };
+
+  std::vector<Range> ranges;
+
+  u64 totalBytes() const;
+
+  // Drops what lies past maxBytes, the last range kept is shortened
+  void truncate(u64 maxBytes);
+
+  static std::optional<BootTrace> load(const std::string &path);
+  bool save(const std::string &path) const;
+};
+
+// Learns what a boot reads without a hook in the VFS: /proc/self/fd is
+// sampled for files under the given roots while the window lasts, then the
+// page cache residency of every file seen (mincore) tells which ranges were
+// read. Pages which were cached before the boot are included as well, they
+// are cheap to prefetch again.
+//
+// A trace is only as good as the cache was cold: pages another reader left
+// behind, e.g. the installation which just wrote the title, look like boot
+// reads. Traces are therefore recorded again once they are old, see
+// kMaxTraceAge.
+class BootTraceRecorder {
+public:
+  using DoneFn = std::function<void(BootTrace)>;
+
+  // Upper bound for the bytes one trace may prefetch
+  static constexpr u64 kMaxTraceBytes = 512 * 1024 * 1024;
+
+  // Age after which a trace is recorded again from what is hopefully a colder
+  // cache
+  static constexpr std::chrono::hours kMaxTraceAge{7 * 24};
+
+  ~BootTraceRecorder();
+
+  void start(std::vector<std::string> roots, std::chrono::milliseconds window,
+             DoneFn done);
+
+  // Abandons a recording in progress, done is not called
+  void stop();
+
+  // Turns the residency of one file into ranges, exposed for tests
+  static void addResidentRanges(const std::string &path, BootTrace &trace);
+
+private:
+  void run(std::vector<std::string> roots, std::chrono::milliseconds window,
+           DoneFn done);
+
+  std::mutex threadMutex;
+  std::thread thread;
+  std::atomic<bool> stopRequested = false;
+};
+
+// Replays a BootTrace with readahead() on a few threads, in parallel with
+// the emulator loading the title, so the reads it issues later hit the
+// page cache.
+class BootPrefetcher {
+public:
+  struct Stats {
+    // Ranges whose file was unchanged, skipped ones are not counted
+    u64 ranges = 0;
+    u64 bytes = 0;
+    f64 seconds = 0;
+  };
+
+  // Prefetched in steps of this, so stop() does not wait for a large file
+  static constexpr u64 kChunkSize = 4 * 1024 * 1024;
+
+  ~BootPrefetcher();
+
+  void start(BootTrace trace, u32 threadCount);
+  void stop();
+
+  // Waits until every range was prefetched
+  Stats wait();
+
+private:
+  void work();
+  bool prefetch(const BootTrace::Range &range);
+
+  std::mutex threadMutex;
+  std::vector<std::thread> threads;
+  BootTrace current;
+  std::atomic<usz> nextRange = 0;
+  std::atomic<bool> stopRequested = false;
+  std::atomic<u32> activeWorkers = 0;
+  std::atomic<u64> prefetchedRanges = 0;
+  std::atomic<u64> prefetchedBytes = 0;
+  std::chrono::steady_clock::time_point startTime;
+};
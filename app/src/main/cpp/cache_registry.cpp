@@ -0,0 +1,155 @@
+#include "cache_registry.h"
+
+#include "proc_stats.h"
+#include "util/logs.hpp"
+
+#include <algorithm>
+#include <malloc.h>
+
+LOG_CHANNEL(memory_log, "Memory");
+
+namespace {
+// Share of the estimated cache size each level asks for. Background levels
+// matter most, the process is the next candidate for the low memory killer
+constexpr std::array<f64, kTrimLevelCount> kTrimShare = {
+    0.25, // runningModerate
+    0.5,  // runningLow
+    1.0,  // runningCritical
+    0.25, // uiHidden
+    0.5,  // background
+    0.75, // moderate
+    1.0,  // complete
+};
+
+void releaseFreeHeap() {
+#ifdef __ANDROID__
+  // Scudo and jemalloc both return their free pages on M_PURGE
+  mallopt(M_PURGE, 0);
+#else
+  malloc_trim(0);
+#endif
+}
+} // namespace
+
+std::optional<TrimLevel> trimLevelFromAndroid(int level) {
+  constexpr std::pair<int, TrimLevel> kLevels[] = {
+      {80, TrimLevel::complete},        {60, TrimLevel::moderate},
+      {40, TrimLevel::background},      {20, TrimLevel::uiHidden},
+      {15, TrimLevel::runningCritical}, {10, TrimLevel::runningLow},
+      {5, TrimLevel::runningModerate},
+  };
+
+  for (auto [value, result] : kLevels) {
+    if (level >= value) {
+      return result;
+    }
+  }
+
+  return std::nullopt;
+}
+
+const char *trimLevelName(TrimLevel level) {
+  switch (level) {
+  case TrimLevel::runningModerate:
+    return "running moderate";
+  case TrimLevel::runningLow:
+    return "running low";
+  case TrimLevel::runningCritical:
+    return "running critical";
+  case TrimLevel::uiHidden:
+    return "UI hidden";
+  case TrimLevel::background:
+    return "background";
+  case TrimLevel::moderate:
+    return "moderate";
+  case TrimLevel::complete:
+    break;
+  }
+
+  return "complete";
+}
+
+u32 CacheRegistry::add(std::string name, u32 priority, SizeFn size,
+                       ReclaimFn reclaim) {
+  std::lock_guard lock(mutex);
+  const u32 id = nextId++;
+
+  // Kept sorted, equal priorities in registration order
+  const auto pos = std::upper_bound(
+      entries.begin(), entries.end(), priority,
+      [](u32 value, const Entry &entry) { return value < entry.priority; });
+
+  entries.insert(pos, Entry{id, priority, std::move(name), std::move(size),
+                            std::move(reclaim)});
+  return id;
+}
+
+void CacheRegistry::remove(u32 id) {
+  std::lock_guard lock(mutex);
+  std::erase_if(entries, [id](const Entry &entry) { return entry.id == id; });
+}
+
+CacheRegistry::Report CacheRegistry::trim(TrimLevel level) {
+  std::lock_guard lock(mutex);
+  Report report;
+  report.rssBeforeKb = readProcessMemoryKb("VmRSS:");
+
+  std::vector<u64> sizes;
+  sizes.reserve(entries.size());
+
+  for (auto &entry : entries) {
+    sizes.push_back(entry.size());
+    report.estimated += sizes.back();
+  }
+
+  report.requested = static_cast<u64>(
+      static_cast<f64>(report.estimated) * kTrimShare[static_cast<usz>(level)]);
+
+  for (usz i = 0; i < entries.size(); i++) {
+    if (report.reclaimed >= report.requested) {
+      break;
+    }
+
+    if (sizes[i] == 0) {
+      continue;
+    }
+
+    const u64 wanted = std::min(sizes[i], report.requested - report.reclaimed);
+    const u64 freed = entries[i].reclaim(wanted);
+
+    memory_log.notice("Trimmed %s: %u of %u bytes", entries[i].name, freed,
+                      wanted);
+
+    report.reclaimed += freed;
+    report.cachesTrimmed++;
+  }
+
+  releaseFreeHeap();
+
+  report.rssAfterKb = readProcessMemoryKb("VmRSS:");
+  reclaimed[static_cast<usz>(level)] += report.reclaimed;
+
+  memory_log.warning("Trim %s: reclaimed %u of %u bytes requested from %u "
+                     "caches, RSS %u -> %u kB",
+                     trimLevelName(level), report.reclaimed, report.requested,
+                     report.cachesTrimmed, report.rssBeforeKb,
+                     report.rssAfterKb);
+
+  return report;
+}
+
+u64 CacheRegistry::estimatedSize() const {
+  std::lock_guard lock(mutex);
+  u64 result = 0;
+
+  for (auto &entry : entries) {
+    result += entry.size();
+  }
+
+  return result;
+}
+
+std::array<u64, kTrimLevelCount> CacheRegistry::reclaimedPerLevel() const {
+  std::lock_guard lock(mutex);
+  return reclaimed;
+}
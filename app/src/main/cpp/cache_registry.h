@@ -0,0 +1,83 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Android ComponentCallbacks2 trim levels, in the order they are defined
+enum class TrimLevel : u8 {
+  runningModerate,
+  runningLow,
+  runningCritical,
+  uiHidden,
+  background,
+  moderate,
+  complete,
+};
+
+inline constexpr usz kTrimLevelCount = 7;
+
+// Maps the value passed to onTrimMemory() to the closest level below it,
+// nothing for values below TRIM_MEMORY_RUNNING_MODERATE
+std::optional<TrimLevel> trimLevelFromAndroid(int level);
+
+const char *trimLevelName(TrimLevel level);
+
+// Caches which can give memory back when Android is short of it. Each cache
+// registers a size estimate and a reclaim callback with a priority, a trim
+// asks the caches in ascending priority to free part of their memory until
+// the share of the total which the level calls for was reclaimed. Free heap
+// pages are returned to the system afterwards.
+//
+// Callbacks run with the registry locked and must not call into it, after
+// remove() returned the callbacks of that cache are never called again.
+class CacheRegistry {
+public:
+  // Bytes the cache could free right now
+  using SizeFn = std::function<u64()>;
+
+  // Frees about the given number of bytes, returns how many were freed. Caches
+  // which only stop growing (install staging) return 0, the memory they give
+  // back once the work in flight finished is not counted as reclaimed
+  using ReclaimFn = std::function<u64(u64 bytes)>;
+
+  struct Report {
+    u64 estimated = 0;
+    u64 requested = 0;
+    u64 reclaimed = 0;
+    u32 cachesTrimmed = 0;
+    u64 rssBeforeKb = 0;
+    u64 rssAfterKb = 0;
+  };
+
+  // Lower priorities are reclaimed first, use them for caches which are
+  // cheap to rebuild
+  u32 add(std::string name, u32 priority, SizeFn size, ReclaimFn reclaim);
+  void remove(u32 id);
+
+  Report trim(TrimLevel level);
+
+  u64 estimatedSize() const;
+
+  // Bytes reclaimed so far, indexed by TrimLevel
+  std::array<u64, kTrimLevelCount> reclaimedPerLevel() const;
+
+private:
+  struct Entry {
+    u32 id;
+    u32 priority;
+    std::string name;
+    SizeFn size;
+    ReclaimFn reclaim;
+  };
+
+  mutable std::mutex mutex;
+  std::vector<Entry> entries;
+  u32 nextId = 1;
+  std::array<u64, kTrimLevelCount> reclaimed{};
+};
@@ -0,0 +1,147 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <string_view>
+
+namespace {
+u64 readNumber(const std::string &path) {
+  std::ifstream stream(path);
+  u64 value = 0;
+
+  if (!(stream >> value)) {
+    return 0;
+  }
+
+  return value;
+}
+
+bool parseCpuId(std::string_view name, u32 &id) {
+  if (!name.starts_with("cpu") || name.size() == 3) {
+    return false;
+  }
+
+  u32 result = 0;
+  for (char c : name.substr(3)) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+
+    result = result * 10 + (c - '0');
+  }
+
+  id = result;
+  return true;
+}
+} // namespace
+
+u64 CpuCluster::mask() const {
+  u64 result = 0;
+
+  for (u32 cpu : cpus) {
+    // Affinity masks are 64 bit, no phone comes close
+    if (cpu < 64) {
+      result |= u64{1} << cpu;
+    }
+  }
+
+  return result;
+}
+
+CpuTopology CpuTopology::detect(const std::string &sysfsRoot) {
+  CpuTopology result;
+
+  DIR *dir = opendir(sysfsRoot.c_str());
+  if (dir == nullptr) {
+    return result;
+  }
+
+  std::vector<CpuCluster> cores;
+
+  while (dirent *entry = readdir(dir)) {
+    u32 id;
+    if (!parseCpuId(entry->d_name, id)) {
+      continue;
+    }
+
+    const std::string cpuDir = sysfsRoot + "/" + entry->d_name;
+
+    CpuCluster core;
+    core.cpus.push_back(id);
+    core.capacity = static_cast<u32>(readNumber(cpuDir + "/cpu_capacity"));
+    core.maxFreqKhz = readNumber(cpuDir + "/cpufreq/cpuinfo_max_freq");
+    cores.push_back(std::move(core));
+  }
+
+  closedir(dir);
+
+  // Offline cores are kept, they come back once the SoC cools down and the
+  // kernel only requires one online core in an affinity mask
+  std::sort(cores.begin(), cores.end(),
+            [](const CpuCluster &lhs, const CpuCluster &rhs) {
+              if (lhs.capacity != rhs.capacity) {
+                return lhs.capacity < rhs.capacity;
+              }
+
+              if (lhs.maxFreqKhz != rhs.maxFreqKhz) {
+                return lhs.maxFreqKhz < rhs.maxFreqKhz;
+              }
+
+              return lhs.cpus[0] < rhs.cpus[0];
+            });
+
+  for (auto &core : cores) {
+    auto &clusters = result.clusterList;
+
+    if (!clusters.empty() && clusters.back().capacity == core.capacity &&
+        clusters.back().maxFreqKhz == core.maxFreqKhz) {
+      clusters.back().cpus.push_back(core.cpus[0]);
+    } else {
+      clusters.push_back(std::move(core));
+    }
+  }
+
+  return result;
+}
+
+u32 CpuTopology::cpuCount() const {
+  u32 result = 0;
+
+  for (auto &cluster : clusterList) {
+    result += static_cast<u32>(cluster.cpus.size());
+  }
+
+  return result;
+}
+
+u64 CpuTopology::mask() const {
+  u64 result = 0;
+
+  for (auto &cluster : clusterList) {
+    result |= cluster.mask();
+  }
+
+  return result;
+}
+
+std::string CpuTopology::toString() const {
+  if (clusterList.empty()) {
+    return "unknown";
+  }
+
+  std::string result;
+
+  for (auto &cluster : clusterList) {
+    if (!result.empty()) {
+      result += ", ";
+    }
+
+    result += std::to_string(cluster.cpus.size()) + "x cap " +
+              std::to_string(cluster.capacity) + " " +
+              std::to_string(cluster.maxFreqKhz / 1000) + " MHz";
+  }
+
+  return result;
+}
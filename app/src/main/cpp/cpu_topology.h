@@ -0,0 +1,44 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <string>
+#include <vector>
+
+// Cores which share capacity and maximum frequency, usually one cpufreq
+// policy. Android SoCs have two or three of them, e.g. 4 little, 3 big and
+// 1 prime core.
+struct CpuCluster {
+  std::vector<u32> cpus;
+
+  // cpu_capacity, the kernel scales it to 1024 for the fastest core. Zero
+  // when the kernel does not export it
+  u32 capacity = 0;
+
+  // cpufreq/cpuinfo_max_freq, zero when unknown
+  u64 maxFreqKhz = 0;
+
+  u64 mask() const;
+};
+
+class CpuTopology {
+public:
+  static constexpr const char *kDefaultSysfsRoot = "/sys/devices/system/cpu";
+
+  // Reads cpuN/cpu_capacity and cpuN/cpufreq/cpuinfo_max_freq below
+  // sysfsRoot. Tests point it at a fake tree
+  static CpuTopology detect(const std::string &sysfsRoot = kDefaultSysfsRoot);
+
+  // Slowest cluster first, empty when sysfs could not be read
+  const std::vector<CpuCluster> &clusters() const { return clusterList; }
+
+  bool isHeterogeneous() const { return clusterList.size() > 1; }
+  u32 cpuCount() const;
+  u64 mask() const;
+
+  // E.g. "4x cap 325 1800 MHz, 3x cap 870 2400 MHz, 1x cap 1024 3000 MHz"
+  std::string toString() const;
+
+private:
+  std::vector<CpuCluster> clusterList;
+};
@@ -0,0 +1,366 @@
+#include "disc_image.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+static_assert(std::endian::native == std::endian::little,
+              "The image format is little endian");
+
+namespace {
+// Longer names do not exist on a disc
+constexpr std::uint32_t kMaxNameSize = 1024;
+
+bool readAt(int fd, std::uint64_t offset, void *buffer, std::uint64_t size) {
+  auto *out = static_cast<std::uint8_t *>(buffer);
+
+  while (size != 0) {
+    const ssize_t result = ::pread(fd, out, size, offset);
+    if (result <= 0) {
+      return false;
+    }
+
+    out += result;
+    offset += result;
+    size -= result;
+  }
+
+  return true;
+}
+
+std::uint64_t steadyClockNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+} // namespace
+
+std::shared_ptr<DiscImage> DiscImage::open(const std::string &path,
+                                           std::size_t cacheBytes,
+                                           std::string *error) {
+  std::shared_ptr<DiscImage> image(new DiscImage());
+  std::string reason;
+
+  if (!image->load(path, cacheBytes, reason)) {
+    if (error != nullptr) {
+      *error = std::move(reason);
+    }
+
+    return nullptr;
+  }
+
+  return image;
+}
+
+DiscImage::~DiscImage() {
+  if (indexMapping != nullptr) {
+    ::munmap(indexMapping, indexMappingSize);
+  }
+
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+bool DiscImage::load(const std::string &path, std::size_t cacheBytes,
+                     std::string &error) {
+  fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = "cannot open file";
+    return false;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    error = "cannot stat file";
+    return false;
+  }
+
+  fileSize = info.st_size;
+  modified = info.st_mtime;
+
+  if (!readAt(fd, 0, &header, sizeof(header))) {
+    error = "file is too small";
+    return false;
+  }
+
+  if (header.magic != discimg::kMagic || header.version != discimg::kVersion) {
+    error = "not a disc image or unsupported version";
+    return false;
+  }
+
+  // The block count is checked against the data size, which must not wrap
+  // when rounded up to whole blocks
+  if (header.blockSize < discimg::kMinBlockSize ||
+      header.blockSize > discimg::kMaxBlockSize ||
+      header.dataSize > UINT64_MAX - header.blockSize) {
+    error = "corrupted header";
+    return false;
+  }
+
+  const std::uint64_t indexSize = (header.blockCount + 1) * 8;
+
+  if (header.blockCount !=
+          discimg::blockCountFor(header.dataSize, header.blockSize) ||
+      header.indexOffset % 8 != 0 || header.indexOffset > fileSize ||
+      indexSize > fileSize - header.indexOffset ||
+      header.tableOffset > fileSize ||
+      header.tableSize > fileSize - header.tableOffset) {
+    error = "corrupted header";
+    return false;
+  }
+
+  // The index is only touched where blocks are read, there is no need to
+  // load all of it for a large image
+  const std::uint64_t pageSize = ::sysconf(_SC_PAGESIZE);
+  const std::uint64_t mapOffset = header.indexOffset / pageSize * pageSize;
+  indexMappingSize = header.indexOffset - mapOffset + indexSize;
+  indexMapping = ::mmap(nullptr, indexMappingSize, PROT_READ, MAP_SHARED, fd,
+                        mapOffset);
+
+  if (indexMapping == MAP_FAILED) {
+    indexMapping = nullptr;
+    error = "cannot map the block index";
+    return false;
+  }
+
+  blockIndex = reinterpret_cast<const std::uint64_t *>(
+      static_cast<const std::uint8_t *>(indexMapping) + header.indexOffset -
+      mapOffset);
+
+  if (blockIndex[0] < sizeof(header) ||
+      blockIndex[header.blockCount] > header.indexOffset) {
+    error = "corrupted block index";
+    return false;
+  }
+
+  std::vector<std::uint8_t> table(header.tableSize);
+  if (!readAt(fd, header.tableOffset, table.data(), table.size())) {
+    error = "cannot read the file table";
+    return false;
+  }
+
+  // Every record takes at least its fixed part, a count which cannot fit
+  // the table would only make the reserve below fail
+  if (std::uint64_t{header.fileCount} * sizeof(discimg::FileRecord) >
+      header.tableSize) {
+    error = "truncated file table";
+    return false;
+  }
+
+  std::size_t pos = 0;
+  fileTable.reserve(header.fileCount);
+
+  for (std::uint32_t i = 0; i < header.fileCount; i++) {
+    discimg::FileRecord record;
+    if (table.size() - pos < sizeof(record)) {
+      error = "truncated file table";
+      return false;
+    }
+
+    std::memcpy(&record, table.data() + pos, sizeof(record));
+    pos += sizeof(record);
+
+    if (record.nameSize == 0 || record.nameSize > kMaxNameSize ||
+        table.size() - pos < record.nameSize) {
+      error = "invalid name in the file table";
+      return false;
+    }
+
+    const bool directory = (record.flags & discimg::kFlagDirectory) != 0;
+
+    if (!directory && (record.offset > header.dataSize ||
+                       record.size > header.dataSize - record.offset)) {
+      error = "file outside of the data stream";
+      return false;
+    }
+
+    fileTable.push_back({
+        .name = std::string(reinterpret_cast<const char *>(&table[pos]),
+                            record.nameSize),
+        .offset = record.offset,
+        .size = directory ? 0 : record.size,
+        .directory = directory,
+    });
+
+    pos += record.nameSize;
+  }
+
+  cacheCapacity = std::max<std::size_t>(cacheBytes / header.blockSize, 1);
+  return true;
+}
+
+std::uint64_t DiscImage::blockLength(std::uint64_t index) const {
+  const std::uint64_t start = index * header.blockSize;
+  return std::min<std::uint64_t>(header.blockSize, header.dataSize - start);
+}
+
+bool DiscImage::loadBlock(std::uint64_t index, std::uint8_t *out) {
+  const std::uint64_t begin = blockIndex[index];
+  const std::uint64_t end = blockIndex[index + 1];
+  const std::uint64_t length = blockLength(index);
+
+  if (end < begin || end > header.indexOffset ||
+      end - begin > compressBound(length)) {
+    return false;
+  }
+
+  const std::uint64_t stored = end - begin;
+  compressedBytes += stored;
+  cacheMisses++;
+
+  if (stored == length) {
+    return readAt(fd, begin, out, length);
+  }
+
+  thread_local std::vector<std::uint8_t> compressed;
+  compressed.resize(stored);
+
+  if (!readAt(fd, begin, compressed.data(), stored)) {
+    return false;
+  }
+
+  const std::uint64_t start = steadyClockNs();
+  uLongf outLength = length;
+  const int result = uncompress(out, &outLength, compressed.data(),
+                                static_cast<uLong>(stored));
+  inflateNs += steadyClockNs() - start;
+
+  return result == Z_OK && outLength == length;
+}
+
+std::shared_ptr<const std::vector<std::uint8_t>>
+DiscImage::cachedBlock(std::uint64_t index) {
+  std::lock_guard lock(cacheMutex);
+
+  const auto it = cached.find(index);
+  if (it == cached.end()) {
+    return nullptr;
+  }
+
+  lru.splice(lru.begin(), lru, it->second);
+  cacheHits++;
+  return it->second->data;
+}
+
+std::shared_ptr<const std::vector<std::uint8_t>>
+DiscImage::block(std::uint64_t index) {
+  if (auto data = cachedBlock(index)) {
+    return data;
+  }
+
+  // Decompressed outside of the lock, two readers missing the same block
+  // both decompress it and the second result is dropped
+  auto data = std::make_shared<std::vector<std::uint8_t>>(blockLength(index));
+  if (!loadBlock(index, data->data())) {
+    return nullptr;
+  }
+
+  std::lock_guard lock(cacheMutex);
+
+  if (!cached.contains(index)) {
+    lru.push_front({index, data});
+    cached.emplace(index, lru.begin());
+    cachedBytes += data->size();
+
+    if (lru.size() > cacheCapacity) {
+      cachedBytes -= lru.back().data->size();
+      cached.erase(lru.back().index);
+      lru.pop_back();
+    }
+  }
+
+  return data;
+}
+
+std::uint64_t DiscImage::read(const File &file, std::uint64_t offset,
+                              void *buffer, std::uint64_t size) {
+  if (file.directory || offset >= file.size) {
+    return 0;
+  }
+
+  size = std::min(size, file.size - offset);
+
+  auto *out = static_cast<std::uint8_t *>(buffer);
+  const std::uint64_t start = file.offset + offset;
+  const std::uint64_t end = start + size;
+  std::uint64_t pos = start;
+
+  while (pos < end) {
+    const std::uint64_t index = pos / header.blockSize;
+    const std::uint64_t blockStart = index * header.blockSize;
+    const std::uint64_t length = blockLength(index);
+    const std::uint64_t count = std::min(end, blockStart + length) - pos;
+
+    // Large sequential reads decompress whole blocks in place, caching them
+    // would only evict the small blocks which are read repeatedly
+    if (pos == blockStart && count == length) {
+      if (auto data = cachedBlock(index)) {
+        std::memcpy(out + (pos - start), data->data(), count);
+      } else if (!loadBlock(index, out + (pos - start))) {
+        break;
+      }
+
+      pos += count;
+      continue;
+    }
+
+    const auto data = block(index);
+    if (!data) {
+      break;
+    }
+
+    std::memcpy(out + (pos - start), data->data() + (pos - blockStart), count);
+    pos += count;
+  }
+
+  reads++;
+  bytesRead += pos - start;
+  return pos - start;
+}
+
+DiscImage::Stats DiscImage::stats() const {
+  return {
+      .reads = reads,
+      .bytesRead = bytesRead,
+      .cacheHits = cacheHits,
+      .cacheMisses = cacheMisses,
+      .compressedBytes = compressedBytes,
+      .inflateNs = inflateNs,
+  };
+}
+
+void DiscImage::resetStats() {
+  reads = 0;
+  bytesRead = 0;
+  cacheHits = 0;
+  cacheMisses = 0;
+  compressedBytes = 0;
+  inflateNs = 0;
+}
+
+std::uint64_t DiscImage::cacheMemory() const {
+  std::lock_guard lock(cacheMutex);
+  return cachedBytes;
+}
+
+std::uint64_t DiscImage::trimCache(std::uint64_t bytes) {
+  std::lock_guard lock(cacheMutex);
+  std::uint64_t freed = 0;
+
+  // Readers may still hold a block, its memory is freed once they are done
+  while (freed < bytes && !lru.empty()) {
+    freed += lru.back().data->size();
+    cached.erase(lru.back().index);
+    lru.pop_back();
+  }
+
+  cachedBytes -= freed;
+  return freed;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "disc_image_format.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Random access to compressed disc images, see disc_image_format.h. Shared
+// with tools/disc-image, so it only depends on the standard library, POSIX
+// and zlib. The block index is mapped and used in place, decompressed blocks
+// are kept in an LRU cache. Reads are thread safe.
+class DiscImage {
+public:
+  struct File {
+    std::string name;
+
+    // In the data stream
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+
+    bool directory = false;
+  };
+
+  struct Stats {
+    std::uint64_t reads = 0;
+    std::uint64_t bytesRead = 0;
+    std::uint64_t cacheHits = 0;
+
+    // Blocks decompressed, whole blocks read straight into the caller's
+    // buffer are counted as well
+    std::uint64_t cacheMisses = 0;
+
+    // Read from the image file
+    std::uint64_t compressedBytes = 0;
+    std::uint64_t inflateNs = 0;
+  };
+
+  static constexpr std::size_t kDefaultCacheBytes = 32 * 1024 * 1024;
+
+  // Returns nullptr and sets error when the image cannot be used
+  static std::shared_ptr<DiscImage>
+  open(const std::string &path, std::size_t cacheBytes = kDefaultCacheBytes,
+       std::string *error = nullptr);
+
+  ~DiscImage();
+
+  DiscImage(const DiscImage &) = delete;
+  DiscImage &operator=(const DiscImage &) = delete;
+
+  const std::vector<File> &files() const { return fileTable; }
+  std::uint32_t blockSize() const { return header.blockSize; }
+  std::uint64_t dataSize() const { return header.dataSize; }
+  std::int64_t mtime() const { return modified; }
+
+  // Reads up to size bytes of file at offset, returns the bytes read
+  std::uint64_t read(const File &file, std::uint64_t offset, void *buffer,
+                     std::uint64_t size);
+
+  Stats stats() const;
+  void resetStats();
+
+  // Bytes held by the cached blocks
+  std::uint64_t cacheMemory() const;
+
+  // Drops the least recently used blocks until about bytes were freed,
+  // returns the bytes freed
+  std::uint64_t trimCache(std::uint64_t bytes);
+
+private:
+  DiscImage() = default;
+
+  bool load(const std::string &path, std::size_t cacheBytes,
+            std::string &error);
+
+  // Decompresses block index into out, which holds the whole block
+  bool loadBlock(std::uint64_t index, std::uint8_t *out);
+
+  std::uint64_t blockLength(std::uint64_t index) const;
+
+  std::shared_ptr<const std::vector<std::uint8_t>>
+  cachedBlock(std::uint64_t index);
+
+  // Decompressed block, from the cache when possible
+  std::shared_ptr<const std::vector<std::uint8_t>> block(std::uint64_t index);
+
+  int fd = -1;
+  std::uint64_t fileSize = 0;
+  std::int64_t modified = 0;
+  discimg::Header header{};
+  std::vector<File> fileTable;
+
+  void *indexMapping = nullptr;
+  std::size_t indexMappingSize = 0;
+  const std::uint64_t *blockIndex = nullptr;
+
+  struct CachedBlock {
+    std::uint64_t index;
+    std::shared_ptr<const std::vector<std::uint8_t>> data;
+  };
+
+  mutable std::mutex cacheMutex;
+  std::size_t cacheCapacity = 1;
+  std::list<CachedBlock> lru;
+  std::uint64_t cachedBytes = 0;
+  std::unordered_map<std::uint64_t, std::list<CachedBlock>::iterator> cached;
+
+  std::atomic<std::uint64_t> reads = 0;
+  std::atomic<std::uint64_t> bytesRead = 0;
+  std::atomic<std::uint64_t> cacheHits = 0;
+  std::atomic<std::uint64_t> cacheMisses = 0;
+  std::atomic<std::uint64_t> compressedBytes = 0;
+  std::atomic<std::uint64_t> inflateNs = 0;
+};
@@ -0,0 +1,21 @@
+#include "disc_image_device.h"
+
+DiscImageDevice::DiscImageDevice(std::shared_ptr<DiscImage> image)
+    : disc(std::move(image)) {
+  std::vector<Entry> entries;
+  entries.reserve(disc->files().size());
+
+  for (auto &file : disc->files()) {
+    entries.push_back({
+        .name = file.name,
+        .size = file.size,
+        .directory = file.directory,
+    });
+  }
+
+  build(entries, disc->mtime());
+}
+
+u64 DiscImageDevice::read(usz entry, u64 offset, void *buffer, u64 size) {
+  return disc->read(disc->files()[entry], offset, buffer, size);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "archive_device.h"
+#include "disc_image.h"
+
+#include <memory>
+
+// Exposes a compressed disc image (see DiscImage) as a read-only VFS device.
+// A disc dump has PS3_DISC.SFB and PS3_GAME at its root, so the root boots
+// like the folder it was converted from.
+class DiscImageDevice final : public ArchiveDevice {
+public:
+  explicit DiscImageDevice(std::shared_ptr<DiscImage> image);
+
+  const std::shared_ptr<DiscImage> &image() const { return disc; }
+
+  u64 read(usz entry, u64 offset, void *buffer, u64 size) override;
+
+private:
+  std::shared_ptr<DiscImage> disc;
+};
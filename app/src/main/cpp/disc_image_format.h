@@ -0,0 +1,66 @@
+#pragma once
+
+// On-disk format of compressed disc images (.rdim), shared with
+// tools/disc-image. It must not depend on anything from rpcs3.
+//
+// An image holds the file tree of a disc or game folder. The contents of
+// all files are concatenated into one data stream, which is cut into
+// blocks of blockSize bytes, the last one may be shorter. Every block is
+// deflated on its own with zlib, or stored as is when that does not make it
+// smaller, so any block can be read without the others.
+//
+//   Header      at 0
+//   blocks      compressed data, in order
+//   block index blockCount + 1 u64 file offsets at indexOffset, 8 byte
+//               aligned so it can be mapped and used in place. Block i
+//               spans [index[i], index[i + 1]), it is stored as is when
+//               that is its uncompressed size
+//   file table  fileCount FileRecords at tableOffset, each followed by
+//               nameSize bytes of name
+//
+// Names are paths relative to the image root separated by '/'. Files are
+// stored at offset in the data stream. All values are little endian.
+
+#include <cstdint>
+
+namespace discimg {
+inline constexpr std::uint32_t kMagic = 0x4D494452; // "RDIM"
+inline constexpr std::uint32_t kVersion = 1;
+
+inline constexpr std::uint32_t kDefaultBlockSize = 64 * 1024;
+inline constexpr std::uint32_t kMinBlockSize = 4 * 1024;
+inline constexpr std::uint32_t kMaxBlockSize = 1024 * 1024;
+
+inline constexpr std::uint32_t kFlagDirectory = 1;
+
+inline constexpr char kExtension[] = ".rdim";
+
+struct Header {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t blockSize;
+  std::uint32_t fileCount;
+  std::uint64_t dataSize;
+  std::uint64_t blockCount;
+  std::uint64_t indexOffset;
+  std::uint64_t tableOffset;
+  std::uint64_t tableSize;
+  std::uint64_t reserved;
+};
+
+static_assert(sizeof(Header) == 64);
+
+struct FileRecord {
+  std::uint64_t offset;
+  std::uint64_t size;
+  std::uint32_t flags;
+  std::uint32_t nameSize;
+};
+
+static_assert(sizeof(FileRecord) == 24);
+
+inline std::uint64_t blockCountFor(std::uint64_t dataSize,
+                                   std::uint32_t blockSize) {
+  return (dataSize + blockSize - 1) / blockSize;
+}
+} // namespace discimg
@@ -0,0 +1,145 @@
+#include "fd_window_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+
+fs::file FdWindowFile::open(int fd, u64 base, u64 length) {
+  fs::file result;
+  result.reset(std::make_unique<FdWindowFile>(fd, base, length));
+  return result;
+}
+
+fs::stat_t FdWindowFile::get_stat() {
+  struct ::stat native {};
+  ::fstat(fd, &native);
+
+  fs::stat_t info{};
+  info.size = length;
+  info.atime = native.st_atime;
+  info.mtime = native.st_mtime;
+  info.ctime = native.st_ctime;
+  return info;
+}
+
+u64 FdWindowFile::read(void *buffer, u64 size) {
+  const u64 result = read_at(pos, buffer, size);
+  pos += result;
+  return result;
+}
+
+u64 FdWindowFile::read_at(u64 offset, void *buffer, u64 size) {
+  if (offset >= length) {
+    return 0;
+  }
+
+  size = std::min(size, length - offset);
+  u64 done = 0;
+
+  while (done < size) {
+    const auto r = ::pread64(fd, static_cast<u8 *>(buffer) + done, size - done,
+                             base + offset + done);
+
+    // A signal delivered to the reading thread is not the end of the file
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (r <= 0) {
+      break;
+    }
+
+    done += r;
+  }
+
+  return done;
+}
+
+u64 FdWindowFile::seek(s64 offset, fs::seek_mode whence) {
+  const s64 new_pos = whence == fs::seek_set   ? offset
+                      : whence == fs::seek_cur ? offset + pos
+                                               : offset + length;
+
+  if (new_pos < 0) {
+    return -1;
+  }
+
+  pos = new_pos;
+  return pos;
+}
+
+namespace {
+constexpr u64 kTarBlockSize = 512;
+
+// Parses an octal header field, which ends with a NUL or a space
+bool parseOctal(const char *field, usz size, u64 &value) {
+  value = 0;
+  usz i = 0;
+
+  while (i < size && field[i] == ' ') {
+    i++;
+  }
+
+  for (; i < size && field[i] != '\0' && field[i] != ' '; i++) {
+    if (field[i] < '0' || field[i] > '7' || value >> 61) {
+      return false;
+    }
+
+    value = value * 8 + (field[i] - '0');
+  }
+
+  return true;
+}
+
+std::string headerString(const char *field, usz size) {
+  return {field, ::strnlen(field, size)};
+}
+} // namespace
+
+bool listTarEntries(const fs::file &archive, std::vector<TarEntry> &entries) {
+  const u64 archiveSize = archive.size();
+  char header[kTarBlockSize];
+
+  for (u64 offset = 0; offset + kTarBlockSize <= archiveSize;) {
+    if (archive.read_at(offset, header, kTarBlockSize) != kTarBlockSize) {
+      return false;
+    }
+
+    // The archive ends with zero blocks
+    if (std::all_of(header, header + kTarBlockSize,
+                    [](char c) { return c == '\0'; })) {
+      return true;
+    }
+
+    u64 size;
+    if (std::memcmp(header + 257, "ustar", 5) != 0 ||
+        !parseOctal(header + 124, 12, size)) {
+      return false;
+    }
+
+    const u64 data = offset + kTarBlockSize;
+    if (size > archiveSize - data) {
+      return false;
+    }
+
+    const char type = header[156];
+
+    if (type == '0' || type == '\0') {
+      std::string name = headerString(header, 100);
+      std::string prefix = headerString(header + 345, 155);
+
+      if (!prefix.empty()) {
+        name = prefix + "/" + name;
+      }
+
+      entries.push_back({std::move(name), data, size});
+    }
+
+    offset = data + (size + kTarBlockSize - 1) / kTarBlockSize * kTarBlockSize;
+  }
+
+  return true;
+}
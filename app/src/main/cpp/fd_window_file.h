@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Utilities/File.h"
+#include "util/types.hpp"
+
+#include <string>
+#include <vector>
+
+// Read-only view of a byte range of a native file, used to read PUP entries
+// in place instead of buffering them in memory. Reads go through pread, so
+// several views of one descriptor can be read from different threads. The
+// descriptor stays owned by the caller and has to outlive the views.
+class FdWindowFile final : public fs::file_base {
+public:
+  FdWindowFile(int fd, u64 base, u64 length)
+      : fd(fd), base(base), length(length) {}
+
+  // Wraps the view into an fs::file
+  static fs::file open(int fd, u64 base, u64 length);
+
+  fs::stat_t get_stat() override;
+  bool trunc(u64) override { return false; }
+  u64 read(void *buffer, u64 size) override;
+  u64 read_at(u64 offset, void *buffer, u64 size) override;
+  u64 write(const void *, u64) override { return 0; }
+  u64 seek(s64 offset, fs::seek_mode whence) override;
+  u64 size() override { return length; }
+
+private:
+  int fd;
+  u64 base;
+  u64 length;
+  u64 pos = 0;
+};
+
+struct TarEntry {
+  std::string name;
+
+  // Position of the file data in the archive
+  u64 offset = 0;
+  u64 size = 0;
+};
+
+// Lists the regular files of a ustar archive from their headers, without
+// reading their data. Returns false if a header is truncated or broken
+bool listTarEntries(const fs::file &archive, std::vector<TarEntry> &entries);
@@ -0,0 +1,278 @@
+#include "frame_consumer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+void convertFrame(const u8 *data, u32 pitch, u32 width, u32 height,
+                  bool isBgra, const FrameConsumer::Config &config,
+                  FrameConsumer::Frame &frame) {
+  // A frame smaller than the divisor is scaled down to a single pixel row or
+  // column, sampling must not run past its edge
+  const u32 divisor = std::min({config.scaleDivisor, width, height});
+  const u32 bytesPerPixel =
+      config.format == FrameConsumer::PixelFormat::rgb565 ? 2 : 4;
+
+  frame.width = width / divisor;
+  frame.height = height / divisor;
+  frame.pitch = frame.width * bytesPerPixel;
+  frame.format = config.format;
+
+  // Only grows, steady state frames reuse the allocation
+  frame.pixels.resize(static_cast<usz>(frame.pitch) * frame.height);
+
+  const bool swapRedBlue =
+      isBgra != (config.format == FrameConsumer::PixelFormat::bgra8888);
+
+  if (divisor == 1 && bytesPerPixel == 4 && !swapRedBlue) {
+    for (u32 y = 0; y < frame.height; y++) {
+      std::memcpy(frame.pixels.data() + y * frame.pitch, data + y * pitch,
+                  frame.pitch);
+    }
+
+    return;
+  }
+
+  const u32 redOffset = isBgra ? 2 : 0;
+  const u32 blueOffset = isBgra ? 0 : 2;
+  const u32 samples = divisor * divisor;
+
+  for (u32 y = 0; y < frame.height; y++) {
+    u8 *out = frame.pixels.data() + y * frame.pitch;
+
+    for (u32 x = 0; x < frame.width; x++) {
+      u32 r = 0, g = 0, b = 0, a = 0;
+
+      for (u32 sy = 0; sy < divisor; sy++) {
+        const u8 *in = data + (y * divisor + sy) * pitch + x * divisor * 4;
+
+        for (u32 sx = 0; sx < divisor; sx++, in += 4) {
+          r += in[redOffset];
+          g += in[1];
+          b += in[blueOffset];
+          a += in[3];
+        }
+      }
+
+      r /= samples;
+      g /= samples;
+      b /= samples;
+      a /= samples;
+
+      switch (config.format) {
+      case FrameConsumer::PixelFormat::rgba8888:
+        out[0] = static_cast<u8>(r);
+        out[1] = static_cast<u8>(g);
+        out[2] = static_cast<u8>(b);
+        out[3] = static_cast<u8>(a);
+        out += 4;
+        break;
+
+      case FrameConsumer::PixelFormat::bgra8888:
+        out[0] = static_cast<u8>(b);
+        out[1] = static_cast<u8>(g);
+        out[2] = static_cast<u8>(r);
+        out[3] = static_cast<u8>(a);
+        out += 4;
+        break;
+
+      case FrameConsumer::PixelFormat::rgb565: {
+        const u16 pixel =
+            static_cast<u16>(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+        std::memcpy(out, &pixel, sizeof(pixel));
+        out += 2;
+        break;
+      }
+      }
+    }
+  }
+}
+} // namespace
+
+bool FrameConsumer::configure(const Config &config) {
+  if (config.scaleDivisor == 0 || config.scaleDivisor > 16 ||
+      config.format > PixelFormat::rgb565) {
+    return false;
+  }
+
+  std::lock_guard lock(mutex);
+  current = config;
+  active = true;
+  lastSubmit = 0;
+  return true;
+}
+
+void FrameConsumer::disable() {
+  {
+    std::lock_guard lock(mutex);
+    active = false;
+  }
+
+  readyCv.notify_all();
+}
+
+bool FrameConsumer::enabled() const {
+  std::lock_guard lock(mutex);
+  return active;
+}
+
+bool FrameConsumer::wantsFrame(u64 now) const {
+  std::lock_guard lock(mutex);
+
+  if (!active) {
+    return false;
+  }
+
+  return current.maxRate == 0 || lastSubmit == 0 ||
+         now - lastSubmit >= 1'000'000'000 / current.maxRate;
+}
+
+void FrameConsumer::submit(const u8 *data, u32 pitch, u32 width, u32 height,
+                           bool isBgra, u64 now) {
+  if (data == nullptr || width == 0 || height == 0) {
+    return;
+  }
+
+  usz index = kBufferCount;
+  Config config;
+
+  {
+    std::lock_guard lock(mutex);
+
+    if (!active) {
+      return;
+    }
+
+    // Prefer a free buffer, otherwise overwrite the oldest unread frame
+    for (usz i = 0; i < kBufferCount; i++) {
+      if (states[i] == BufferState::free) {
+        index = i;
+        break;
+      }
+
+      if (states[i] == BufferState::ready &&
+          (index == kBufferCount ||
+           buffers[i].sequence < buffers[index].sequence)) {
+        index = i;
+      }
+    }
+
+    if (index == kBufferCount) {
+      droppedFrames++;
+      return;
+    }
+
+    if (states[index] == BufferState::ready) {
+      droppedFrames++;
+    }
+
+    states[index] = BufferState::writing;
+    config = current;
+    lastSubmit = now;
+  }
+
+  Frame &frame = buffers[index];
+  convertFrame(data, pitch, width, height, isBgra, config, frame);
+  frame.timestamp = now;
+
+  {
+    std::lock_guard lock(mutex);
+    frame.sequence = ++nextSequence;
+    states[index] = BufferState::ready;
+  }
+
+  readyCv.notify_one();
+}
+
+const FrameConsumer::Frame *
+FrameConsumer::acquire(std::chrono::milliseconds timeout) {
+  std::unique_lock lock(mutex);
+
+  if (readingIndex != kBufferCount) {
+    states[readingIndex] = BufferState::free;
+    readingIndex = kBufferCount;
+  }
+
+  usz index = kBufferCount;
+
+  readyCv.wait_for(lock, timeout, [&] {
+    if (!active) {
+      return true;
+    }
+
+    index = kBufferCount;
+
+    for (usz i = 0; i < kBufferCount; i++) {
+      if (states[i] == BufferState::ready &&
+          (index == kBufferCount ||
+           buffers[i].sequence > buffers[index].sequence)) {
+        index = i;
+      }
+    }
+
+    return index != kBufferCount;
+  });
+
+  if (!active || index == kBufferCount) {
+    return nullptr;
+  }
+
+  // Older unread frames are superseded by the one we hand out
+  for (usz i = 0; i < kBufferCount; i++) {
+    if (i != index && states[i] == BufferState::ready) {
+      states[i] = BufferState::free;
+      droppedFrames++;
+    }
+  }
+
+  states[index] = BufferState::reading;
+  readingIndex = index;
+  return &buffers[index];
+}
+
+void FrameConsumer::release() {
+  std::lock_guard lock(mutex);
+
+  if (readingIndex != kBufferCount) {
+    states[readingIndex] = BufferState::free;
+    readingIndex = kBufferCount;
+  }
+}
+
+const FrameConsumer::Frame *FrameConsumer::acquired() const {
+  std::lock_guard lock(mutex);
+  return readingIndex != kBufferCount ? &buffers[readingIndex] : nullptr;
+}
+
+u64 FrameConsumer::dropped() const {
+  std::lock_guard lock(mutex);
+  return droppedFrames;
+}
+
+u64 FrameConsumer::memoryUsage() const {
+  std::lock_guard lock(mutex);
+  u64 result = 0;
+
+  for (auto &buffer : buffers) {
+    result += buffer.pixels.capacity();
+  }
+
+  return result;
+}
+
+u64 FrameConsumer::trim() {
+  std::lock_guard lock(mutex);
+  u64 result = 0;
+
+  for (usz i = 0; i < kBufferCount; i++) {
+    // Unread frames are only worth keeping while somebody may read them
+    if (states[i] == BufferState::free ||
+        (states[i] == BufferState::ready && !active)) {
+      result += buffers[i].pixels.capacity();
+      buffers[i].pixels = std::vector<u8>();
+      states[i] = BufferState::free;
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Hands rendered frames to a consumer (capture, streaming, visual tests)
+// through a small pool of reusable buffers. The renderer side only copies
+// into a free buffer, converting and downscaling on the way, and never
+// allocates once the buffers reached the frame size. When the consumer
+// falls behind the oldest unread frame is overwritten.
+//
+// Only one consumer is supported.
+class FrameConsumer {
+public:
+  enum class PixelFormat : u32 {
+    rgba8888 = 0,
+    bgra8888 = 1,
+    rgb565 = 2,
+  };
+
+  struct Config {
+    // Frames per second handed to the consumer, 0 for every frame
+    u32 maxRate = 0;
+
+    // Width and height are divided by this, pixels are box filtered
+    u32 scaleDivisor = 1;
+
+    PixelFormat format = PixelFormat::rgba8888;
+  };
+
+  struct Frame {
+    std::vector<u8> pixels;
+    u32 width = 0;
+    u32 height = 0;
+    u32 pitch = 0;
+    PixelFormat format = PixelFormat::rgba8888;
+    u64 sequence = 0;
+    u64 timestamp = 0;
+  };
+
+  static constexpr usz kBufferCount = 3;
+
+  // Enables the consumer, buffers are kept across reconfiguration
+  bool configure(const Config &config);
+  void disable();
+
+  bool enabled() const;
+
+  // Renderer side. wantsFrame() applies the rate limit, submit() copies a
+  // 32-bit RGBA or BGRA frame into a free buffer
+  bool wantsFrame(u64 now) const;
+  void submit(const u8 *data, u32 pitch, u32 width, u32 height, bool isBgra,
+              u64 now);
+
+  // Consumer side. Returns the newest unread frame, or null on timeout or
+  // when disabled. The frame stays valid until release()
+  const Frame *acquire(std::chrono::milliseconds timeout);
+  void release();
+
+  // The frame returned by the last acquire(), null once it was released
+  const Frame *acquired() const;
+
+  u64 dropped() const;
+
+  // Bytes held by the buffers
+  u64 memoryUsage() const;
+
+  // Frees the buffers nobody is using, returns the bytes freed. They are
+  // allocated again by the next submit()
+  u64 trim();
+
+private:
+  enum class BufferState : u8 {
+    free,
+    writing,
+    ready,
+    reading,
+  };
+
+  mutable std::mutex mutex;
+  std::condition_variable readyCv;
+
+  Config current;
+  bool active = false;
+
+  Frame buffers[kBufferCount];
+  BufferState states[kBufferCount] = {};
+  usz readingIndex = kBufferCount;
+
+  u64 lastSubmit = 0;
+  u64 nextSequence = 0;
+  u64 droppedFrames = 0;
+};
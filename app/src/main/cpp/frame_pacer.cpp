@@ -0,0 +1,113 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Vsync reports stop while the app is in background, don't project a grid
+// from timestamps older than this
+constexpr u64 kMaxVsyncAge = 1'000'000'000;
+
+constexpr u32 kMaxCadence = 8;
+
+// A frame slightly longer than a whole number of vsyncs is still counted as
+// that number, the limiter in the emulator is not exact
+constexpr f64 kCadenceTolerance = 0.1;
+
+constexpr f64 kEmaWeight = 0.1;
+} // namespace
+
+void FramePacer::onVsync(u64 timestamp, f64 refreshRate) {
+  std::lock_guard lock(mutex);
+
+  if (refreshRate > 0) {
+    rate = refreshRate;
+    period = static_cast<u64>(1e9 / refreshRate);
+  }
+
+  lastVsync = timestamp;
+}
+
+f64 FramePacer::refreshRate() const {
+  std::lock_guard lock(mutex);
+  return rate > 0 ? rate : kDefaultRefreshRate;
+}
+
+u64 FramePacer::snapToVsync(u64 time) const {
+  const f64 vsyncs = std::round(static_cast<f64>(static_cast<s64>(
+                                    time - lastVsync)) /
+                                static_cast<f64>(period));
+  return lastVsync + static_cast<s64>(vsyncs) * static_cast<s64>(period);
+}
+
+u64 FramePacer::onFrame(u64 now) {
+  std::lock_guard lock(mutex);
+
+  if (lastFrame != 0) {
+    const f64 frameTime = static_cast<f64>(now - lastFrame);
+    frameTimeEma = frameTimeEma == 0
+                       ? frameTime
+                       : frameTimeEma + (frameTime - frameTimeEma) * kEmaWeight;
+    maxFrameTime = std::max(maxFrameTime, frameTime);
+  }
+
+  lastFrame = now;
+  frames++;
+
+  if (period == 0 || lastVsync == 0 || now - lastVsync > kMaxVsyncAge) {
+    frameStart = 0;
+    return now;
+  }
+
+  if (frameStart == 0) {
+    frameStart = now;
+    return now;
+  }
+
+  const f64 cost = static_cast<f64>(now - std::min(frameStart, now));
+  frameCostEma = frameCostEma == 0
+                     ? cost
+                     : frameCostEma + (cost - frameCostEma) * kEmaWeight;
+
+  cadence = static_cast<u32>(std::clamp<f64>(
+      std::ceil(frameCostEma / static_cast<f64>(period) - kCadenceTolerance),
+      1, kMaxCadence));
+
+  u64 target = snapToVsync(frameStart + cadence * period);
+
+  if (target + period / 2 < now) {
+    // The frame took longer than its cadence, start the next one right away
+    // and let the cadence catch up
+    missedDeadlines++;
+    target = now;
+  }
+
+  frameStart = std::max(target, now);
+  return target;
+}
+
+FramePacer::Stats FramePacer::stats() const {
+  std::lock_guard lock(mutex);
+
+  return {
+      .refreshRate = rate > 0 ? rate : kDefaultRefreshRate,
+      .frames = frames,
+      .missedDeadlines = missedDeadlines,
+      .averageFrameTimeMs = frameTimeEma / 1e6,
+      .maxFrameTimeMs = maxFrameTime / 1e6,
+      .cadence = cadence,
+  };
+}
+
+void FramePacer::reset() {
+  std::lock_guard lock(mutex);
+
+  frameStart = 0;
+  lastFrame = 0;
+  frameCostEma = 0;
+  cadence = 1;
+  frames = 0;
+  missedDeadlines = 0;
+  frameTimeEma = 0;
+  maxFrameTime = 0;
+}
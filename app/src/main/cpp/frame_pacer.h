@@ -0,0 +1,61 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <mutex>
+
+// Aligns the renderer's frame loop to the display vsync grid. The display
+// side reports refresh rate and vsync timestamps (Choreographer on Android),
+// the renderer calls onFrame() once per flip and sleeps until the returned
+// time before it starts the next frame. A frame keeps a whole number of
+// vsyncs (the cadence) derived from how long recent frames took, so 30 FPS
+// content on a 120 Hz panel is shown for exactly four refreshes each.
+//
+// All times are steady clock nanoseconds, the class does not read a clock
+// itself.
+class FramePacer {
+public:
+  struct Stats {
+    f64 refreshRate = 0;
+    u64 frames = 0;
+    u64 missedDeadlines = 0;
+    f64 averageFrameTimeMs = 0;
+    f64 maxFrameTimeMs = 0;
+    u32 cadence = 0;
+  };
+
+  // Used until the display reported its refresh rate
+  static constexpr f64 kDefaultRefreshRate = 60;
+
+  void onVsync(u64 timestamp, f64 refreshRate);
+
+  f64 refreshRate() const;
+
+  // Returns when the next frame should start, never earlier than now when
+  // the display timing is not known yet
+  u64 onFrame(u64 now);
+
+  Stats stats() const;
+
+  // Forgets the frame history, e.g. when a new title boots
+  void reset();
+
+private:
+  u64 snapToVsync(u64 time) const;
+
+  mutable std::mutex mutex;
+
+  f64 rate = 0;
+  u64 period = 0;
+  u64 lastVsync = 0;
+
+  u64 frameStart = 0;
+  u64 lastFrame = 0;
+  f64 frameCostEma = 0;
+  u32 cadence = 1;
+
+  u64 frames = 0;
+  u64 missedDeadlines = 0;
+  f64 frameTimeEma = 0;
+  f64 maxFrameTime = 0;
+};
@@ -0,0 +1,213 @@
+#include "game_index.h"
+
+#include "Utilities/File.h"
+#include "util/logs.hpp"
+
+#include <cstring>
+
+LOG_CHANNEL(game_index_log, "GameIndex");
+
+namespace {
+constexpr u32 kIndexMagic = 0x58494752; // "RGIX"
+constexpr u32 kIndexVersion = 1;
+
+bool isUnder(const std::string &path, const std::string &rootDir) {
+  if (!path.starts_with(rootDir)) {
+    return false;
+  }
+
+  return rootDir.ends_with('/') || path.size() == rootDir.size() ||
+         path[rootDir.size()] == '/';
+}
+
+struct Writer {
+  std::string buffer;
+
+  template <typename T> void put(T value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  void put(const std::string &value) {
+    put<u32>(static_cast<u32>(value.size()));
+    buffer += value;
+  }
+};
+
+struct Reader {
+  const std::vector<u8> &data;
+  usz pos = 0;
+
+  template <typename T> bool get(T &value) {
+    if (data.size() - pos < sizeof(T)) {
+      return false;
+    }
+
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool get(std::string &value) {
+    u32 size;
+    if (!get(size) || data.size() - pos < size) {
+      return false;
+    }
+
+    value.assign(reinterpret_cast<const char *>(data.data() + pos), size);
+    pos += size;
+    return true;
+  }
+};
+} // namespace
+
+void GameIndex::load() {
+  loaded = true;
+
+  fs::file file(path);
+  if (!file) {
+    return;
+  }
+
+  const auto data = file.to_vector<u8>();
+  Reader reader{data};
+
+  u32 magic = 0, version = 0, count = 0;
+  if (!reader.get(magic) || !reader.get(version) || !reader.get(count) ||
+      magic != kIndexMagic || version != kIndexVersion) {
+    game_index_log.warning("Ignoring incompatible game index %s", path);
+    return;
+  }
+
+  for (u32 i = 0; i < count; i++) {
+    std::string gamePath;
+    Entry entry;
+    u8 bootable = 0;
+
+    if (!reader.get(gamePath) || !reader.get(entry.mtime) ||
+        !reader.get(entry.size) || !reader.get(bootable)) {
+      game_index_log.error("Game index %s is truncated", path);
+      entries.clear();
+      return;
+    }
+
+    if (bootable) {
+      GameInfo info{.path = gamePath};
+      if (!reader.get(info.name) || !reader.get(info.iconPath)) {
+        game_index_log.error("Game index %s is truncated", path);
+        entries.clear();
+        return;
+      }
+
+      entry.info = std::move(info);
+    }
+
+    entries.emplace(std::move(gamePath), std::move(entry));
+  }
+
+  game_index_log.notice("Loaded %u entries from %s", entries.size(), path);
+}
+
+std::vector<GameInfo>
+GameIndex::list(const std::vector<std::string> &rootDirs) {
+  std::lock_guard lock(mutex);
+
+  if (!loaded) {
+    load();
+  }
+
+  std::vector<GameInfo> result;
+
+  for (auto &[gamePath, entry] : entries) {
+    if (!entry.info) {
+      continue;
+    }
+
+    for (auto &rootDir : rootDirs) {
+      if (isUnder(gamePath, rootDir)) {
+        result.push_back(*entry.info);
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
+std::optional<GameIndex::Entry> GameIndex::find(const std::string &gamePath,
+                                                s64 mtime, u64 size) {
+  std::lock_guard lock(mutex);
+
+  if (!loaded) {
+    load();
+  }
+
+  if (auto it = entries.find(gamePath);
+      it != entries.end() && it->second.mtime == mtime &&
+      it->second.size == size) {
+    return it->second;
+  }
+
+  return {};
+}
+
+void GameIndex::update(const std::string &gamePath, Entry entry) {
+  std::lock_guard lock(mutex);
+
+  if (!loaded) {
+    load();
+  }
+
+  entries.insert_or_assign(gamePath, std::move(entry));
+  dirty = true;
+}
+
+void GameIndex::retain(const std::string &rootDir,
+                       const std::unordered_set<std::string> &seen) {
+  std::lock_guard lock(mutex);
+
+  if (!loaded) {
+    load();
+  }
+
+  dirty |= std::erase_if(entries, [&](const auto &item) {
+             return isUnder(item.first, rootDir) && !seen.contains(item.first);
+           }) != 0;
+}
+
+bool GameIndex::save() {
+  std::lock_guard lock(mutex);
+
+  if (!dirty) {
+    return true;
+  }
+
+  Writer writer;
+  writer.put(kIndexMagic);
+  writer.put(kIndexVersion);
+  writer.put<u32>(static_cast<u32>(entries.size()));
+
+  for (auto &[gamePath, entry] : entries) {
+    writer.put(gamePath);
+    writer.put(entry.mtime);
+    writer.put(entry.size);
+    writer.put<u8>(entry.info.has_value());
+
+    if (entry.info) {
+      writer.put(entry.info->name);
+      writer.put(entry.info->iconPath);
+    }
+  }
+
+  fs::pending_file file(path);
+
+  if (!file.file ||
+      file.file.write(writer.buffer.data(), writer.buffer.size()) !=
+          writer.buffer.size() ||
+      !file.commit()) {
+    game_index_log.error("Failed to write game index %s", path);
+    return false;
+  }
+
+  dirty = false;
+  return true;
+}
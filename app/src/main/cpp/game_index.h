@@ -0,0 +1,56 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct GameInfo {
+  std::string path;
+  std::string name;
+  std::string iconPath;
+};
+
+// Persistent cache of parsed PARAM.SFO files, keyed by game root path.
+// An entry stays valid while the PARAM.SFO mtime and size are unchanged, so
+// a rescan only has to reparse titles that were added or modified.
+class GameIndex {
+public:
+  struct Entry {
+    s64 mtime = 0;
+    u64 size = 0;
+
+    // Empty when the PARAM.SFO does not describe a bootable title
+    std::optional<GameInfo> info;
+  };
+
+  explicit GameIndex(std::string path) : path(std::move(path)) {}
+
+  // Returns cached bootable titles located under one of the roots
+  std::vector<GameInfo> list(const std::vector<std::string> &rootDirs);
+
+  // Returns the cached entry if it is still valid for the given PARAM.SFO
+  std::optional<Entry> find(const std::string &gamePath, s64 mtime, u64 size);
+
+  void update(const std::string &gamePath, Entry entry);
+
+  // Drops entries under rootDir which were not seen during the last scan
+  void retain(const std::string &rootDir,
+              const std::unordered_set<std::string> &seen);
+
+  // Writes the index back to disk if it was modified
+  bool save();
+
+private:
+  void load();
+
+  std::mutex mutex;
+  std::string path;
+  std::unordered_map<std::string, Entry> entries;
+  bool loaded = false;
+  bool dirty = false;
+};
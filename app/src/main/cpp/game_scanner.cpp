@@ -0,0 +1,164 @@
+#include "game_scanner.h"
+
+#include "Utilities/Thread.h"
+#include "disc_image_format.h"
+#include "util/atomic.hpp"
+#include "util/sysinfo.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sys/stat.h>
+
+namespace {
+// Checks whether dir is a game root, a single stat per directory which also
+// provides the index key
+std::optional<GamePath> probeGamePath(std::string dir) {
+  struct stat sfo_stat;
+  if (::stat((dir + "/PARAM.SFO").c_str(), &sfo_stat) != 0 ||
+      !S_ISREG(sfo_stat.st_mode)) {
+    return {};
+  }
+
+  return GamePath{
+      .path = std::move(dir),
+      .mtime = sfo_stat.st_mtime,
+      .size = static_cast<u64>(sfo_stat.st_size),
+  };
+}
+
+// Compressed disc images are games as well, keyed by the image itself
+std::optional<GamePath>
+probeDiscImage(const std::filesystem::directory_entry &entry) {
+  if (entry.path().extension() != discimg::kExtension) {
+    return {};
+  }
+
+  struct stat image_stat;
+  if (::stat(entry.path().c_str(), &image_stat) != 0 ||
+      !S_ISREG(image_stat.st_mode)) {
+    return {};
+  }
+
+  return GamePath{
+      .path = entry.path().string(),
+      .mtime = image_stat.st_mtime,
+      .size = static_cast<u64>(image_stat.st_size),
+  };
+}
+} // namespace
+
+void scanGamePaths(const std::vector<std::string> &rootDirs,
+                   const std::function<void(GamePath &&)> &onGamePath) {
+  struct ScanQueue {
+    std::mutex mutex;
+    std::deque<std::string> dirs;
+  };
+
+  const u32 workerCount =
+      std::clamp<u32>(utils::get_thread_count() * 2, 2, 16);
+  auto queues = std::make_unique<ScanQueue[]>(workerCount);
+
+  // Directories queued or being enumerated
+  atomic_t<usz> pending = rootDirs.size();
+  // Bumped whenever work is queued or the scan is over, idle workers wait on it
+  atomic_t<u32> epoch = 0;
+  atomic_t<u32> nextId = 0;
+
+  for (std::size_t i = 0; i < rootDirs.size(); i++) {
+    queues[i % workerCount].dirs.push_back(rootDirs[i]);
+  }
+
+  auto take = [&](u32 id, std::string &dir) {
+    for (u32 i = 0; i < workerCount; i++) {
+      auto &queue = queues[(id + i) % workerCount];
+      std::lock_guard lock(queue.mutex);
+
+      if (queue.dirs.empty()) {
+        continue;
+      }
+
+      // Own queue is used as a stack to stay depth first, stolen work is
+      // taken from the other end where the larger subtrees are
+      if (i == 0) {
+        dir = std::move(queue.dirs.back());
+        queue.dirs.pop_back();
+      } else {
+        dir = std::move(queue.dirs.front());
+        queue.dirs.pop_front();
+      }
+
+      return true;
+    }
+
+    return false;
+  };
+
+  auto worker = [&] {
+    const u32 id = nextId++;
+    std::vector<std::string> subdirs;
+
+    while (true) {
+      const u32 old_epoch = epoch;
+      std::string dir;
+
+      if (!take(id, dir)) {
+        if (pending == 0) {
+          return;
+        }
+
+        epoch.wait(old_epoch);
+        continue;
+      }
+
+      std::error_code ec;
+      for (std::filesystem::directory_iterator it(dir, ec), end;
+           !ec && it != end; it.increment(ec)) {
+        std::error_code entry_ec;
+        if (!it->is_directory(entry_ec)) {
+          if (auto gamePath = probeDiscImage(*it)) {
+            onGamePath(std::move(*gamePath));
+          }
+
+          continue;
+        }
+
+        auto path = it->path().string();
+
+        if (auto gamePath = probeGamePath(path)) {
+          // Games do not contain other games, skip the rest of this title
+          onGamePath(std::move(*gamePath));
+        } else if (!it->is_symlink(entry_ec)) {
+          subdirs.push_back(std::move(path));
+        }
+      }
+
+      if (!subdirs.empty()) {
+        pending += subdirs.size();
+
+        {
+          auto &queue = queues[id];
+          std::lock_guard lock(queue.mutex);
+          std::move(subdirs.begin(), subdirs.end(),
+                    std::back_inserter(queue.dirs));
+        }
+
+        subdirs.clear();
+        epoch++;
+        epoch.notify_all();
+      }
+
+      if (--pending == 0) {
+        epoch++;
+        epoch.notify_all();
+      }
+    }
+  };
+
+  named_thread_group workers("Game Scanner ", workerCount, worker);
+  workers.join();
+}
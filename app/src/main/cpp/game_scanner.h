@@ -0,0 +1,25 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// A game root, either a directory with a PARAM.SFO or a compressed disc
+// image. mtime and size are those of the PARAM.SFO or the image and key the
+// GameIndex entry.
+struct GamePath {
+  std::string path;
+  s64 mtime;
+  u64 size;
+};
+
+// Walks the roots on a group of workers. Enumerating directories on FUSE
+// backed storage is latency bound rather than CPU bound, so subdirectories are
+// fanned out: every worker keeps its own queue and steals from the others
+// once it runs dry. Like recursive_directory_iterator, directory symlinks are
+// probed but not descended into, and the roots themselves are not probed.
+// onGamePath is called on the worker threads.
+void scanGamePaths(const std::vector<std::string> &rootDirs,
+                   const std::function<void(GamePath &&)> &onGamePath);
@@ -0,0 +1,204 @@
+#include "input_monitor.h"
+
+#include "util/logs.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+LOG_CHANNEL(input_log, "Input");
+
+namespace {
+u64 steadyClockNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+constexpr u32 kDeviceEvents = EPOLLIN | EPOLLOUT | EPOLLET;
+} // namespace
+
+InputEventMonitor::~InputEventMonitor() { stop(); }
+
+bool InputEventMonitor::start(WakeFn newWake) {
+  std::lock_guard lock(mutex);
+
+  if (thread.joinable()) {
+    return true;
+  }
+
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = stopFd;
+
+  if (epollFd < 0 || stopFd < 0 ||
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event) != 0) {
+    input_log.error("Failed to set up the input monitor: %s",
+                    strerror(errno));
+
+    if (epollFd >= 0) {
+      close(epollFd);
+    }
+
+    if (stopFd >= 0) {
+      close(stopFd);
+    }
+
+    epollFd = stopFd = -1;
+    return false;
+  }
+
+  wake = std::move(newWake);
+  thread = std::thread([this] {
+    pthread_setname_np(pthread_self(), "Input Monitor");
+    run();
+  });
+
+  return true;
+}
+
+void InputEventMonitor::stop() {
+  std::lock_guard lock(mutex);
+
+  if (!thread.joinable()) {
+    return;
+  }
+
+  const u64 one = 1;
+  [[maybe_unused]] auto written = write(stopFd, &one, sizeof(one));
+  thread.join();
+
+  close(epollFd);
+  close(stopFd);
+  epollFd = stopFd = -1;
+}
+
+bool InputEventMonitor::running() const {
+  std::lock_guard lock(mutex);
+  return thread.joinable();
+}
+
+void InputEventMonitor::addDevice(int fd) {
+  std::lock_guard lock(mutex);
+
+  if (epollFd < 0) {
+    return;
+  }
+
+  epoll_event event{};
+  event.events = kDeviceEvents;
+  event.data.fd = fd;
+
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    input_log.warning("Failed to monitor fd %d: %s", fd, strerror(errno));
+  }
+}
+
+void InputEventMonitor::removeDevice(int fd) {
+  std::lock_guard lock(mutex);
+
+  if (epollFd >= 0) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+  }
+}
+
+void InputEventMonitor::onFrame(u64 now) {
+  const u64 report = pendingReport.exchange(0);
+  if (report == 0 || now < report) {
+    return;
+  }
+
+  std::lock_guard lock(statsMutex);
+  const u64 latency = now - report;
+  frames++;
+  frameTotal += latency;
+  frameMax = std::max(frameMax, latency);
+}
+
+InputEventMonitor::Stats InputEventMonitor::stats() const {
+  std::lock_guard lock(statsMutex);
+
+  Stats result;
+  result.reports = reports;
+  result.wakeups = wakeups;
+  result.frames = frames;
+  result.maxWakeUs = static_cast<f64>(wakeMax) / 1e3;
+  result.maxFrameMs = static_cast<f64>(frameMax) / 1e6;
+
+  if (wakeups != 0) {
+    result.averageWakeUs = static_cast<f64>(wakeTotal) / 1e3 / wakeups;
+  }
+
+  if (frames != 0) {
+    result.averageFrameMs = static_cast<f64>(frameTotal) / 1e6 / frames;
+  }
+
+  return result;
+}
+
+void InputEventMonitor::resetStats() {
+  std::lock_guard lock(statsMutex);
+  reports = wakeups = wakeTotal = wakeMax = 0;
+  frames = frameTotal = frameMax = 0;
+}
+
+void InputEventMonitor::run() {
+  epoll_event events[16];
+
+  while (true) {
+    const int count = epoll_wait(epollFd, events, std::size(events), -1);
+
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      input_log.error("epoll_wait failed: %s", strerror(errno));
+      return;
+    }
+
+    const u64 now = steadyClockNs();
+    u32 deviceEvents = 0;
+
+    for (int i = 0; i < count; i++) {
+      if (events[i].data.fd == stopFd) {
+        return;
+      }
+
+      if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+        // Unplugged, the registry removes it once Android reports the detach
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, events[i].data.fd, nullptr);
+        continue;
+      }
+
+      deviceEvents++;
+    }
+
+    if (deviceEvents == 0) {
+      continue;
+    }
+
+    u64 expected = 0;
+    pendingReport.compare_exchange_strong(expected, now);
+
+    std::this_thread::sleep_for(std::chrono::nanoseconds(kReapDelayNs));
+    wake();
+
+    const u64 woken = steadyClockNs();
+
+    std::lock_guard lock(statsMutex);
+    reports += deviceEvents;
+    wakeups++;
+    wakeTotal += woken - now;
+    wakeMax = std::max(wakeMax, woken - now);
+  }
+}
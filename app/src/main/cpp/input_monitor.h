@@ -0,0 +1,72 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Wakes the pad thread as soon as a controller report arrives instead of
+// leaving it to the next "Pad Handler Sleep" poll. The monitored fds are the
+// usbfs connections of the attached pads: the kernel signals them when a
+// transfer completes, before libusb reaped it for hidapi. Any fd which
+// becomes readable or writable on input works, tests use a pipe.
+//
+// Also measures input latency: from the report to the pad thread wakeup and
+// from the report to the next frame the renderer flips. Times are steady
+// clock nanoseconds.
+class InputEventMonitor {
+public:
+  struct Stats {
+    u64 reports = 0;
+    u64 wakeups = 0;
+    f64 averageWakeUs = 0;
+    f64 maxWakeUs = 0;
+    u64 frames = 0;
+    f64 averageFrameMs = 0;
+    f64 maxFrameMs = 0;
+  };
+
+  using WakeFn = std::function<void()>;
+
+  // Time libusb gets to reap a completed transfer before the pad thread is
+  // woken, otherwise it can miss the report it was woken for
+  static constexpr u64 kReapDelayNs = 200'000;
+
+  ~InputEventMonitor();
+
+  bool start(WakeFn wake);
+  void stop();
+  bool running() const;
+
+  void addDevice(int fd);
+  void removeDevice(int fd);
+
+  // Called by the renderer once per flip
+  void onFrame(u64 now);
+
+  Stats stats() const;
+  void resetStats();
+
+private:
+  void run();
+
+  mutable std::mutex mutex;
+  std::thread thread;
+  int epollFd = -1;
+  int stopFd = -1;
+  WakeFn wake;
+
+  // Earliest report the next frame has not shown yet, 0 when none
+  std::atomic<u64> pendingReport = 0;
+
+  mutable std::mutex statsMutex;
+  u64 reports = 0;
+  u64 wakeups = 0;
+  u64 wakeTotal = 0;
+  u64 wakeMax = 0;
+  u64 frames = 0;
+  u64 frameTotal = 0;
+  u64 frameMax = 0;
+};
@@ -0,0 +1,42 @@
+#include "jni_marshal.h"
+
+jobjectArray makeGameInfoArray(JNIEnv *env, jclass gameInfo,
+                               jmethodID constructor,
+                               std::span<const GameInfo> infos) {
+  auto result = env->NewObjectArray(infos.size(), gameInfo, nullptr);
+  if (result == nullptr) {
+    return nullptr;
+  }
+
+  for (std::size_t i = 0; i < infos.size(); ++i) {
+    auto path = env->NewStringUTF(infos[i].path.c_str());
+    auto name = env->NewStringUTF(infos[i].name.c_str());
+    auto iconPath = env->NewStringUTF(infos[i].iconPath.c_str());
+    auto object = env->NewObject(gameInfo, constructor, path, name, iconPath);
+
+    env->SetObjectArrayElement(result, i, object);
+
+    env->DeleteLocalRef(object);
+    env->DeleteLocalRef(iconPath);
+    env->DeleteLocalRef(name);
+    env->DeleteLocalRef(path);
+  }
+
+  return result;
+}
+
+jobjectArray makeStringArray(JNIEnv *env, jclass string,
+                             std::span<const std::string> strings) {
+  auto result = env->NewObjectArray(strings.size(), string, nullptr);
+  if (result == nullptr) {
+    return nullptr;
+  }
+
+  for (std::size_t i = 0; i < strings.size(); ++i) {
+    auto element = env->NewStringUTF(strings[i].c_str());
+    env->SetObjectArrayElement(result, i, element);
+    env->DeleteLocalRef(element);
+  }
+
+  return result;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "game_index.h"
+
+#include <jni.h>
+#include <span>
+#include <string>
+
+// Arrays handed to the Kotlin repositories. Every element is created and its
+// local references released before the next one, so a batch only leaves the
+// array in the caller's local frame, whatever its size. Classes and method ids
+// come from the bindings resolved in JNI_OnLoad.
+
+// GameInfo[] for GameRepository.add
+jobjectArray makeGameInfoArray(JNIEnv *env, jclass gameInfo,
+                               jmethodID constructor,
+                               std::span<const GameInfo> infos);
+
+// String[] of strings
+jobjectArray makeStringArray(JNIEnv *env, jclass string,
+                             std::span<const std::string> strings);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <atomic>
+#include <memory>
+
+// Bounded multi-producer, single-consumer ring of reusable slots, shared by
+// the log listeners. Producers claim a position with one CAS, fill the slot
+// and publish it; they never wait for each other or for the consumer. When
+// the consumer has not released the slot yet the push fails and the caller
+// counts a drop.
+//
+// Slots are reused in place, so members which own memory (std::string) keep
+// their capacity and stop allocating once they saw the largest message.
+template <typename Slot> class LogRing {
+public:
+  explicit LogRing(usz capacity)
+      : cells(new Cell[capacity]), capacity(capacity) {
+    for (usz i = 0; i < capacity; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  LogRing(const LogRing &) = delete;
+  LogRing &operator=(const LogRing &) = delete;
+
+  // Claims a slot, fills it with fill(Slot &) and publishes it. position is
+  // the slot's place in the ring, compare it against consumed()
+  template <typename Fill> bool push(Fill &&fill, u64 &position) {
+    position = head.load(std::memory_order_relaxed);
+    Cell *cell;
+
+    while (true) {
+      cell = &cells[position % capacity];
+      const u64 sequence = cell->sequence.load(std::memory_order_acquire);
+      const s64 diff = static_cast<s64>(sequence - position);
+
+      if (diff == 0) {
+        if (head.compare_exchange_weak(position, position + 1,
+                                       std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // The consumer did not release this slot yet
+        return false;
+      } else {
+        position = head.load(std::memory_order_relaxed);
+      }
+    }
+
+    fill(cell->slot);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Hands the oldest published slot to consume(Slot &) and releases it.
+  // Only called from the consumer thread
+  template <typename Consume> bool pop(Consume &&consume) {
+    const u64 position = tail.load(std::memory_order_relaxed);
+    Cell &cell = cells[position % capacity];
+
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+      return false;
+    }
+
+    consume(cell.slot);
+
+    cell.sequence.store(position + capacity, std::memory_order_release);
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Positions claimed by producers so far, published or not
+  u64 claimed() const { return head.load(std::memory_order_relaxed); }
+
+  // Positions below this were handed to the consumer
+  u64 consumed() const { return tail.load(std::memory_order_acquire); }
+
+private:
+  struct Cell {
+    std::atomic<u64> sequence = 0;
+    Slot slot;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  const usz capacity;
+  std::atomic<u64> head = 0;
+  std::atomic<u64> tail = 0;
+};
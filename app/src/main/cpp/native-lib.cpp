@@ -15,6 +15,7 @@
 #include "Emu/localized_string_id.h"
 #include "Emu/system_config.h"
 #include "Emu/system_config_types.h"
+#include "Emu/system_progress.hpp"
 #include "Emu/system_utils.hpp"
 #include "Emu/vfs_config.h"
 #include "Input/ds3_pad_handler.h"
@@ -43,20 +44,51 @@
 #include <Emu/RSX/GSFrameBase.h>
 #include <Emu/System.h>
 
+#include "android_log_sink.h"
+#include "archive_device.h"
+#include "benchmark.h"
+#include "boot_prefetch.h"
+#include "cache_registry.h"
+#include "binary_log.h"
+#include "disc_image_device.h"
+#include "fd_window_file.h"
+#include "frame_consumer.h"
+#include "frame_pacer.h"
+#include "game_index.h"
+#include "game_scanner.h"
+#include "input_monitor.h"
+#include "jni_marshal.h"
+#include "pkg_mount.h"
+#include "surface_manager.h"
+#include "telemetry.h"
+#include "thermal_governor.h"
+#include "thread_affinity.h"
+#include "usb_device_registry.h"
+
 #include <algorithm>
 #include <android/log.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
 #include <filesystem>
 #include <functional>
 #include <iterator>
 #include <jni.h>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <span>
 #include <string>
 #include <sys/resource.h>
+#include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 struct AtExit {
@@ -65,9 +97,145 @@ struct AtExit {
 };
 
 static bool g_initialized;
-static std::atomic<ANativeWindow *> g_native_window;
-static std::mutex g_android_usb_devices_mutex;
-static std::vector<int> g_android_usb_devices;
+static SurfaceManager g_surface;
+static FramePacer g_frame_pacer;
+static FrameConsumer g_frame_consumer;
+static TelemetryPublisher g_telemetry;
+static ThreadPlacer g_thread_placer;
+static ThermalGovernor g_thermal_governor;
+static CacheRegistry g_cache_registry;
+static BootTraceRecorder g_boot_recorder;
+static BootPrefetcher g_boot_prefetcher;
+
+// User settings replaced by the thermal governor, restored once the SoC
+// cooled down. Forgotten on boot, which reloads them from the config
+static struct {
+  std::mutex mutex;
+  bool captured = false;
+  u64 spuThreads = 0;
+  frame_limit_type frameLimit{};
+  u64 compileThreads = 0;
+} g_thermal_baseline;
+
+// While event driven input is on, polling stays as a fallback for pads the
+// monitor does not see, e.g. Bluetooth ones, but can be much slower. The
+// fallback "Pad Handler Sleep" replaces the user's one in g_cfg and is applied
+// again after every boot, which reloads g_cfg
+static constexpr u64 kFallbackPadSleepUs = 8'000;
+
+static struct {
+  std::mutex mutex;
+  bool enabled = false;
+  bool applied = false;
+  u64 userSleep = 0;
+} g_pad_sleep_fallback;
+
+// g_cfg as the user configured it, without the thermal limits and the pad
+// sleep fallback. Whatever is written to disk must come from here
+static std::string userConfigString() {
+  std::scoped_lock lock(g_thermal_baseline.mutex, g_pad_sleep_fallback.mutex);
+  const auto &baseline = g_thermal_baseline;
+  const auto &fallback = g_pad_sleep_fallback;
+  auto config = g_cfg.to_string();
+
+  if (!baseline.captured && !fallback.applied) {
+    return config;
+  }
+
+  cfg_root user;
+  user.from_string(config);
+
+  if (baseline.captured) {
+    user.core.preferred_spu_threads.set(baseline.spuThreads);
+    user.video.frame_limit.set(baseline.frameLimit);
+    user.core.llvm_threads.set(baseline.compileThreads);
+  }
+
+  if (fallback.applied) {
+    user.io.pad_sleep.set(fallback.userSleep);
+  }
+
+  return user.to_string();
+}
+
+// Called with reloaded = true once g_cfg holds the user's config again
+static void updatePadSleepFallback(bool reloaded) {
+  std::lock_guard lock(g_pad_sleep_fallback.mutex);
+  auto &fallback = g_pad_sleep_fallback;
+
+  if (reloaded) {
+    fallback.applied = false;
+  }
+
+  if (fallback.enabled && !fallback.applied) {
+    fallback.userSleep = g_cfg.io.pad_sleep.get();
+    g_cfg.io.pad_sleep.set(std::max(fallback.userSleep, kFallbackPadSleepUs));
+    fallback.applied = true;
+  } else if (!fallback.enabled && fallback.applied) {
+    g_cfg.io.pad_sleep.set(fallback.userSleep);
+    fallback.applied = false;
+  }
+}
+
+// Emu.BootGame reloads g_cfg. The governor must not apply limits while that
+// happens, they would end up as the user's settings in the baseline
+static game_boot_result
+bootWithThermalLimits(const std::function<game_boot_result()> &boot) {
+  g_thermal_governor.pause();
+  const auto result = boot();
+
+  {
+    std::lock_guard lock(g_thermal_baseline.mutex);
+    g_thermal_baseline.captured = false;
+  }
+
+  g_thermal_governor.resume();
+  return result;
+}
+
+// A boot with a config override leaves it in g_cfg until the next boot, where
+// save_emu_settings could persist it. Puts the user's config back once such a
+// run is over
+static void restoreUserConfig(const std::string &config) {
+  {
+    std::lock_guard lock(g_thermal_baseline.mutex);
+    g_thermal_baseline.captured = false;
+    g_cfg.from_string(config);
+  }
+
+  updatePadSleepFallback(true);
+}
+
+// Serializes everything which drives the global Emu. Compile jobs and the
+// benchmark hold it until they are done, a boot only while it starts
+static std::mutex g_emu_mutex;
+
+// Set while runBenchmark drives a headless run
+static std::atomic<BenchmarkRecorder *> g_benchmark;
+static UsbDeviceRegistry g_usb_devices;
+static InputEventMonitor g_input_monitor;
+
+// Set while the pad thread can be woken. on_stop clears it before Kill joins
+// the emulator threads and resets g_fxo, the monitor thread holds the mutex
+// while it wakes the pad thread
+static std::mutex g_pad_wake_mutex;
+static bool g_pad_wake_enabled;
+
+static void setPadWakeEnabled(bool enabled) {
+  std::lock_guard lock(g_pad_wake_mutex);
+  g_pad_wake_enabled = enabled;
+}
+
+// PKGs mounted in place, for this session only
+static std::mutex g_pkg_mounts_mutex;
+static std::vector<std::shared_ptr<PkgDevice>> g_pkg_mounts;
+
+// Compressed disc images mounted so far, keyed by image path
+static std::mutex g_disc_images_mutex;
+static std::unordered_map<std::string, std::shared_ptr<DiscImageDevice>>
+    g_disc_images;
+
+static std::optional<GameIndex> g_game_index;
 
 extern std::string g_android_executable_dir;
 extern std::string g_android_config_dir;
@@ -75,49 +243,17 @@ extern std::string g_android_cache_dir;
 
 LOG_CHANNEL(rpcs3_android, "ANDROID");
 
-struct LogListener : logs::listener {
-  LogListener() { logs::listener::add(this); }
-
-  void log(u64 stamp, const logs::message &msg, const std::string &prefix,
-           const std::string &text) override {
-    int prio = 0;
-    switch (static_cast<logs::level>(msg)) {
-    case logs::level::always:
-    case logs::level::fatal:
-      prio = ANDROID_LOG_FATAL;
-      break;
-    case logs::level::error:
-      prio = ANDROID_LOG_ERROR;
-      break;
-    case logs::level::todo:
-      prio = ANDROID_LOG_WARN;
-      break;
-    case logs::level::success:
-      prio = ANDROID_LOG_INFO;
-      break;
-    case logs::level::warning:
-      prio = ANDROID_LOG_WARN;
-      break;
-    case logs::level::notice:
-      prio = ANDROID_LOG_DEBUG;
-      break;
-    case logs::level::trace:
-      prio = ANDROID_LOG_VERBOSE;
-      break;
-    }
-
-    __android_log_write(prio, "RPCS3", text.c_str());
-  }
-} static g_androidLogListener;
+// Never destroyed, emulator threads may still log during process teardown
+static AndroidLogSink &g_androidLogListener = *new AndroidLogSink();
+static BinaryLogListener &g_binaryLogListener = *new BinaryLogListener();
 
 struct GraphicsFrame : GSFrameBase {
-  static ANativeWindow *getNativeWindow() {
-    ANativeWindow *result;
-    while ((result = g_native_window.load()) == nullptr) [[unlikely]] {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-    return result;
+  static u64 steadyClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
   }
+
   void close() override {}
   void reset() override {}
   bool shown() override { return true; }
@@ -128,25 +264,53 @@ struct GraphicsFrame : GSFrameBase {
   void delete_context(draw_context_t ctx) override {}
   draw_context_t make_context() override { return nullptr; }
   void set_current(draw_context_t ctx) override {}
-  void flip(draw_context_t ctx, bool skip_frame = false) override {}
+  void flip(draw_context_t ctx, bool skip_frame = false) override {
+    if (skip_frame) {
+      return;
+    }
+
+    const u64 now = steadyClockNs();
+    g_telemetry.onFrame(now);
+    g_input_monitor.onFrame(now);
+
+    if (auto benchmark = g_benchmark.load()) {
+      benchmark->onFrame(now);
+      return;
+    }
+
+    if (const u64 start = g_frame_pacer.onFrame(now); start > now) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(start - now));
+    }
+  }
+  // Benchmarks run without a surface, nothing may wait for one
+  static bool headless() { return g_benchmark.load() != nullptr; }
+
   int client_width() override {
-    return ANativeWindow_getWidth(getNativeWindow());
+    return headless() ? 1280 : g_surface.wait().width;
   }
   int client_height() override {
-    return ANativeWindow_getHeight(getNativeWindow());
+    return headless() ? 720 : g_surface.wait().height;
   }
-  f64 client_display_rate() override { return 30.f; }
+  f64 client_display_rate() override { return g_frame_pacer.refreshRate(); }
   bool has_alpha() override {
-    return ANativeWindow_getFormat(getNativeWindow()) ==
-           WINDOW_FORMAT_RGBA_8888;
+    return !headless() && g_surface.wait().format == WINDOW_FORMAT_RGBA_8888;
   }
 
-  display_handle_t handle() const override { return getNativeWindow(); }
+  display_handle_t handle() const override {
+    return headless() ? nullptr : g_surface.acquire().window;
+  }
 
-  bool can_consume_frame() const override { return false; }
+  // Renderers read the frame back only while a consumer is attached and its
+  // rate limit allows another frame
+  bool can_consume_frame() const override {
+    return g_frame_consumer.wantsFrame(steadyClockNs());
+  }
 
   void present_frame(std::vector<u8> &data, u32 pitch, u32 width, u32 height,
-                     bool is_bgra) const override {}
+                     bool is_bgra) const override {
+    g_frame_consumer.submit(data.data(), pitch, width, height, is_bgra,
+                            steadyClockNs());
+  }
 
   void take_screenshot(const std::vector<u8> sshot_data, u32 sshot_width,
                        u32 sshot_height, bool is_bgra) override {}
@@ -481,39 +645,283 @@ static std::pair<std::string, std::u32string> g_strings[] = {
     MAKE_STRING(INVALID, "Invalid"),
 };
 
+// Classes and method ids used to call back into Kotlin, resolved once in
+// JNI_OnLoad and kept as global references. FindClass only sees application
+// classes on threads started from Java, so native threads depend on these.
+static struct JniBindings {
+  jclass progressRepository;
+  jmethodID onProgressEvent;
+
+  jclass gameRepository;
+  jmethodID gameRepositoryAdd;
+  jmethodID gameRepositoryRemovePaths;
+
+  jclass gameInfo;
+  jmethodID gameInfoConstructor;
+
+  jclass firmwareRepository;
+  jmethodID onFirmwareInstalled;
+  jmethodID onFirmwareCompiled;
+
+  jclass string;
+} g_jni;
+
+static JavaVM *g_jvm;
+
+static bool bindJni(JNIEnv *env) {
+  auto findClass = [env](const char *name) -> jclass {
+    auto local = env->FindClass(name);
+    if (local == nullptr) {
+      return nullptr;
+    }
+
+    auto global = static_cast<jclass>(env->NewGlobalRef(local));
+    env->DeleteLocalRef(local);
+    return global;
+  };
+
+  g_jni.progressRepository = findClass("net/rpcs3/ProgressRepository");
+  g_jni.gameRepository = findClass("net/rpcs3/GameRepository");
+  g_jni.gameInfo = findClass("net/rpcs3/GameInfo");
+  g_jni.firmwareRepository = findClass("net/rpcs3/FirmwareRepository");
+  g_jni.string = findClass("java/lang/String");
+
+  if (!g_jni.progressRepository || !g_jni.gameRepository || !g_jni.gameInfo ||
+      !g_jni.firmwareRepository || !g_jni.string) {
+    return false;
+  }
+
+  g_jni.onProgressEvent =
+      env->GetStaticMethodID(g_jni.progressRepository, "onProgressEvent",
+                             "(JJJLjava/lang/String;)Z");
+  g_jni.gameRepositoryAdd = env->GetStaticMethodID(
+      g_jni.gameRepository, "add", "([Lnet/rpcs3/GameInfo;J)V");
+  g_jni.gameRepositoryRemovePaths = env->GetStaticMethodID(
+      g_jni.gameRepository, "removePaths", "([Ljava/lang/String;)V");
+  g_jni.gameInfoConstructor = env->GetMethodID(
+      g_jni.gameInfo, "<init>",
+      "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
+  g_jni.onFirmwareInstalled =
+      env->GetStaticMethodID(g_jni.firmwareRepository, "onFirmwareInstalled",
+                             "(Ljava/lang/String;)V");
+  g_jni.onFirmwareCompiled =
+      env->GetStaticMethodID(g_jni.firmwareRepository, "onFirmwareCompiled",
+                             "(Ljava/lang/String;)V");
+
+  return g_jni.onProgressEvent && g_jni.gameRepositoryAdd &&
+         g_jni.gameRepositoryRemovePaths &&
+         g_jni.gameInfoConstructor && g_jni.onFirmwareInstalled &&
+         g_jni.onFirmwareCompiled;
+}
+
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *) {
+  JNIEnv *env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+    return JNI_ERR;
+  }
+
+  if (!bindJni(env)) {
+    __android_log_write(ANDROID_LOG_FATAL, "RPCS3",
+                        "Failed to resolve Kotlin callbacks");
+    return JNI_ERR;
+  }
+
+  g_jvm = vm;
+  return JNI_VERSION_1_6;
+}
+
+// Rate at which progress updates are forwarded to ProgressRepository
+static atomic_t<u32> g_progress_rate_hz = 30;
+
+class Progress;
+
+// Forwards the progress of every running operation to ProgressRepository at
+// g_progress_rate_hz. A single thread attached to the JVM serves all of them,
+// it is started on first use and sleeps while nothing is running.
+class ProgressDispatcher {
+public:
+  void add(Progress *progress);
+
+  // Once this returns the dispatcher no longer touches progress
+  void remove(Progress *progress);
+
+private:
+  void run();
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<Progress *> active;
+  bool started = false;
+};
+
+static ProgressDispatcher g_progress_dispatcher;
+
+// Progress of a single operation. report() only stores the latest value, max
+// and message into a lock-free slot, g_progress_dispatcher forwards it to
+// ProgressRepository. Installers never wait for Kotlin or the UI thread, and
+// a cancel from the UI side comes back as a flag. start() and the terminal
+// states are delivered synchronously on the owner thread.
+//
+// The slot is a seqlock, report() must only be called from one thread.
 class Progress {
+  friend class ProgressDispatcher;
+
   JNIEnv *env;
   jlong progressId;
-  jclass progressRepositoryClass;
-  jmethodID onProgressEventMethodId;
+
+  atomic_t<u64> sequence = 0;
+  atomic_t<jlong> value = 0;
+  atomic_t<jlong> max = 0;
+  std::atomic<std::string *> message = nullptr;
+  atomic_t<bool> cancelled = false;
+
+  // Owned by whoever flushes: the dispatcher while registered, otherwise the
+  // owner
+  u64 sentSequence = 0;
+
+  void store(jlong newValue, jlong newMax, const std::string &newMessage) {
+    if (!newMessage.empty()) {
+      delete message.exchange(new std::string(newMessage));
+    }
+
+    sequence++;
+    value = newValue;
+    max = newMax;
+    sequence++;
+  }
+
+  void flush(JNIEnv *flushEnv) {
+    u64 flushSequence;
+    jlong flushValue, flushMax;
+
+    do {
+      flushSequence = sequence;
+      flushValue = value;
+      flushMax = max;
+    } while ((flushSequence & 1) || flushSequence != sequence);
+
+    if (flushSequence == sentSequence) {
+      return;
+    }
+
+    sentSequence = flushSequence;
+
+    std::unique_ptr<std::string> flushMessage(message.exchange(nullptr));
+    jstring jmessage =
+        flushMessage ? wrap(flushEnv, *flushMessage) : nullptr;
+
+    if (!flushEnv->CallStaticBooleanMethod(
+            g_jni.progressRepository, g_jni.onProgressEvent, progressId,
+            flushValue, flushMax, jmessage)) {
+      cancelled = true;
+    }
+
+    if (flushEnv->ExceptionCheck()) {
+      flushEnv->ExceptionDescribe();
+      flushEnv->ExceptionClear();
+      cancelled = true;
+    }
+
+    if (jmessage != nullptr) {
+      flushEnv->DeleteLocalRef(jmessage);
+    }
+  }
+
+  void finish(jlong newValue, jlong newMax, const std::string &newMessage) {
+    store(newValue, newMax, newMessage);
+    g_progress_dispatcher.remove(this);
+    flush(env);
+  }
 
 public:
-  Progress(JNIEnv *env, jlong progressId) : env(env), progressId(progressId) {
-    progressRepositoryClass =
-        ensure(env->FindClass("net/rpcs3/ProgressRepository"));
-    onProgressEventMethodId = env->GetStaticMethodID(
-        progressRepositoryClass, "onProgressEvent", "(JJJLjava/lang/String;)Z");
+  Progress(JNIEnv *env, jlong progressId) : env(env), progressId(progressId) {}
+
+  Progress(const Progress &) = delete;
+  Progress &operator=(const Progress &) = delete;
+
+  ~Progress() {
+    // Deliver whatever was reported last
+    g_progress_dispatcher.remove(this);
+    flush(env);
+    delete message.exchange(nullptr);
+  }
+
+  // Reports the operation as started and hands further reports to the
+  // dispatcher. Returns false when ProgressRepository does not know the id
+  // or the operation was already cancelled.
+  bool start() {
+    store(0, 0, {});
+    flush(env);
+
+    if (cancelled) {
+      return false;
+    }
+
+    g_progress_dispatcher.add(this);
+    return true;
   }
 
+  // Returns false once the operation was cancelled
   bool report(jlong value, jlong max, const std::string &message = {}) {
-    return env->CallStaticBooleanMethod(
-        progressRepositoryClass, onProgressEventMethodId, progressId, value,
-        max, message.empty() ? nullptr : wrap(env, message));
+    store(value, max, message);
+    return !cancelled;
   }
 
-  void failure(const std::string &message = {}) { report(-1, 0, message); }
+  bool isCancelled() const { return cancelled; }
+
+  void failure(const std::string &message = {}) { finish(-1, 0, message); }
 
   void success(jlong value, const std::string &message = {}) {
     value = std::max<jlong>(value, 1);
-    report(value, value, message);
+    finish(value, value, message);
   }
 };
 
-struct GameInfo {
-  std::string path;
-  std::string name;
-  std::string iconPath;
-};
+void ProgressDispatcher::add(Progress *progress) {
+  {
+    std::lock_guard lock(mutex);
+    active.push_back(progress);
+
+    if (!started) {
+      started = true;
+
+      // Detached and never stopped, it is idle without active operations
+      std::thread([this] { run(); }).detach();
+    }
+  }
+
+  cv.notify_one();
+}
+
+void ProgressDispatcher::remove(Progress *progress) {
+  // Flushes happen under the mutex, so none is in flight once it is taken
+  std::lock_guard lock(mutex);
+  std::erase(active, progress);
+}
+
+void ProgressDispatcher::run() {
+  JNIEnv *env = nullptr;
+  JavaVMAttachArgs args{JNI_VERSION_1_6, "Progress", nullptr};
+
+  if (g_jvm->AttachCurrentThread(&env, &args) != JNI_OK) {
+    rpcs3_android.error("Progress: failed to attach dispatcher thread");
+    return;
+  }
+
+  std::unique_lock lock(mutex);
+
+  while (true) {
+    cv.wait(lock, [this] { return !active.empty(); });
+
+    const auto period = std::chrono::microseconds(
+        1'000'000 / std::max<u32>(g_progress_rate_hz, 1));
+    cv.wait_for(lock, period, [this] { return active.empty(); });
+
+    for (auto progress : active) {
+      progress->flush(env);
+    }
+  }
+}
 
 static void setupCallbacks() {
   Emu.SetCallbacks({
@@ -524,10 +932,19 @@ static void setupCallbacks() {
               *wake_up = true;
             }
           },
-      .on_run = [](auto...) {},
-      .on_pause = [](auto...) {},
-      .on_resume = [](auto...) {},
-      .on_stop = [](auto...) {},
+      .on_run =
+          [](auto...) {
+            updatePadSleepFallback(true);
+            setPadWakeEnabled(true);
+            g_thread_placer.activate();
+          },
+      .on_pause = [](auto...) { g_thread_placer.deactivate(); },
+      .on_resume = [](auto...) { g_thread_placer.activate(); },
+      .on_stop =
+          [](auto...) {
+            setPadWakeEnabled(false);
+            g_thread_placer.deactivate();
+          },
       .on_ready = [](auto...) {},
       .on_missing_fw = [](auto...) {},
       .on_emulation_stop_no_response = [](auto...) {},
@@ -553,7 +970,7 @@ static void setupCallbacks() {
       .update_emu_settings = [](auto...) {},
       .save_emu_settings =
           [](auto...) {
-            Emulator::SaveSettings(g_cfg.to_string(), Emu.GetTitleID());
+            Emulator::SaveSettings(userConfigString(), Emu.GetTitleID());
           },
       .close_gs_frame = [](auto...) {},
       .get_gs_frame = [] { return std::make_unique<GraphicsFrame>(); },
@@ -576,7 +993,11 @@ static void setupCallbacks() {
             }
           },
       .get_audio =
-          [](auto...) {
+          [](auto...) -> std::shared_ptr<AudioBackend> {
+            if (g_cfg.audio.renderer.get() == audio_renderer::null) {
+              return std::make_shared<NullAudioBackend>();
+            }
+
             std::shared_ptr<AudioBackend> result =
                 std::make_shared<CubebBackend>();
             if (!result->Initialized()) {
@@ -631,6 +1052,46 @@ static void setupCallbacks() {
   });
 }
 
+static void applyThermalTunables(const ThermalTunables &tunables) {
+  std::lock_guard lock(g_thermal_baseline.mutex);
+  auto &baseline = g_thermal_baseline;
+
+  if (!baseline.captured) {
+    if (tunables == ThermalTunables{}) {
+      return;
+    }
+
+    baseline.spuThreads = g_cfg.core.preferred_spu_threads.get();
+    baseline.frameLimit = g_cfg.video.frame_limit.get();
+    baseline.compileThreads = g_cfg.core.llvm_threads.get();
+    baseline.captured = true;
+  }
+
+  const auto frameLimit = [&] {
+    switch (tunables.frameLimit) {
+    case 30:
+      return frame_limit_type::_30;
+    case 50:
+      return frame_limit_type::_50;
+    case 60:
+      return frame_limit_type::_60;
+    default:
+      return baseline.frameLimit;
+    }
+  }();
+
+  g_cfg.core.preferred_spu_threads.set(
+      tunables.spuThreads != 0 ? tunables.spuThreads : baseline.spuThreads);
+  g_cfg.video.frame_limit.set(frameLimit);
+  g_cfg.core.llvm_threads.set(tunables.compileThreads != 0
+                                  ? tunables.compileThreads
+                                  : baseline.compileThreads);
+
+  if (tunables == ThermalTunables{}) {
+    baseline.captured = false;
+  }
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_net_rpcs3_RPCS3_initialize(JNIEnv *env, jobject, jstring rootDir) {
   auto rootDirStr = fix_dir_path(unwrap(env, rootDir));
@@ -688,6 +1149,99 @@ Java_net_rpcs3_RPCS3_initialize(JNIEnv *env, jobject, jstring rootDir) {
     set_rlim(RLIMIT_NOFILE, 0x10000);
     set_rlim(RLIMIT_STACK, 128 * 1024 * 1024);
 
+    g_game_index.emplace(g_android_cache_dir + "games.idx");
+
+    // Frames nobody reads are the cheapest thing to give back
+    g_cache_registry.add(
+        "frame consumer buffers", 0,
+        [] { return g_frame_consumer.memoryUsage(); },
+        [](u64) { return g_frame_consumer.trim(); });
+
+    g_cache_registry.add(
+        "disc image blocks", 1,
+        [] {
+          std::lock_guard lock(g_disc_images_mutex);
+          u64 size = 0;
+          for (auto &[path, device] : g_disc_images) {
+            size += device->image()->cacheMemory();
+          }
+          return size;
+        },
+        [](u64 bytes) {
+          std::lock_guard lock(g_disc_images_mutex);
+          u64 freed = 0;
+          for (auto &[path, device] : g_disc_images) {
+            if (freed < bytes) {
+              freed += device->image()->trimCache(bytes - freed);
+            }
+          }
+          return freed;
+        });
+
+    g_cache_registry.add(
+        "PKG mount blocks", 1,
+        [] {
+          std::lock_guard lock(g_pkg_mounts_mutex);
+          u64 size = 0;
+          for (auto &device : g_pkg_mounts) {
+            size += device->archive()->cacheMemory();
+          }
+          return size;
+        },
+        [](u64 bytes) {
+          std::lock_guard lock(g_pkg_mounts_mutex);
+          u64 freed = 0;
+          for (auto &device : g_pkg_mounts) {
+            if (freed < bytes) {
+              freed += device->archive()->trimCache(bytes - freed);
+            }
+          }
+          return freed;
+        });
+
+    // Keep the guest threads off the little cores of big.LITTLE SoCs
+    const auto topology = CpuTopology::detect();
+    rpcs3_android.notice("CPU topology: %s", topology.toString());
+    // Only polls while a title runs, see the Emu callbacks
+    g_thread_placer.start(AffinityPolicy::fromTopology(topology),
+                          std::chrono::milliseconds(100),
+                          std::chrono::seconds(5));
+
+    // Nothing can be presented without a window, keep the emulation paused
+    // until the surface comes back instead of failing in the renderer. A
+    // resize only updates the cached metrics, the renderer compares them with
+    // its swapchain on every flip.
+    g_surface.addListener([](SurfaceManager::Event event,
+                             const SurfaceManager::State &state) {
+      static std::atomic<bool> pausedBySurface = false;
+
+      if (event == SurfaceManager::Event::lost && Emu.IsRunning()) {
+        rpcs3_android.notice("Surface lost, pausing emulation");
+        Emu.Pause();
+        pausedBySurface = true;
+      } else if (event == SurfaceManager::Event::created &&
+                 pausedBySurface.exchange(false)) {
+        // The guest must not flip before the renderer rebuilt its swapchain
+        // on the new window, it would present to the lost one. Waited for
+        // off the UI thread, with a timeout in case the renderer only picks
+        // the window up once it runs again.
+        std::thread([generation = state.generation] {
+          if (!g_surface.waitAcquired(generation, std::chrono::seconds(1))) {
+            rpcs3_android.warning("Renderer did not take the new surface");
+          }
+
+          if (g_surface.state().window == nullptr) {
+            // Lost again in the meantime, resume with the next one
+            pausedBySurface = true;
+            return;
+          }
+
+          rpcs3_android.notice("Surface restored, resuming emulation");
+          Emu.Resume();
+        }).detach();
+      }
+    });
+
     setupCallbacks();
     Emu.SetHasGui(false);
     Emu.Init();
@@ -700,9 +1254,16 @@ Java_net_rpcs3_RPCS3_initialize(JNIEnv *env, jobject, jstring rootDir) {
     g_cfg.core.llvm_cpu.from_string("");
     // g_cfg.core.llvm_cpu.from_string(fallback_cpu_detection());
     Emulator::SaveSettings(g_cfg.to_string(), Emu.GetTitleID());
+
+    // Started after the settings were saved, the governor only changes them
+    // in memory
+    g_thermal_governor.start(ThermalSensor(), ThermalController(),
+                             applyThermalTunables, std::chrono::seconds(2));
   }
 
   std::filesystem::create_directories(g_android_config_dir);
+  g_binaryLogListener.open(g_android_config_dir + "logs/", true);
+
   std::error_code ec;
   // std::filesystem::remove_all(g_android_cache_dir, ec);
   std::filesystem::create_directories(g_android_cache_dir);
@@ -712,67 +1273,51 @@ Java_net_rpcs3_RPCS3_initialize(JNIEnv *env, jobject, jstring rootDir) {
 }
 
 static void sendFirmwareInstalled(JNIEnv *env, std::string version) {
-  auto fwRepositoryClass =
-      ensure(env->FindClass("net/rpcs3/FirmwareRepository"));
-  auto methodId = ensure(env->GetStaticMethodID(
-      fwRepositoryClass, "onFirmwareInstalled", "(Ljava/lang/String;)V"));
-
-  env->CallStaticVoidMethod(fwRepositoryClass, methodId, wrap(env, version));
+  auto jversion = wrap(env, version);
+  env->CallStaticVoidMethod(g_jni.firmwareRepository,
+                            g_jni.onFirmwareInstalled, jversion);
+  env->DeleteLocalRef(jversion);
 }
 
 static void sendFirmwareCompiled(JNIEnv *env, std::string version) {
-  auto fwRepositoryClass =
-      ensure(env->FindClass("net/rpcs3/FirmwareRepository"));
-  auto methodId = ensure(env->GetStaticMethodID(
-      fwRepositoryClass, "onFirmwareCompiled", "(Ljava/lang/String;)V"));
-
-  env->CallStaticVoidMethod(fwRepositoryClass, methodId, wrap(env, version));
+  auto jversion = wrap(env, version);
+  env->CallStaticVoidMethod(g_jni.firmwareRepository,
+                            g_jni.onFirmwareCompiled, jversion);
+  env->DeleteLocalRef(jversion);
 }
 
 static void sendGameInfo(JNIEnv *env, jlong progressId,
                          std::span<const GameInfo> infos) {
-  auto gameRepositoryClass = ensure(env->FindClass("net/rpcs3/GameRepository"));
-  auto addMethodId = ensure(env->GetStaticMethodID(
-      gameRepositoryClass, "add", "([Lnet/rpcs3/GameInfo;J)V"));
-  auto gameClass = ensure(env->FindClass("net/rpcs3/GameInfo"));
-
-  jmethodID gameConstructor = ensure(env->GetMethodID(
-      gameClass, "<init>",
-      "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V"));
-
-  std::vector<jobject> objects;
-  objects.reserve(infos.size());
-
-  for (const auto &info : infos) {
-    objects.push_back(env->NewObject(gameClass, gameConstructor,
-                                     wrap(env, info.path), wrap(env, info.name),
-                                     wrap(env, info.iconPath), nullptr));
+  // Everything created here is released with the frame, a batch never grows
+  // the caller's local reference table
+  if (env->PushLocalFrame(8) != JNI_OK) {
+    rpcs3_android.error("sendGameInfo: failed to push local frame");
+    return;
   }
 
-  auto result = env->NewObjectArray(objects.size(), gameClass, nullptr);
-
-  for (std::size_t i = 0; i < objects.size(); ++i) {
-    env->SetObjectArrayElement(result, i, objects[i]);
+  if (auto result = makeGameInfoArray(env, g_jni.gameInfo,
+                                      g_jni.gameInfoConstructor, infos)) {
+    env->CallStaticVoidMethod(g_jni.gameRepository, g_jni.gameRepositoryAdd,
+                              result, progressId);
   }
 
-  env->CallStaticVoidMethod(gameRepositoryClass, addMethodId, result,
-                            progressId);
+  env->PopLocalFrame(nullptr);
 }
 
-static void collectGamePaths(std::vector<std::string> &paths,
-                             const std::string &rootDir) {
-  std::error_code ec;
-  for (auto entry :
-       std::filesystem::recursive_directory_iterator(rootDir, ec)) {
-    if (!entry.is_directory()) {
-      continue;
-    }
+// Retracts titles which were listed before but are gone or no longer bootable
+static void sendRemovedGames(JNIEnv *env,
+                             const std::vector<std::string> &paths) {
+  if (env->PushLocalFrame(4) != JNI_OK) {
+    rpcs3_android.error("sendRemovedGames: failed to push local frame");
+    return;
+  }
 
-    if (std::filesystem::is_regular_file(entry.path() / "PARAM.SFO")) {
-      paths.push_back(entry.path().string());
-      continue;
-    }
+  if (auto result = makeStringArray(env, g_jni.string, paths)) {
+    env->CallStaticVoidMethod(g_jni.gameRepository,
+                              g_jni.gameRepositoryRemovePaths, result);
   }
+
+  env->PopLocalFrame(nullptr);
 }
 
 static std::optional<GameInfo> parsePsf(std::string path,
@@ -808,156 +1353,1097 @@ static std::optional<GameInfo> parsePsf(std::string path,
   };
 }
 
-static void collectGameInfo(JNIEnv *env, jlong progressId,
-                            std::vector<std::string> rootDirs) {
-  std::vector<std::string> paths;
-  for (auto &&rootDir : rootDirs) {
-    collectGamePaths(paths, rootDir);
-
-    rpcs3_android.notice("collectGameInfo: processed %s", rootDir);
-  }
-
-  rpcs3_android.notice("collectGameInfo: found %d paths", paths.size());
-
-  Progress progress(env, progressId);
-  progress.report(0, paths.size());
-
-  std::vector<GameInfo> gameInfos;
-  gameInfos.reserve(10);
-  std::size_t processed = 0;
-
-  auto submit = [&] {
-    if (gameInfos.empty()) {
-      return;
-    }
+static std::shared_ptr<PkgDevice> findPkgMount(const std::string &root) {
+  std::lock_guard lock(g_pkg_mounts_mutex);
 
-    sendGameInfo(env, progressId, gameInfos);
-    progress.report(processed, paths.size());
-    gameInfos.clear();
-  };
-
-  for (auto &&path : paths) {
-    processed++;
-
-    if (!std::filesystem::is_regular_file(path + "/PARAM.SFO")) {
-      continue;
+  for (auto &device : g_pkg_mounts) {
+    if (device->root() == root) {
+      return device;
     }
+  }
 
-    const auto psf = psf::load_object(path + "/PARAM.SFO");
+  return nullptr;
+}
 
-    rpcs3_android.notice("collectGameInfo: sfo at %s", path);
+// The UI loads icons from the host filesystem, icons of archives are copied
+// out once. loadIcon is only called when there is no copy yet. Returns the
+// copy, or nothing when there is no icon
+static std::string
+cacheArchiveIcon(const std::string &name,
+                 const std::function<std::vector<u8>()> &loadIcon) {
+  const std::string iconDir = g_android_cache_dir + "archive-icons/";
+  const std::string cachedPath = iconDir + name + ".PNG";
+
+  if (fs::is_file(cachedPath)) {
+    return cachedPath;
+  }
 
-    if (auto gameInfo = parsePsf(path, psf)) {
-      gameInfos.push_back(std::move(*gameInfo));
+  const auto icon = loadIcon();
+  fs::create_path(iconDir);
 
-      if (gameInfos.size() >= 10) {
-        submit();
-      }
-    }
+  if (fs::pending_file file(cachedPath);
+      icon.empty() || !file.file ||
+      file.file.write(icon.data(), icon.size()) != icon.size() ||
+      !file.commit()) {
+    rpcs3_android.warning("collectGameInfo: no icon for %s", name);
+    return {};
   }
 
-  submit();
-  progress.success(paths.size());
+  return cachedPath;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_collectGameInfo(
-    JNIEnv *env, jobject, jstring jrootDir, jlong progressId) {
+// Lists a mounted PKG like an installed title
+static std::optional<GameInfo> collectPkgMount(const PkgDevice &device) {
+  const std::string root = device.root();
+  const auto &contentId = device.archive()->contentId();
+  auto info = parsePsf(root, psf::load_object(root + "PARAM.SFO"));
 
-  collectGameInfo(env, progressId, {unwrap(env, jrootDir)});
-  return true;
-}
+  if (!info) {
+    rpcs3_android.warning("collectGameInfo: %s is not a bootable title",
+                          contentId);
+    return {};
+  }
 
-extern "C" JNIEXPORT void JNICALL Java_net_rpcs3_RPCS3_shutdown(JNIEnv *env,
-                                                                jobject) {
-  Emu.GracefulShutdown(true, true, false);
+  info->iconPath =
+      contentId.empty()
+          ? std::string()
+          : cacheArchiveIcon(contentId, [&] {
+              return fs::file(root + "ICON0.PNG").to_vector<u8>();
+            });
+  return info;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_boot(JNIEnv *env,
-                                                                jobject,
-                                                                jstring jpath) {
-  Emu.SetForceBoot(true);
-  auto path = unwrap(env, jpath);
-  while (path.ends_with('/')) {
-    path.pop_back();
+static u64 pathHash(std::string_view path) {
+  // FNV-1a
+  u64 hash = 0xcbf29ce484222325;
+  for (char c : path) {
+    hash = (hash ^ static_cast<u8>(c)) * 0x100000001b3;
   }
-  Emu.BootGame(path, "", false, cfg_mode::global);
-  return true;
+
+  return hash;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_surfaceEvent(
-    JNIEnv *env, jobject, jobject surface, jint event) {
-  rpcs3_android.warning("surface event %p, %d", surface, event);
+// Mounts the image when a title in it is booted or compiled, the device is
+// kept for the session. An image which changed on disk is mounted again
+static std::shared_ptr<DiscImageDevice>
+mountDiscImage(const std::string &path) {
+  std::lock_guard lock(g_disc_images_mutex);
 
-  if (event == 2) {
-    auto prevWindow = g_native_window.exchange(nullptr);
-    if (prevWindow != nullptr) {
-      ANativeWindow_release(prevWindow);
-    }
-  } else if (event == 0) {
-    auto newWindow = ANativeWindow_fromSurface(env, surface);
+  struct stat image_stat;
+  if (::stat(path.c_str(), &image_stat) != 0) {
+    rpcs3_android.error("mountDiscImage: %s not found", path);
+    return nullptr;
+  }
 
-    if (newWindow == nullptr) {
-      rpcs3_android.fatal("returned native window is null, surface %p",
-                          surface);
-      return false;
+  const auto it = g_disc_images.find(path);
+  if (it != g_disc_images.end()) {
+    if (it->second->image()->mtime() == image_stat.st_mtime) {
+      return it->second;
     }
 
-    auto prevWindow = g_native_window.exchange(newWindow);
-
-    if (newWindow != prevWindow) {
-      ANativeWindow_acquire(newWindow);
+    // Replaced on disk, the stale device would stay registered for the rest
+    // of the session otherwise
+    ArchiveDevice::unmount(*it->second);
+    g_disc_images.erase(it);
+  }
 
-      if (prevWindow != nullptr) {
-        ANativeWindow_release(prevWindow);
-      }
-    }
+  std::string error;
+  auto image = DiscImage::open(path, DiscImage::kDefaultCacheBytes, &error);
+  if (!image) {
+    rpcs3_android.error("mountDiscImage: %s: %s", path, error);
+    return nullptr;
   }
 
-  return true;
+  auto device = std::make_shared<DiscImageDevice>(std::move(image));
+  ArchiveDevice::mount(device);
+  g_disc_images[path] = device;
+  return device;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL
-Java_net_rpcs3_RPCS3_usbDeviceEvent(JNIEnv *env, jobject, jint fd, jint event) {
-  rpcs3_android.warning("usb device event %d, %d", fd, event);
+// Lists the title inside a compressed disc image. A scan only opens the image
+// to read PARAM.SFO and the icon, it is mounted once the title is booted or
+// compiled (resolveDiscImage). The image path is the game path, so the list
+// survives restarts
+static std::optional<GameInfo> parseDiscImage(const std::string &path) {
+  // Both files are small, a single cached block is enough
+  std::string error;
+  const auto image = DiscImage::open(path, 0, &error);
+  if (!image) {
+    rpcs3_android.error("parseDiscImage: %s: %s", path, error);
+    return {};
+  }
 
-  {
-    std::lock_guard<std::mutex> lock(g_android_usb_devices_mutex);
-
-    if (event == 0) {
-      g_android_usb_devices.push_back(fd);
-    } else {
-      if (auto it = std::ranges::find(g_android_usb_devices, fd);
-          it != g_android_usb_devices.end()) {
-        g_android_usb_devices.erase(it);
+  const auto readFile = [&](const std::string &name) {
+    std::vector<u8> data;
+
+    for (auto &file : image->files()) {
+      if (!file.directory && file.name == name) {
+        data.resize(file.size);
+        data.resize(image->read(file, 0, data.data(), data.size()));
+        break;
       }
     }
-  }
 
-  {
-    auto list = [](auto handler, std::string name) {
-      rpcs3_android.warning("going to enumerate %s pads", name);
-      handler.Init();
-    };
+    return data;
+  };
 
-    list(ds3_pad_handler(), "ds3");
-    list(ds4_pad_handler(), "ds4");
-    list(dualsense_pad_handler(), "dualsense");
+  // Disc dumps keep the title in PS3_GAME, game folders at the root
+  std::string titleDir;
+  auto sfo = readFile("PS3_GAME/PARAM.SFO");
+
+  if (!sfo.empty()) {
+    titleDir = "PS3_GAME/";
+  } else {
+    sfo = readFile("PARAM.SFO");
   }
 
-  // FIXME
-  g_cfg_input.player1.handler.set(pad_handler::dualsense);
+  auto info = parsePsf(
+      path, psf::load_object(fs::make_stream(std::move(sfo)), "PARAM.SFO"));
+  if (!info) {
+    return {};
+  }
+
+  info->iconPath = cacheArchiveIcon(fmt::format("%016x", pathHash(path)), [&] {
+    return readFile(titleDir + "ICON0.PNG");
+  });
+  return info;
+}
+
+static std::optional<GameInfo> parseGamePath(const std::string &path) {
+  if (path.ends_with(discimg::kExtension)) {
+    rpcs3_android.notice("collectGameInfo: disc image at %s", path);
+    return parseDiscImage(path);
+  }
+
+  rpcs3_android.notice("collectGameInfo: sfo at %s", path);
+  return parsePsf(path, psf::load_object(path + "/PARAM.SFO"));
+}
+
+// Scans the roots for titles which are new, modified or gone since the
+// previous scan and forwards the changes to the UI. known are the paths the
+// UI was given from the index
+static void verifyGameInfo(JNIEnv *env, jlong progressId,
+                           const std::vector<std::string> &rootDirs,
+                           const std::unordered_set<std::string> &known) {
+  Progress progress(env, progressId);
+  if (!progress.start()) {
+    return;
+  }
+
+  std::vector<GameInfo> gameInfos;
+  gameInfos.reserve(10);
+
+  // Scanning and parsing happen on the scanner workers, this thread only
+  // forwards the results to the UI
+  std::mutex results_mutex;
+  std::condition_variable results_cv;
+  std::vector<GameInfo> results;
+  std::vector<std::string> paths;
+  std::unordered_set<std::string> bootable;
+  std::size_t processed = 0;
+  std::size_t parsed = 0;
+  bool done = false;
+
+  named_thread scanner("Game Scanner", [&] {
+    scanGamePaths(rootDirs, [&](GamePath &&path) {
+      auto entry = g_game_index->find(path.path, path.mtime, path.size);
+      bool changed = !entry;
+
+      if (changed) {
+        entry = GameIndex::Entry{
+            .mtime = path.mtime,
+            .size = path.size,
+            .info = parseGamePath(path.path),
+        };
+
+        g_game_index->update(path.path, *entry);
+      }
+
+      std::lock_guard lock(results_mutex);
+      paths.push_back(path.path);
+      processed++;
+      parsed += changed;
+
+      if (entry->info) {
+        bootable.insert(path.path);
+
+        if (changed || !known.contains(path.path)) {
+          results.push_back(std::move(*entry->info));
+          results_cv.notify_one();
+        }
+      }
+    });
+
+    std::lock_guard lock(results_mutex);
+    done = true;
+    results_cv.notify_one();
+  });
+
+  std::unique_lock lock(results_mutex);
+
+  while (true) {
+    // Give the scanner a moment to fill a batch before calling into Java
+    results_cv.wait_for(lock, std::chrono::milliseconds(100),
+                        [&] { return done || results.size() >= 10; });
+
+    // The total is unknown until the scan is over
+    const bool finished = done;
+    const auto reportProcessed = processed;
+    gameInfos.swap(results);
+    lock.unlock();
+
+    if (!gameInfos.empty()) {
+      sendGameInfo(env, progressId, gameInfos);
+      gameInfos.clear();
+    }
+
+    progress.report(reportProcessed, 0);
+
+    if (finished) {
+      break;
+    }
+
+    lock.lock();
+  }
+
+  scanner();
+
+  std::vector<std::string> removed;
+  for (auto &path : known) {
+    if (!bootable.contains(path)) {
+      removed.push_back(path);
+    }
+  }
+
+  if (!removed.empty()) {
+    sendRemovedGames(env, removed);
+  }
+
+  const std::unordered_set<std::string> seen(paths.begin(), paths.end());
+  for (auto &&rootDir : rootDirs) {
+    g_game_index->retain(rootDir, seen);
+    rpcs3_android.notice("collectGameInfo: processed %s", rootDir);
+  }
+
+  g_game_index->save();
+
+  rpcs3_android.notice("collectGameInfo: found %d paths, parsed %d PARAM.SFO "
+                       "files, %d titles removed",
+                       paths.size(), parsed, removed.size());
+  progress.success(paths.size());
+}
+
+// Lists the titles under rootDirs. What the index knows from the previous
+// scan is sent before this returns, the roots are verified on a background
+// thread which reports new, modified and removed titles and then finishes
+// the progress.
+static void collectGameInfo(JNIEnv *env, jlong progressId,
+                            std::vector<std::string> rootDirs) {
+  std::vector<GameInfo> gameInfos;
+  gameInfos.reserve(10);
+
+  auto submit = [&] {
+    if (gameInfos.empty()) {
+      return;
+    }
+
+    sendGameInfo(env, progressId, gameInfos);
+    gameInfos.clear();
+  };
+
+  // Mounted PKGs are not on the host filesystem and hold a single title,
+  // they are listed directly instead of being scanned
+  usz mounted = 0;
+  std::erase_if(rootDirs, [&](const std::string &rootDir) {
+    const auto device = findPkgMount(rootDir);
+    if (!device) {
+      return false;
+    }
+
+    if (auto info = collectPkgMount(*device)) {
+      gameInfos.push_back(std::move(*info));
+      mounted++;
+    }
+
+    return true;
+  });
+
+  submit();
+
+  if (rootDirs.empty()) {
+    Progress progress(env, progressId);
+    progress.success(mounted);
+    return;
+  }
+
+  std::unordered_set<std::string> known;
+  for (auto &&info : g_game_index->list(rootDirs)) {
+    known.insert(info.path);
+    gameInfos.push_back(std::move(info));
+
+    if (gameInfos.size() >= 10) {
+      submit();
+    }
+  }
+
+  submit();
+
+  // Detached, the caller only waits for the cached list. The index is
+  // locked internally, so scans of different roots may overlap
+  std::thread([progressId, rootDirs = std::move(rootDirs),
+               known = std::move(known)] {
+    JNIEnv *threadEnv = nullptr;
+    JavaVMAttachArgs args{JNI_VERSION_1_6, "Game Verifier", nullptr};
+
+    if (g_jvm->AttachCurrentThread(&threadEnv, &args) != JNI_OK) {
+      rpcs3_android.error("collectGameInfo: failed to attach verifier thread");
+      return;
+    }
+
+    verifyGameInfo(threadEnv, progressId, rootDirs, known);
+    g_jvm->DetachCurrentThread();
+  }).detach();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_collectGameInfo(
+    JNIEnv *env, jobject, jstring jrootDir, jlong progressId) {
+
+  collectGameInfo(env, progressId, {unwrap(env, jrootDir)});
+  return true;
+}
+
+extern "C" JNIEXPORT jstring JNICALL Java_net_rpcs3_RPCS3_mountPkg(JNIEnv *env,
+                                                                   jobject,
+                                                                   jint fd) {
+  // The caller closes its descriptor, the mount keeps a duplicate open
+  const int ownFd = ::dup(fd);
+  if (ownFd < 0) {
+    rpcs3_android.error("mountPkg: dup failed, errno %d", errno);
+    return nullptr;
+  }
+
+  auto archive = PkgArchive::open(fs::file::from_native_handle(ownFd));
+  if (!archive) {
+    rpcs3_android.error("mountPkg: failed to open the package");
+    return nullptr;
+  }
+
+  std::lock_guard lock(g_pkg_mounts_mutex);
+
+  // Picking the same package again reuses its mount, the new descriptor is
+  // closed with the archive
+  for (auto &mounted : g_pkg_mounts) {
+    if (mounted->archive()->contentId() == archive->contentId()) {
+      rpcs3_android.notice("mountPkg: %s is already mounted",
+                           archive->contentId());
+      return wrap(env, mounted->root());
+    }
+  }
+
+  auto device = std::make_shared<PkgDevice>(std::move(archive));
+  g_pkg_mounts.push_back(device);
+  return wrap(env, PkgDevice::mount(std::move(device)));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_net_rpcs3_RPCS3_shutdown(JNIEnv *env,
+                                                                jobject) {
+  Emu.GracefulShutdown(true, true, false);
+}
+
+// The game path of a disc image is the image file, the emulator boots the
+// root of its mount instead
+static bool resolveDiscImage(std::string &path) {
+  if (!path.ends_with(discimg::kExtension)) {
+    return true;
+  }
+
+  const auto device = mountDiscImage(path);
+  if (!device) {
+    return false;
+  }
+
+  path = device->root();
+  path.pop_back();
+  return true;
+}
+
+// Locks g_emu_mutex for a job which boots and stops the emulator itself.
+// Fails while another job holds it or a game is running, running games do not
+// hold the mutex
+static std::unique_lock<std::mutex> lockIdleEmu() {
+  std::unique_lock lock(g_emu_mutex, std::try_to_lock);
+
+  if (lock && !Emu.IsStopped()) {
+    lock.unlock();
+  }
+
+  return lock;
+}
+
+// Replays what earlier boots of the title read, or learns it on the first
+// boot. Traces are keyed by the FNV-1a hash of the boot path
+static void prefetchBoot(const std::string &path) {
+  // Mounted archives are read through their own block cache
+  if (fs::get_virtual_device(path)) {
+    return;
+  }
+
+  const std::string traceDir = g_android_cache_dir + "prefetch/";
+  const std::string tracePath =
+      traceDir + fmt::format("%016x.trace", pathHash(path));
+
+  // An old trace is dropped and this boot records a new one
+  const auto maxAge = std::chrono::duration_cast<std::chrono::seconds>(
+      BootTraceRecorder::kMaxTraceAge);
+  fs::stat_t info{};
+
+  if (fs::stat(tracePath, info) &&
+      std::time(nullptr) - info.mtime < maxAge.count()) {
+    if (auto trace = BootTrace::load(tracePath)) {
+      g_boot_prefetcher.start(std::move(*trace), 4);
+      return;
+    }
+  }
+
+  fs::create_path(traceDir);
+
+  // An EBOOT.BIN boots from the title's USRDIR, the rest of the title is
+  // read as well
+  std::string root = path;
+  if (fs::is_file(path)) {
+    root = fs::get_parent_dir(path);
+
+    if (root.ends_with("/USRDIR")) {
+      root = fs::get_parent_dir(root, 2);
+    }
+  }
+
+  g_boot_recorder.start({root, g_cfg_vfs.get_dev_flash()},
+                        std::chrono::seconds(20), [tracePath](BootTrace trace) {
+                          if (!trace.ranges.empty()) {
+                            trace.save(tracePath);
+                          }
+                        });
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_boot(JNIEnv *env,
+                                                                jobject,
+                                                                jstring jpath) {
+  // A new game replaces a running one, but not a compile job or a benchmark
+  std::unique_lock lock(g_emu_mutex, std::try_to_lock);
+  if (!lock) {
+    rpcs3_android.error("boot: the emulator is busy");
+    return false;
+  }
+
+  Emu.SetForceBoot(true);
+  auto path = unwrap(env, jpath);
+  while (path.ends_with('/')) {
+    path.pop_back();
+  }
+  if (!resolveDiscImage(path)) {
+    return false;
+  }
+  g_frame_pacer.reset();
+  prefetchBoot(path);
+  bootWithThermalLimits(
+      [&] { return Emu.BootGame(path, "", false, cfg_mode::global); });
+  return true;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_surfaceEvent(
+    JNIEnv *env, jobject, jobject surface, jint event) {
+  rpcs3_android.warning("surface event %p, %d", surface, event);
+
+  switch (event) {
+  case 0: {
+    auto window = ANativeWindow_fromSurface(env, surface);
+
+    if (window == nullptr) {
+      rpcs3_android.fatal("returned native window is null, surface %p",
+                          surface);
+      return false;
+    }
+
+    g_surface.onCreated(window);
+    break;
+  }
+
+  case 1:
+    g_surface.onChanged();
+    break;
+
+  case 2:
+    g_surface.onLost();
+    break;
+
+  default:
+    return false;
+  }
+
+  return true;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_net_rpcs3_RPCS3_displayEvent(
+    JNIEnv *, jobject, jfloat refreshRate, jlong vsyncTimeNanos) {
+  // Choreographer timestamps use CLOCK_MONOTONIC, same as steady_clock
+  g_frame_pacer.onVsync(vsyncTimeNanos, refreshRate);
+}
+
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_net_rpcs3_RPCS3_getFramePacingStats(JNIEnv *env, jobject) {
+  const auto stats = g_frame_pacer.stats();
+
+  // Keep in sync with RPCS3.getFramePacingStats
+  const jdouble values[] = {
+      stats.refreshRate,
+      static_cast<jdouble>(stats.frames),
+      static_cast<jdouble>(stats.missedDeadlines),
+      stats.averageFrameTimeMs,
+      stats.maxFrameTimeMs,
+      static_cast<jdouble>(stats.cadence),
+  };
+
+  auto result = env->NewDoubleArray(std::size(values));
+  env->SetDoubleArrayRegion(result, 0, std::size(values), values);
+  return result;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_net_rpcs3_RPCS3_trimMemory(JNIEnv *, jobject, jint level) {
+  const auto trimLevel = trimLevelFromAndroid(level);
+  if (!trimLevel) {
+    return 0;
+  }
+
+  return static_cast<jlong>(g_cache_registry.trim(*trimLevel).reclaimed);
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_net_rpcs3_RPCS3_getMemoryTrimStats(JNIEnv *env, jobject) {
+  const auto reclaimed = g_cache_registry.reclaimedPerLevel();
+
+  jlong values[kTrimLevelCount];
+  std::copy(reclaimed.begin(), reclaimed.end(), values);
+
+  auto result = env->NewLongArray(kTrimLevelCount);
+  env->SetLongArrayRegion(result, 0, kTrimLevelCount, values);
+  return result;
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_net_rpcs3_RPCS3_startTelemetry(JNIEnv *env, jobject, jint periodMs) {
+  if (periodMs <= 0) {
+    return nullptr;
+  }
+
+  g_telemetry.start(std::chrono::milliseconds(periodMs));
+
+  // The buffer lives as long as the library, see TelemetryPublisher for the
+  // layout
+  return env->NewDirectByteBuffer(g_telemetry.data(),
+                                  TelemetryPublisher::size());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_net_rpcs3_RPCS3_stopTelemetry(JNIEnv *,
+                                                                      jobject) {
+  g_telemetry.stop();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_net_rpcs3_RPCS3_configureFrameConsumer(JNIEnv *, jobject, jint maxRate,
+                                            jint scaleDivisor, jint format) {
+  if (maxRate < 0 || scaleDivisor <= 0 || format < 0) {
+    return false;
+  }
+
+  return g_frame_consumer.configure({
+      .maxRate = static_cast<u32>(maxRate),
+      .scaleDivisor = static_cast<u32>(scaleDivisor),
+      .format = static_cast<FrameConsumer::PixelFormat>(format),
+  });
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_net_rpcs3_RPCS3_disableFrameConsumer(JNIEnv *, jobject) {
+  g_frame_consumer.disable();
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_net_rpcs3_RPCS3_acquireFrame(JNIEnv *env, jobject, jint timeoutMs) {
+  const auto frame =
+      g_frame_consumer.acquire(std::chrono::milliseconds(timeoutMs));
+
+  if (frame == nullptr) {
+    return nullptr;
+  }
+
+  // Wraps the pooled buffer, it must not be used after releaseFrame()
+  return env->NewDirectByteBuffer(const_cast<u8 *>(frame->pixels.data()),
+                                  static_cast<jlong>(frame->pitch) *
+                                      frame->height);
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_net_rpcs3_RPCS3_getAcquiredFrameInfo(JNIEnv *env, jobject) {
+  const auto frame = g_frame_consumer.acquired();
+
+  if (frame == nullptr) {
+    return nullptr;
+  }
+
+  // Keep in sync with RPCS3.getAcquiredFrameInfo
+  const jlong values[] = {
+      frame->width,
+      frame->height,
+      frame->pitch,
+      static_cast<jlong>(frame->format),
+      static_cast<jlong>(frame->sequence),
+      static_cast<jlong>(frame->timestamp),
+  };
+
+  auto result = env->NewLongArray(std::size(values));
+  env->SetLongArrayRegion(result, 0, std::size(values), values);
+  return result;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_net_rpcs3_RPCS3_releaseFrame(JNIEnv *,
+                                                                     jobject) {
+  g_frame_consumer.release();
+}
+
+static pad_handler padHandlerFor(UsbPadType type) {
+  switch (type) {
+  case UsbPadType::ds3:
+    return pad_handler::ds3;
+  case UsbPadType::ds4:
+    return pad_handler::ds4;
+  case UsbPadType::dualsense:
+    return pad_handler::dualsense;
+  case UsbPadType::unknown:
+    break;
+  }
+
+  return pad_handler::null;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_usbDeviceEvent(
+    JNIEnv *, jobject, jint fd, jint vendorId, jint productId, jint event) {
+  if (event != 0) {
+    g_input_monitor.removeDevice(fd);
+
+    if (auto device = g_usb_devices.detach(fd)) {
+      // The handler notices the missing device on its own, the player keeps
+      // its handler so reconnecting the same pad needs no reset
+      rpcs3_android.notice("USB device %04x:%04x detached (fd %d)",
+                           device->vendorId, device->productId, fd);
+    }
+
+    return true;
+  }
+
+  auto device = g_usb_devices.attach(fd, vendorId, productId);
+  if (!device) {
+    return false;
+  }
+
+  rpcs3_android.notice("USB device %04x:%04x attached (fd %d, %s pad)",
+                       device->vendorId, device->productId, fd,
+                       usbPadTypeName(device->type));
+
+  if (device->type != UsbPadType::unknown) {
+    g_input_monitor.addDevice(fd);
+  }
+
+  if (device->player == UsbDevice::kNoPlayer) {
+    return true;
+  }
+
+  auto &player = *g_cfg_input.player[device->player];
+  const pad_handler handler = padHandlerFor(device->type);
+  const std::string deviceName = usbPadDeviceName(*device);
+
+  if (player.handler.get() == handler &&
+      player.device.to_string() == deviceName) {
+    // Reconnected to the slot it had before, the handler finds it again
+    return true;
+  }
+
+  rpcs3_android.notice("Binding player %u to %s", device->player + 1,
+                       deviceName);
+
+  {
+    // pad_thread::Init reloads g_cfg_input from disk, a binding which is
+    // only set in memory is lost with the next reset or boot
+    std::lock_guard lock(pad::g_pad_mutex);
+    player.handler.set(handler);
+    player.device.from_string(deviceName);
+
+    if (!g_cfg_input.save("")) {
+      rpcs3_android.error("Failed to save the input config");
+    }
+  }
+
+  // pad_thread only creates handlers and binds pads to devices in Init(), on
+  // its own thread and for every player at once. pad::reset is the only way
+  // to get there, so a new binding costs a full re-enumeration while a title
+  // runs
+  if (!Emu.IsStopped()) {
+    pad::reset(Emu.GetTitleID());
+  }
+
+  return true;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_net_rpcs3_RPCS3_setEventDrivenInput(JNIEnv *, jobject, jboolean enabled) {
+  if (!enabled) {
+    g_input_monitor.stop();
+
+    {
+      std::lock_guard lock(g_pad_sleep_fallback.mutex);
+      g_pad_sleep_fallback.enabled = false;
+    }
+
+    updatePadSleepFallback(false);
+    return true;
+  }
+
+  if (g_input_monitor.running()) {
+    return true;
+  }
+
+  const bool started = g_input_monitor.start([] {
+    // The pad thread only exists while a title runs
+    std::lock_guard lock(g_pad_wake_mutex);
+    if (!g_pad_wake_enabled) {
+      return;
+    }
+
+    if (auto pad = g_fxo->try_get<named_thread<pad_thread>>()) {
+      thread_ctrl::notify(*pad);
+    }
+  });
+
+  if (!started) {
+    return false;
+  }
+
+  for (auto &device : g_usb_devices.devices()) {
+    if (device.type != UsbPadType::unknown) {
+      g_input_monitor.addDevice(device.fd);
+    }
+  }
+
+  g_input_monitor.resetStats();
+
+  {
+    std::lock_guard lock(g_pad_sleep_fallback.mutex);
+    g_pad_sleep_fallback.enabled = true;
+  }
+
+  updatePadSleepFallback(false);
+  return true;
+}
+
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_net_rpcs3_RPCS3_getInputLatencyStats(JNIEnv *env, jobject) {
+  const auto stats = g_input_monitor.stats();
+  const jdouble values[] = {
+      static_cast<jdouble>(stats.reports),
+      static_cast<jdouble>(stats.wakeups),
+      stats.averageWakeUs,
+      stats.maxWakeUs,
+      static_cast<jdouble>(stats.frames),
+      stats.averageFrameMs,
+      stats.maxFrameMs,
+  };
+
+  auto result = env->NewDoubleArray(std::size(values));
+  env->SetDoubleArrayRegion(result, 0, std::size(values), values);
+  return result;
+}
+
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_net_rpcs3_RPCS3_getDiscImageStats(JNIEnv *env, jobject, jboolean reset) {
+  DiscImage::Stats total;
+
+  {
+    std::lock_guard lock(g_disc_images_mutex);
+
+    for (auto &[path, device] : g_disc_images) {
+      const auto stats = device->image()->stats();
+      total.reads += stats.reads;
+      total.bytesRead += stats.bytesRead;
+      total.cacheHits += stats.cacheHits;
+      total.cacheMisses += stats.cacheMisses;
+      total.compressedBytes += stats.compressedBytes;
+      total.inflateNs += stats.inflateNs;
+
+      if (reset) {
+        device->image()->resetStats();
+      }
+    }
+  }
+
+  const u64 lookups = total.cacheHits + total.cacheMisses;
+  const jdouble values[] = {
+      static_cast<jdouble>(total.reads),
+      total.bytesRead / 1e6,
+      static_cast<jdouble>(total.cacheHits),
+      static_cast<jdouble>(total.cacheMisses),
+      lookups != 0 ? total.cacheHits * 100.0 / lookups : 0.0,
+      total.compressedBytes / 1e6,
+      total.inflateNs / 1e6,
+  };
+
+  auto result = env->NewDoubleArray(std::size(values));
+  env->SetDoubleArrayRegion(result, 0, std::size(values), values);
+  return result;
+}
+
+// Caps the package data the firmware installer keeps in memory at once. The
+// decrypter and the TAR extractor work on whole packages, so this bounds how
+// many packages are installed concurrently rather than streaming them: every
+// package in flight is accounted with its decrypted and decompressed copies,
+// the encrypted one is read from the PUP in place. A package larger than the
+// whole window is still installed, alone. Set by
+// setFirmwareInstallMemoryWindow, a running installation picks up the change
+// with the next package.
+static atomic_t<u64> g_fw_install_memory_window = 192 * 1024 * 1024;
+
+// Smaller windows would serialize packages which are installed concurrently
+// even on low-memory devices
+static constexpr u64 kMinFwInstallMemoryWindow = 32 * 1024 * 1024;
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_net_rpcs3_RPCS3_setFirmwareInstallMemoryWindow(JNIEnv *, jobject,
+                                                    jlong bytes) {
+  if (bytes < static_cast<jlong>(kMinFwInstallMemoryWindow)) {
+    return false;
+  }
+
+  g_fw_install_memory_window = static_cast<u64>(bytes);
   return true;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_installFw(
-    JNIEnv *env, jobject, jint fd, jlong progressId) {
-  Progress progress(env, progressId);
+// Locates an entry of a PUP, so it can be read in place. pup_object::get_file
+// copies the whole entry into memory
+static bool findPupEntry(int fd, u64 entry_id, u64 &offset, u64 &length) {
+  PUPHeader header{};
+  if (::pread64(fd, &header, sizeof(header), 0) != sizeof(header)) {
+    return false;
+  }
 
-  try {
-    if (!progress.report(0, 0)) {
+  for (u64 i = 0; i < header.file_count; i++) {
+    PUPFileEntry entry{};
+    if (::pread64(fd, &entry, sizeof(entry),
+                  sizeof(PUPHeader) + i * sizeof(PUPFileEntry)) !=
+        sizeof(entry)) {
       return false;
     }
-  } catch (...) {
+
+    if (entry.entry_id == entry_id) {
+      offset = entry.data_offset;
+      length = entry.data_length;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Installs dev_flash packages from the update TAR, which starts at tar_base in
+// the PUP. Every package is decrypted from its own view of the PUP and its
+// contents are extracted; workers pick packages in order and never wait for
+// each other to read. Progress is reported from the calling thread only.
+static bool installFwPackages(int fd, u64 tar_base,
+                              const std::vector<TarEntry> &packages,
+                              Progress &progress) {
+  const u32 maxWorkers = 4;
+  const std::size_t total = packages.size();
+
+  std::mutex state_mutex;
+  std::size_t next = 0;
+  std::condition_variable state_cv;
+  std::size_t completed = 0;
+  std::size_t in_flight = 0;
+  std::optional<std::string> error;
+  atomic_t<bool> abort = false;
+
+  // Lowered by memory trims for the rest of this installation
+  u64 window_cap = umax;
+
+  // Packages in flight can not be dropped. A trim shrinks the window instead,
+  // so no new package is read until the ones in flight were written out and
+  // their memory is back. Nothing is freed right away, so nothing is reported
+  const u32 cache_id = g_cache_registry.add(
+      "firmware staging buffers", 2,
+      [&] {
+        std::lock_guard lock(state_mutex);
+        return u64{in_flight};
+      },
+      [&](u64 bytes) {
+        std::lock_guard lock(state_mutex);
+        window_cap = std::min<u64>(window_cap,
+                                   in_flight - std::min<u64>(bytes, in_flight));
+        return u64{0};
+      });
+
+  AtExit atExit_cache{[&] { g_cache_registry.remove(cache_id); }};
+
+  auto fail = [&](std::string message) {
+    {
+      std::lock_guard lock(state_mutex);
+      if (!error) {
+        error = std::move(message);
+      }
+    }
+
+    abort = true;
+    state_cv.notify_all();
+  };
+
+  // Waits until the package fits into the memory window. A package is the
+  // smallest unit the decrypter handles, so one larger than the whole window
+  // is still let through once nothing else is in flight
+  auto reserve = [&](std::size_t size) {
+    std::unique_lock lock(state_mutex);
+    state_cv.wait(lock, [&] {
+      return abort || in_flight == 0 ||
+             in_flight + size <=
+                 std::min<u64>(g_fw_install_memory_window, window_cap);
+    });
+
+    in_flight += size;
+  };
+
+  auto release = [&](std::size_t size) {
+    {
+      std::lock_guard lock(state_mutex);
+      in_flight -= size;
+    }
+
+    state_cv.notify_all();
+  };
+
+  auto worker = [&] {
+    while (!abort) {
+      std::size_t index;
+
+      {
+        std::lock_guard lock(state_mutex);
+        index = next++;
+      }
+
+      if (index >= total) {
+        return;
+      }
+
+      const TarEntry &package = packages[index];
+
+      // Decrypted and decompressed copies of the package
+      const std::size_t reserved = package.size * 2;
+      reserve(reserved);
+      AtExit atExit_release{[&] { release(reserved); }};
+
+      if (abort) {
+        return;
+      }
+
+      std::vector<fs::file> dev_flash_tar_f;
+
+      {
+        const fs::file update_file =
+            FdWindowFile::open(fd, tar_base + package.offset, package.size);
+
+        SCEDecrypter self_dec(update_file);
+        self_dec.LoadHeaders();
+        self_dec.LoadMetadata(SCEPKG_ERK, SCEPKG_RIV);
+        self_dec.DecryptData();
+
+        // The decrypted sections are dropped with the decrypter, before the
+        // TAR is extracted
+        dev_flash_tar_f = self_dec.MakeFile();
+      }
+
+      if (dev_flash_tar_f.size() < 3) {
+        rpcs3_android.error(
+            "Firmware installation failed: Firmware could not be decompressed");
+        fail("Firmware update file could not be decompressed");
+        return;
+      }
+
+      if (abort) {
+        return;
+      }
+
+      tar_object dev_flash_tar(dev_flash_tar_f[2]);
+
+      if (!dev_flash_tar.extract()) {
+        rpcs3_android.error("Error while installing firmware: TAR contents are "
+                            "invalid. (package=%s)",
+                            package.name);
+        fail(fmt::format("TAR contents are invalid (package=%s)",
+                         package.name));
+        return;
+      }
+
+      {
+        std::lock_guard lock(state_mutex);
+        completed++;
+      }
+
+      state_cv.notify_all();
+    }
+  };
+
+  {
+    named_thread_group workers(
+        "FW Installer ",
+        std::clamp<u32>(utils::get_thread_count(), 1,
+                        std::min<u32>(maxWorkers, ::size32(packages))),
+        worker);
+
+    std::size_t reported = 0;
+    std::unique_lock lock(state_mutex);
+
+    while (!error && reported < total) {
+      state_cv.wait(lock, [&] { return error || completed != reported; });
+
+      if (error) {
+        break;
+      }
+
+      reported = completed;
+      lock.unlock();
+
+      // value == max finishes the progress on the Kotlin side, the last
+      // package is only reported by success() once the firmware is registered
+      if (!progress.report(std::min(reported, total - 1), total)) {
+        // Installation was cancelled, let the workers finish their current
+        // stage and stop
+        abort = true;
+        state_cv.notify_all();
+        return false;
+      }
+
+      lock.lock();
+    }
+  }
+
+  if (error) {
+    progress.failure(*error);
+    return false;
+  }
+
+  return true;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_installFw(
+    JNIEnv *env, jobject, jint fd, jlong progressId) {
+  Progress progress(env, progressId);
+  if (!progress.start()) {
     return false;
   }
 
@@ -985,27 +2471,24 @@ extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_installFw(
     return false;
   }
 
-  fs::file update_files_f = pup.get_file(0x300);
-
-  const usz update_files_size = update_files_f ? update_files_f.size() : 0;
+  // The update TAR is read straight from the PUP, only the packages that are
+  // currently being installed are kept in memory
+  u64 tar_base = 0;
+  u64 tar_size = 0;
+  std::vector<TarEntry> packages;
 
-  if (!update_files_size) {
+  if (!findPupEntry(fd, 0x300, tar_base, tar_size) || !tar_size ||
+      !listTarEntries(FdWindowFile::open(fd, tar_base, tar_size), packages)) {
     rpcs3_android.fatal("installFw: invalid PUP");
     progress.failure("Firmware update file is broken");
     return false;
   }
 
-  tar_object update_files(update_files_f);
-
-  auto update_filenames = update_files.get_filenames();
-  update_filenames.erase(std::remove_if(update_filenames.begin(),
-                                        update_filenames.end(),
-                                        [](const std::string &s) {
-                                          return !s.starts_with("dev_flash_");
-                                        }),
-                         update_filenames.end());
+  std::erase_if(packages, [](const TarEntry &entry) {
+    return !entry.name.starts_with("dev_flash_");
+  });
 
-  if (update_filenames.empty()) {
+  if (packages.empty()) {
     rpcs3_android.fatal("installFw: invalid PUP");
     progress.failure("Firmware update file is broken");
     return false;
@@ -1038,130 +2521,470 @@ extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_installFw(
           .iconPath = dev_flash + "vsh/resource/explore/icon/icon_home.png",
       }}});
 
-  jlong processed = 0;
-  for (const auto &update_filename : update_filenames) {
-    auto update_file_stream = update_files.get_file(update_filename);
+  if (!installFwPackages(fd, tar_base, packages, progress)) {
+    return false;
+  }
+
+  sendFirmwareInstalled(env, utils::get_firmware_version());
+  progress.success(packages.size());
+  return true;
+}
+
+// Installs a batch of packages. Packages of the same title are extracted in
+// the given order (base game, then updates), different titles are extracted
+// concurrently. extract_data already spreads a single package over all cores,
+// so only a few packages are in flight at once to bound the storage I/O.
+//
+// The extraction itself is package_reader from the rpcs3 submodule, so the
+// install latency can only be measured on a device: the host tests build
+// synthetic PKGs (pkg_builder.h) but have no package_reader to install them.
+static bool installPkgs(JNIEnv *env, std::span<const jint> fds,
+                        jlong requestId) {
+  Progress progress(env, requestId);
+  if (!progress.start()) {
+    return false;
+  }
+
+  const u32 maxConcurrentPackages = 2;
+
+  // Estimate for every package in flight, extract_data decrypts on every core
+  // with a buffer of its own
+  const u64 packageStagingSize =
+      u64{8 * 1024 * 1024} * std::max<u32>(utils::get_thread_count(), 1);
 
-    if (update_file_stream->m_file_handler) {
-      // Forcefully read all the data
-      update_file_stream->m_file_handler->handle_file_op(
-          *update_file_stream, 0, update_file_stream->get_size(umax), nullptr);
+  // extract_data works on a deque of readers, every package gets its own so
+  // that results and bootable paths can be told apart
+  std::deque<std::deque<package_reader>> readers;
+  std::vector<u64> sizes;
+
+  for (auto fd : fds) {
+    readers.emplace_back().emplace_back("dummy.pkg",
+                                        fs::file::from_native_handle(fd));
+    sizes.push_back(readers.back().front().file().size());
+  }
+
+  // Declared before the workers so the handles are released after they joined
+  AtExit atExit{[&] {
+    for (auto &group : readers) {
+      for (auto &reader : group) {
+        reader.file().release_handle();
+      }
     }
+  }};
 
-    fs::file update_file = fs::make_stream(std::move(update_file_stream->data));
+  std::vector<std::vector<std::size_t>> titles;
+  std::unordered_map<std::string, std::size_t> titleIndex;
 
-    SCEDecrypter self_dec(update_file);
-    self_dec.LoadHeaders();
-    self_dec.LoadMetadata(SCEPKG_ERK, SCEPKG_RIV);
-    self_dec.DecryptData();
+  for (std::size_t i = 0; i < readers.size(); i++) {
+    const auto &psf = readers[i].front().get_psf();
+    const std::string titleId(psf::get_string(psf, "TITLE_ID"));
+    auto [it, inserted] = titleIndex.emplace(titleId, titles.size());
 
-    auto dev_flash_tar_f = self_dec.MakeFile();
+    if (inserted) {
+      titles.emplace_back();
+    }
 
-    if (dev_flash_tar_f.size() < 3) {
-      rpcs3_android.error(
-          "Firmware installation failed: Firmware could not be decompressed");
+    titles[it->second].push_back(i);
 
-      progress.failure("Firmware update file could not be decompressed");
-      return false;
+    if (auto gameInfo = parsePsf("", psf)) {
+      sendGameInfo(env, requestId, {{*gameInfo}});
     }
+  }
+
+  std::mutex state_mutex;
+  std::condition_variable state_cv;
+  std::size_t finishedWorkers = 0;
+  std::vector<std::deque<std::string>> bootable_paths(readers.size());
+  std::vector<u8> installed(readers.size());
+  atomic_t<std::size_t> nextTitle = 0;
+  atomic_t<bool> abort = false;
+
+  const u32 workerCount =
+      std::min<u32>(maxConcurrentPackages, ::size32(titles));
+
+  // Packages being extracted, a memory trim lets only one continue
+  u32 activePackages = 0;
+  u32 maxActivePackages = workerCount;
+
+  // Everything but the first package, called with state_mutex held
+  const auto stagingSize = [&] {
+    return activePackages > 1 ? (activePackages - 1) * packageStagingSize
+                              : u64{0};
+  };
 
-    tar_object dev_flash_tar(dev_flash_tar_f[2]);
+  const u32 cacheId = g_cache_registry.add(
+      "package staging buffers", 2,
+      [&] {
+        std::lock_guard lock(state_mutex);
+        return stagingSize();
+      },
+      [&](u64) {
+        // The other packages finish their current file first, their staging
+        // memory is only given back afterwards and not reported
+        std::lock_guard lock(state_mutex);
+        maxActivePackages = 1;
+        return u64{0};
+      });
+
+  AtExit atExitCache{[&] { g_cache_registry.remove(cacheId); }};
+
+  auto worker = [&] {
+    for (std::size_t title; !abort && (title = nextTitle++) < titles.size();) {
+      for (auto index : titles[title]) {
+        {
+          std::unique_lock lock(state_mutex);
+          state_cv.wait(lock, [&] {
+            return abort || activePackages < maxActivePackages;
+          });
+
+          if (abort) {
+            break;
+          }
+
+          activePackages++;
+        }
 
-    if (!dev_flash_tar.extract()) {
+        auto result =
+            package_reader::extract_data(readers[index], bootable_paths[index]);
 
-      rpcs3_android.error("Error while installing firmware: TAR contents are "
-                          "invalid. (package=%s)",
-                          update_filename);
+        {
+          std::lock_guard lock(state_mutex);
+          activePackages--;
+        }
 
-      progress.failure(fmt::format("TAR contents are invalid (package=%s)",
-                                   update_filename));
-      return false;
+        state_cv.notify_all();
+
+        if (result.error != package_install_result::error_type::no_error) {
+          rpcs3_android.error("installPkgs: package %u failed with %d", index,
+                              static_cast<int>(result.error));
+
+          // Updates of a title can not be applied without its base
+          break;
+        }
+
+        installed[index] = true;
+      }
     }
 
-    if (!progress.report(processed++, update_filenames.size())) {
-      // Installation was cancelled
-      return false;
+    {
+      std::lock_guard lock(state_mutex);
+      finishedWorkers++;
+    }
+
+    state_cv.notify_all();
+  };
+
+  const jlong maxProgress = 10000;
+  const u64 totalSize = std::max<u64>(
+      std::accumulate(sizes.begin(), sizes.end(), u64{0}), 1);
+
+  // Completion wakes this thread immediately, in between the extraction
+  // progress is sampled at the rate progress is forwarded to the UI anyway
+  const auto period = std::chrono::microseconds(
+      1'000'000 / std::max<u32>(g_progress_rate_hz, 1));
+
+  {
+    named_thread_group workers("PKG Installer ", workerCount, worker);
+
+    std::unique_lock lock(state_mutex);
+
+    while (!state_cv.wait_for(lock, period, [&] {
+      return finishedWorkers == workerCount;
+    })) {
+      lock.unlock();
+
+      // Weighted by package size, a small DLC does not count as much as the
+      // base game. Dividing the size first would ignore packages smaller than
+      // maxProgress bytes, so this multiplies first and uses u128
+      u128 doneSize = 0;
+      for (std::size_t i = 0; i < readers.size(); i++) {
+        doneSize += u128{sizes[i]} *
+                    readers[i].front().get_progress(maxProgress) / maxProgress;
+      }
+
+      const auto done = static_cast<jlong>(doneSize * maxProgress / totalSize);
+      if (!progress.report(done, maxProgress)) {
+        abort = true;
+        state_cv.notify_all();
+
+        for (auto &group : readers) {
+          for (auto &reader : group) {
+            reader.abort_extract();
+          }
+        }
+
+        return false;
+      }
+
+      lock.lock();
     }
   }
 
-  sendFirmwareInstalled(env, utils::get_firmware_version());
-  progress.success(update_filenames.size());
-  return true;
+  const auto failed = std::count(installed.begin(), installed.end(), 0);
+
+  if (failed != 0) {
+    progress.failure(
+        readers.size() == 1
+            ? "Installation failed"
+            : fmt::format("Installation of %d of %d packages failed", failed,
+                          readers.size()));
+  } else {
+    progress.success(maxProgress);
+  }
+
+  std::vector<std::string> paths;
+  for (auto &packagePaths : bootable_paths) {
+    paths.insert(paths.end(), packagePaths.begin(), packagePaths.end());
+  }
+
+  if (!paths.empty()) {
+    collectGameInfo(env, requestId, std::move(paths));
+  }
+
+  return failed == 0;
 }
 
 extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_installPkgFile(
     JNIEnv *env, jobject, jint fd, jlong requestId) {
-  Progress progress(env, requestId);
+  return installPkgs(env, {&fd, 1}, requestId);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_installPkgFiles(
+    JNIEnv *env, jobject, jintArray jfds, jlong requestId) {
+  std::vector<jint> fds(env->GetArrayLength(jfds));
+  env->GetIntArrayRegion(jfds, 0, fds.size(), fds.data());
+
+  if (fds.empty()) {
+    return false;
+  }
+
+  return installPkgs(env, fds, requestId);
+}
+
+// Boots path in compile-only mode, which builds the PPU cache of every module
+// found under it without starting the renderer, and reports per-module
+// progress until the emulator stops again.
+static bool compilePpuModules(Progress &progress, const std::string &path) {
+  // Leave half of the cores alone, a long compile at full load gets the
+  // device throttled and ends up slower. The boot reloads g_cfg, so the cap
+  // goes through a config override like the benchmark settings
+  const auto userConfig = userConfigString();
+  cfg_root compileConfig;
+  compileConfig.from_string(userConfig);
+  compileConfig.core.llvm_threads.set(
+      std::max<u32>(utils::get_thread_count() / 2, 1));
+  const auto config = compileConfig.to_string();
+
+  const auto configPath = g_android_cache_dir + "compile.yml";
+
+  if (fs::pending_file file(configPath);
+      !file.file || file.file.write(config) != config.size() ||
+      !file.commit()) {
+    rpcs3_android.error("compilePpuModules: failed to write %s", configPath);
+    progress.failure("Failed to load modules");
+    return false;
+  }
+
+  AtExit atExit{[&] { restoreUserConfig(userConfig); }};
+
+  // The counters are global and never reset, only count this run
+  const u32 baseTotal = g_progr_ptotal;
+  const u32 baseDone = g_progr_pdone;
+
+  Emu.SetForceBoot(true);
 
-  try {
-    if (!progress.report(0, 0)) {
+  if (bootWithThermalLimits([&] {
+        return Emu.BootGame(path, "", true, cfg_mode::config_override,
+                            configPath);
+      }) != game_boot_result::no_errors) {
+    rpcs3_android.error("compilePpuModules: failed to boot %s", path);
+    progress.failure("Failed to load modules");
+    return false;
+  }
+
+  const auto period = std::chrono::microseconds(
+      1'000'000 / std::max<u32>(g_progress_rate_hz, 1));
+
+  while (!Emu.IsStopped()) {
+    const u32 total = g_progr_ptotal - baseTotal;
+    const u32 done = std::min<u32>(g_progr_pdone - baseDone, total);
+
+    if (!progress.report(done, total)) {
+      Emu.Kill();
       return false;
     }
-  } catch (...) {
+
+    std::this_thread::sleep_for(period);
+  }
+
+  progress.success(g_progr_ptotal - baseTotal);
+  return true;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_net_rpcs3_RPCS3_compileFirmware(JNIEnv *env, jobject, jlong progressId) {
+  Progress progress(env, progressId);
+  if (!progress.start()) {
     return false;
   }
 
-  std::deque<package_reader> readers;
-  std::deque<std::string> bootable_paths;
-  readers.emplace_back("dummy.pkg", fs::file::from_native_handle(fd));
+  const auto lock = lockIdleEmu();
+  if (!lock) {
+    progress.failure("The emulator is busy");
+    return false;
+  }
 
-  package_install_result result = {};
-  named_thread worker("PKG Installer", [&readers, &result, &bootable_paths] {
-    result = package_reader::extract_data(readers, bootable_paths);
-    return result.error == package_install_result::error_type::no_error;
-  });
+  if (!compilePpuModules(progress, g_cfg_vfs.get_dev_flash() + "sys")) {
+    return false;
+  }
 
-  AtExit atExit{[&] {
-    for (auto &reader : readers) {
-      reader.file().release_handle();
-    }
-  }};
+  sendFirmwareCompiled(env, utils::get_firmware_version());
+  return true;
+}
 
-  for (auto &reader : readers) {
-    if (auto gameInfo = parsePsf("", reader.get_psf())) {
-      sendGameInfo(env, requestId, {{*gameInfo}});
-    }
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_precompileGame(
+    JNIEnv *env, jobject, jstring jpath, jlong progressId) {
+  Progress progress(env, progressId);
+  if (!progress.start()) {
+    return false;
   }
 
-  const jlong maxProgress = 10000;
+  auto path = unwrap(env, jpath);
+  while (path.ends_with('/')) {
+    path.pop_back();
+  }
 
-  while (true) {
-    std::uint64_t totalProgress = 0;
-    for (std::size_t index = 0; auto &reader : readers) {
-      if (result.error != package_install_result::error_type::no_error) {
-        progress.failure("Installation failed");
-        for (package_reader &reader : readers) {
-          reader.abort_extract();
-        }
-        return false;
-      }
+  const auto lock = lockIdleEmu();
+  if (!lock) {
+    progress.failure("The emulator is busy");
+    return false;
+  }
 
-      totalProgress += reader.get_progress(maxProgress);
-    }
+  if (!resolveDiscImage(path)) {
+    progress.failure("Failed to open the disc image");
+    return false;
+  }
 
-    if (totalProgress == maxProgress * readers.size()) {
-      progress.success(maxProgress);
-      break;
-    }
+  // Modules which already have a valid cache entry are not counted and not
+  // compiled again, so a repeated run finishes with nothing to do.
+  //
+  // SPU code is not part of this: the programs are only known once the title
+  // ran and recorded them, and rpcs3 builds the recorded ones from the main
+  // PPU thread of a running title (spu_cache::initialize). A compile-only
+  // boot never starts that thread
+  return compilePpuModules(progress, path);
+}
 
-    totalProgress /= readers.size();
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_setLogLevel(
+    JNIEnv *env, jobject, jstring jchannel, jint level) {
+  if (level < static_cast<jint>(logs::level::always) ||
+      level > static_cast<jint>(logs::level::trace)) {
+    return false;
+  }
 
-    if (!progress.report(totalProgress, maxProgress)) {
-      for (package_reader &reader : readers) {
-        reader.abort_extract();
-      }
+  // Messages above the channel level are discarded before formatting
+  logs::set_level(unwrap(env, jchannel), static_cast<logs::level>(level));
+  return true;
+}
 
-      return false;
+extern "C" JNIEXPORT jboolean JNICALL Java_net_rpcs3_RPCS3_runBenchmark(
+    JNIEnv *env, jobject, jstring jpath, jint frames, jint seconds,
+    jstring jreportPath) {
+  if (frames < 0 || seconds < 0 || (frames == 0 && seconds == 0)) {
+    return false;
+  }
+
+  auto path = unwrap(env, jpath);
+  while (path.ends_with('/')) {
+    path.pop_back();
+  }
+
+  if (!resolveDiscImage(path)) {
+    return false;
+  }
+
+  const auto lock = lockIdleEmu();
+  if (!lock) {
+    rpcs3_android.error("runBenchmark: the emulator is busy");
+    return false;
+  }
+
+  const auto reportPath = unwrap(env, jreportPath);
+
+  // Boot through a config override, so the user's renderer and audio
+  // settings are left alone. Thermal limits are applied on top after the
+  // boot, like for any other title
+  cfg_root benchmarkConfig;
+  benchmarkConfig.from_string(userConfigString());
+  benchmarkConfig.video.renderer.set(video_renderer::null);
+  benchmarkConfig.audio.renderer.set(audio_renderer::null);
+  const auto config = benchmarkConfig.to_string();
+
+  const auto configPath = g_android_cache_dir + "benchmark.yml";
+
+  if (fs::pending_file file(configPath);
+      !file.file || file.file.write(config) != config.size() ||
+      !file.commit()) {
+    rpcs3_android.error("runBenchmark: failed to write %s", configPath);
+    return false;
+  }
+
+  auto now = [] {
+    return static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  };
+
+  BenchmarkRecorder recorder({.frames = static_cast<u64>(frames),
+                              .seconds = static_cast<u64>(seconds)});
+  g_benchmark = &recorder;
+  AtExit atExit{[] { g_benchmark = nullptr; }};
+
+  const u32 baseTotal = g_progr_ptotal;
+  const u32 baseDone = g_progr_pdone;
+
+  recorder.start(now());
+  Emu.SetForceBoot(true);
+
+  if (bootWithThermalLimits([&] {
+        return Emu.BootGame(path, "", false, cfg_mode::config_override,
+                            configPath);
+      }) != game_boot_result::no_errors) {
+    rpcs3_android.error("runBenchmark: failed to boot %s", path);
+    return false;
+  }
+
+  bool completed = false;
+
+  while (!Emu.IsStopped()) {
+    const u64 time = now();
+    const bool compiling =
+        g_progr_pdone - baseDone < g_progr_ptotal - baseTotal;
+    recorder.sample(time, compiling);
+
+    if (recorder.done(time)) {
+      completed = true;
+      break;
     }
 
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
 
-  if (worker()) {
-    std::vector<std::string> paths;
-    collectGameInfo(env, requestId,
-                    std::vector(bootable_paths.begin(), bootable_paths.end()));
+  recorder.stop(now());
+
+  const auto title = Emu.GetTitleAndTitleID();
+  Emu.Kill();
+
+  const auto report = recorder.toJson(title, completed);
+
+  if (fs::pending_file file(reportPath);
+      !file.file || file.file.write(report) != report.size() ||
+      !file.commit()) {
+    rpcs3_android.error("runBenchmark: failed to write %s", reportPath);
+    return false;
   }
 
-  return true;
+  rpcs3_android.notice("runBenchmark: report written to %s", reportPath);
+  return completed;
 }
@@ -0,0 +1,358 @@
+#include "pkg_mount.h"
+
+#include "Crypto/key_vault.h"
+#include "Crypto/sha1.h"
+#include "Crypto/unpkg.h"
+#include "util/logs.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+LOG_CHANNEL(pkg_mount_log, "PkgMount");
+
+namespace {
+constexpr u32 kPkgMagic = 0x7F504B47; // "\x7FPKG"
+
+// Longer names are not produced by the official tools
+constexpr u32 kMaxNameSize = 1024;
+} // namespace
+
+PkgArchive::PkgArchive(fs::file file, usz cacheBlocks)
+    : file(std::move(file)), cacheCapacity(std::max<usz>(cacheBlocks, 1)) {}
+
+std::shared_ptr<PkgArchive> PkgArchive::open(fs::file file, usz cacheBlocks) {
+  if (!file) {
+    return nullptr;
+  }
+
+  std::shared_ptr<PkgArchive> archive(
+      new PkgArchive(std::move(file), cacheBlocks));
+
+  if (!archive->load()) {
+    return nullptr;
+  }
+
+  return archive;
+}
+
+bool PkgArchive::load() {
+  PKGHeader header;
+  if (file.read_at(0, &header, sizeof(header)) != sizeof(header)) {
+    pkg_mount_log.error("File is too small for a PKG header");
+    return false;
+  }
+
+  if (header.pkg_magic != kPkgMagic) {
+    pkg_mount_log.error("Not a PKG file (magic 0x%x)", +header.pkg_magic);
+    return false;
+  }
+
+  if (header.pkg_type != PKG_RELEASE_TYPE_RELEASE &&
+      header.pkg_type != PKG_RELEASE_TYPE_DEBUG) {
+    pkg_mount_log.error("Unknown PKG type 0x%x", +header.pkg_type);
+    return false;
+  }
+
+  if (header.pkg_platform != PKG_PLATFORM_TYPE_PS3 &&
+      header.pkg_platform != PKG_PLATFORM_TYPE_PSP_PSVITA) {
+    pkg_mount_log.error("Unknown PKG platform 0x%x", +header.pkg_platform);
+    return false;
+  }
+
+  debug = header.pkg_type == PKG_RELEASE_TYPE_DEBUG;
+  pspPlatform = header.pkg_platform == PKG_PLATFORM_TYPE_PSP_PSVITA;
+  dataOffset = header.data_offset;
+  dataSize = header.data_size;
+  std::memcpy(qaDigest, header.qa_digest, sizeof(qaDigest));
+  std::memcpy(klicensee, header.klicensee, sizeof(klicensee));
+  content.assign(header.title_id,
+                 strnlen(header.title_id, sizeof(header.title_id)));
+
+  const fs::stat_t info = file.get_stat();
+  modified = info.mtime;
+
+  if (dataOffset > info.size || dataSize > info.size - dataOffset) {
+    pkg_mount_log.error("PKG is truncated, data ends at 0x%x but file has "
+                        "0x%x bytes",
+                        dataOffset + dataSize, info.size);
+    return false;
+  }
+
+  const u64 entryCount = header.file_count;
+  if (entryCount * sizeof(PKGEntry) > dataSize) {
+    pkg_mount_log.error("PKG claims %u entries which do not fit its data",
+                        entryCount);
+    return false;
+  }
+
+  aes_setkey_enc(&ps3Key, PKG_AES_KEY, 128);
+  aes_setkey_enc(&pspKey, PKG_AES_KEY2, 128);
+
+  // Only the entry table of a PSP package uses the PSP key as a whole, entries
+  // choose theirs with PKG_FILE_ENTRY_PSP like in package_reader
+  const auto table = readData(0, entryCount * sizeof(PKGEntry), pspPlatform);
+  if (table.size() != entryCount * sizeof(PKGEntry)) {
+    pkg_mount_log.error("Failed to read the PKG entry table");
+    return false;
+  }
+
+  fileEntries.reserve(entryCount);
+
+  for (u64 i = 0; i < entryCount; i++) {
+    PKGEntry raw;
+    std::memcpy(&raw, table.data() + i * sizeof(PKGEntry), sizeof(raw));
+
+    Entry entry;
+    entry.offset = raw.file_offset;
+    entry.size = raw.file_size;
+    entry.directory = (raw.type & 0xff) == PKG_FILE_ENTRY_FOLDER;
+    entry.psp = (raw.type & PKG_FILE_ENTRY_PSP) != 0;
+
+    const u64 nameOffset = raw.name_offset;
+    const u64 nameSize = raw.name_size;
+
+    if (nameSize == 0 || nameSize > kMaxNameSize ||
+        nameOffset + nameSize > dataSize) {
+      pkg_mount_log.error("Entry %u has an invalid name", i);
+      return false;
+    }
+
+    if (!entry.directory &&
+        (entry.offset > dataSize || entry.size > dataSize - entry.offset)) {
+      pkg_mount_log.error("Entry %u is outside of the PKG data", i);
+      return false;
+    }
+
+    const auto name = readData(nameOffset, nameSize, entry.psp);
+    if (name.size() != nameSize) {
+      pkg_mount_log.error("Failed to read the name of entry %u", i);
+      return false;
+    }
+
+    entry.name.assign(reinterpret_cast<const char *>(name.data()),
+                      strnlen(reinterpret_cast<const char *>(name.data()),
+                              name.size()));
+    fileEntries.push_back(std::move(entry));
+  }
+
+  pkg_mount_log.notice("Opened %s: %u entries, 0x%x bytes of data%s",
+                       content, fileEntries.size(), dataSize,
+                       debug ? " (debug)" : "");
+  return true;
+}
+
+void PkgArchive::decrypt(u64 offset, u8 *data, u64 size, bool psp) {
+  u64 index = offset / 16;
+
+  if (debug) {
+    // SHA-1 over the QA digest and the block index
+    u8 input[64]{};
+    std::memcpy(input + 0, qaDigest, 8);
+    std::memcpy(input + 8, qaDigest, 8);
+    std::memcpy(input + 16, qaDigest + 8, 8);
+    std::memcpy(input + 24, qaDigest + 8, 8);
+
+    for (u64 pos = 0; pos < size; pos += 16, index++) {
+      for (int i = 0; i < 8; i++) {
+        input[56 + i] = static_cast<u8>(index >> (56 - i * 8));
+      }
+
+      u8 hash[20];
+      sha1(input, sizeof(input), hash);
+
+      const u64 count = std::min<u64>(16, size - pos);
+      for (u64 i = 0; i < count; i++) {
+        data[pos + i] ^= hash[i];
+      }
+    }
+
+    return;
+  }
+
+  // AES-128 in counter mode, the counter starts at the klicensee
+  aes_context *key = psp ? &pspKey : &ps3Key;
+
+  u128 counter = 0;
+  for (u8 byte : klicensee) {
+    counter = counter << 8 | byte;
+  }
+
+  counter += index;
+
+  for (u64 pos = 0; pos < size; pos += 16, counter++) {
+    u8 input[16];
+    for (int i = 0; i < 16; i++) {
+      input[i] = static_cast<u8>(counter >> (120 - i * 8));
+    }
+
+    u8 keystream[16];
+    aes_crypt_ecb(key, AES_ENCRYPT, input, keystream);
+
+    const u64 count = std::min<u64>(16, size - pos);
+    for (u64 i = 0; i < count; i++) {
+      data[pos + i] ^= keystream[i];
+    }
+  }
+}
+
+std::vector<u8> PkgArchive::readData(u64 offset, u64 size, bool psp) {
+  const u64 aligned = offset & ~u64{15};
+  const u64 skip = offset - aligned;
+
+  std::vector<u8> data(skip + size);
+  if (file.read_at(dataOffset + aligned, data.data(), data.size()) !=
+      data.size()) {
+    return {};
+  }
+
+  decrypt(aligned, data.data(), data.size(), psp);
+  data.erase(data.begin(), data.begin() + skip);
+  return data;
+}
+
+std::shared_ptr<const std::vector<u8>> PkgArchive::cachedBlock(u64 key) {
+  std::lock_guard lock(cacheMutex);
+
+  const auto it = cached.find(key);
+  if (it == cached.end()) {
+    return nullptr;
+  }
+
+  lru.splice(lru.begin(), lru, it->second);
+  stats.hits++;
+  return it->second->data;
+}
+
+std::shared_ptr<const std::vector<u8>> PkgArchive::block(u64 index,
+                                                         bool psp) {
+  const u64 key = index << 1 | psp;
+
+  if (auto data = cachedBlock(key)) {
+    return data;
+  }
+
+  // Decrypted outside of the lock, two readers missing the same block both
+  // decrypt it and the second result is dropped
+  const u64 start = index * kBlockSize;
+  const u64 size = std::min(kBlockSize, dataSize - start);
+
+  auto data = std::make_shared<std::vector<u8>>(size);
+  if (file.read_at(dataOffset + start, data->data(), size) != size) {
+    return nullptr;
+  }
+
+  decrypt(start, data->data(), size, psp);
+
+  std::lock_guard lock(cacheMutex);
+  stats.misses++;
+
+  if (!cached.contains(key)) {
+    lru.push_front({key, data});
+    cached.emplace(key, lru.begin());
+    cachedBytes += data->size();
+
+    if (lru.size() > cacheCapacity) {
+      cachedBytes -= lru.back().data->size();
+      cached.erase(lru.back().key);
+      lru.pop_back();
+    }
+  }
+
+  return data;
+}
+
+u64 PkgArchive::read(const Entry &entry, u64 offset, void *buffer, u64 size) {
+  if (entry.directory || offset >= entry.size) {
+    return 0;
+  }
+
+  size = std::min(size, entry.size - offset);
+
+  u8 *out = static_cast<u8 *>(buffer);
+  const u64 start = entry.offset + offset;
+  const u64 end = start + size;
+  u64 pos = start;
+
+  while (pos < end) {
+    const u64 index = pos / kBlockSize;
+    const u64 blockStart = index * kBlockSize;
+    const u64 blockEnd = std::min(blockStart + kBlockSize, dataSize);
+    const u64 count = std::min(end, blockEnd) - pos;
+
+    // Large sequential reads decrypt whole blocks in place, caching them
+    // would only evict the small blocks which are read repeatedly
+    if (pos == blockStart && count == blockEnd - blockStart) {
+      if (auto data = cachedBlock(index << 1 | entry.psp)) {
+        std::memcpy(out + (pos - start), data->data(), count);
+      } else {
+        if (file.read_at(dataOffset + pos, out + (pos - start), count) !=
+            count) {
+          break;
+        }
+
+        decrypt(pos, out + (pos - start), count, entry.psp);
+
+        std::lock_guard lock(cacheMutex);
+        stats.bypassed++;
+      }
+
+      pos += count;
+      continue;
+    }
+
+    const auto data = block(index, entry.psp);
+    if (!data) {
+      break;
+    }
+
+    std::memcpy(out + (pos - start), data->data() + (pos - blockStart), count);
+    pos += count;
+  }
+
+  return pos - start;
+}
+
+PkgArchive::CacheStats PkgArchive::cacheStats() const {
+  std::lock_guard lock(cacheMutex);
+  return stats;
+}
+
+u64 PkgArchive::cacheMemory() const {
+  std::lock_guard lock(cacheMutex);
+  return cachedBytes;
+}
+
+u64 PkgArchive::trimCache(u64 bytes) {
+  std::lock_guard lock(cacheMutex);
+  u64 freed = 0;
+
+  // Readers may still hold a block, its memory is freed once they are done
+  while (freed < bytes && !lru.empty()) {
+    freed += lru.back().data->size();
+    cached.erase(lru.back().key);
+    lru.pop_back();
+  }
+
+  cachedBytes -= freed;
+  return freed;
+}
+
+PkgDevice::PkgDevice(std::shared_ptr<PkgArchive> archive)
+    : pkg(std::move(archive)) {
+  std::vector<Entry> entries;
+  entries.reserve(pkg->entries().size());
+
+  for (auto &entry : pkg->entries()) {
+    entries.push_back({
+        .name = entry.name,
+        .size = entry.size,
+        .directory = entry.directory,
+    });
+  }
+
+  build(entries, pkg->mtime());
+}
+
+u64 PkgDevice::read(usz entry, u64 offset, void *buffer, u64 size) {
+  return pkg->read(pkg->entries()[entry], offset, buffer, size);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Crypto/aes.h"
+#include "archive_device.h"
+#include "Utilities/File.h"
+#include "util/types.hpp"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Random access to the files of a PS3 PKG without extracting it. Follows the
+// layout and keystreams package_reader uses to install, but decrypts only
+// the blocks which are read and keeps recently used ones in an LRU cache.
+// Reads are thread safe.
+class PkgArchive {
+public:
+  struct Entry {
+    std::string name;
+
+    // Relative to the start of the data area
+    u64 offset = 0;
+    u64 size = 0;
+
+    bool directory = false;
+    bool psp = false;
+  };
+
+  struct CacheStats {
+    u64 hits = 0;
+    u64 misses = 0;
+
+    // Whole blocks read straight into the caller's buffer
+    u64 bypassed = 0;
+  };
+
+  // Unit of decryption and caching
+  static constexpr u64 kBlockSize = 16 * 1024;
+
+  static std::shared_ptr<PkgArchive> open(fs::file file,
+                                          usz cacheBlocks = 2048);
+
+  PkgArchive(const PkgArchive &) = delete;
+  PkgArchive &operator=(const PkgArchive &) = delete;
+
+  const std::vector<Entry> &entries() const { return fileEntries; }
+  const std::string &contentId() const { return content; }
+  s64 mtime() const { return modified; }
+
+  // Reads up to size bytes of entry at offset, returns the bytes read
+  u64 read(const Entry &entry, u64 offset, void *buffer, u64 size);
+
+  CacheStats cacheStats() const;
+
+  // Bytes held by the cached blocks
+  u64 cacheMemory() const;
+
+  // Drops the least recently used blocks until about bytes were freed,
+  // returns the bytes freed
+  u64 trimCache(u64 bytes);
+
+private:
+  PkgArchive(fs::file file, usz cacheBlocks);
+
+  bool load();
+
+  // Decrypts size bytes of the data area at offset in place, offset has to
+  // be a multiple of 16. psp selects the PSP key
+  void decrypt(u64 offset, u8 *data, u64 size, bool psp);
+
+  // Reads and decrypts an arbitrary range of the data area
+  std::vector<u8> readData(u64 offset, u64 size, bool psp);
+
+  std::shared_ptr<const std::vector<u8>> cachedBlock(u64 key);
+
+  // Decrypted block of the data area, from the cache when possible
+  std::shared_ptr<const std::vector<u8>> block(u64 index, bool psp);
+
+  fs::file file;
+  std::string content;
+  s64 modified = 0;
+  bool debug = false;
+  bool pspPlatform = false;
+  u64 dataOffset = 0;
+  u64 dataSize = 0;
+  u8 qaDigest[16]{};
+  u8 klicensee[16]{};
+  aes_context ps3Key{};
+  aes_context pspKey{};
+  std::vector<Entry> fileEntries;
+
+  struct CachedBlock {
+    u64 key;
+    std::shared_ptr<const std::vector<u8>> data;
+  };
+
+  mutable std::mutex cacheMutex;
+  usz cacheCapacity;
+  std::list<CachedBlock> lru;
+  std::unordered_map<u64, std::list<CachedBlock>::iterator> cached;
+  u64 cachedBytes = 0;
+  CacheStats stats;
+};
+
+// Exposes a PkgArchive as a read-only VFS device. The layout of a game
+// package has PARAM.SFO and USRDIR/EBOOT.BIN at its root, so the root can
+// be booted like an installed title.
+class PkgDevice final : public ArchiveDevice {
+public:
+  explicit PkgDevice(std::shared_ptr<PkgArchive> archive);
+
+  const std::shared_ptr<PkgArchive> &archive() const { return pkg; }
+
+  u64 read(usz entry, u64 offset, void *buffer, u64 size) override;
+
+private:
+  std::shared_ptr<PkgArchive> pkg;
+};
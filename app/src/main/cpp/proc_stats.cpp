@@ -0,0 +1,116 @@
+#include "proc_stats.h"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+std::string readFile(const std::string &path) {
+  std::ifstream stream(path);
+  std::ostringstream result;
+  result << stream.rdbuf();
+  return result.str();
+}
+} // namespace
+
+ThreadClass classifyThread(std::string_view name) {
+  if (name.starts_with("PPU")) {
+    return ThreadClass::ppu;
+  }
+
+  if (name.starts_with("SPU")) {
+    return ThreadClass::spu;
+  }
+
+  if (name.starts_with("rsx") || name.starts_with("RSX")) {
+    return ThreadClass::rsx;
+  }
+
+  return ThreadClass::other;
+}
+
+namespace {
+void forEachTask(
+    const std::function<void(int tid, const std::string &taskDir)> &onTask) {
+  DIR *dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return;
+  }
+
+  while (dirent *entry = readdir(dir)) {
+    const int tid = std::atoi(entry->d_name);
+    if (tid > 0) {
+      onTask(tid, "/proc/self/task/" + std::string(entry->d_name));
+    }
+  }
+
+  closedir(dir);
+}
+
+std::string readThreadName(const std::string &taskDir) {
+  std::string name = readFile(taskDir + "/comm");
+
+  if (!name.empty() && name.back() == '\n') {
+    name.pop_back();
+  }
+
+  return name;
+}
+} // namespace
+
+void forEachThreadName(
+    const std::function<void(int tid, std::string_view name)> &onThread) {
+  forEachTask([&](int tid, const std::string &taskDir) {
+    onThread(tid, readThreadName(taskDir));
+  });
+}
+
+void forEachThreadCpuTime(
+    const std::function<void(int tid, ThreadClass cls, u64 ticks)> &onThread) {
+  forEachTask([&](int tid, const std::string &taskDir) {
+    const std::string name = readThreadName(taskDir);
+    const std::string stat = readFile(taskDir + "/stat");
+
+    // utime and stime are fields 14 and 15, counted after the ")" which
+    // closes the thread name
+    const auto nameEnd = stat.rfind(')');
+    if (nameEnd == std::string::npos || nameEnd + 2 > stat.size()) {
+      return;
+    }
+
+    std::istringstream fields(stat.substr(nameEnd + 2));
+    std::string field;
+    u64 utime = 0, stime = 0;
+
+    for (int i = 3; i <= 15 && fields >> field; i++) {
+      if (i == 14) {
+        utime = std::strtoull(field.c_str(), nullptr, 10);
+      } else if (i == 15) {
+        stime = std::strtoull(field.c_str(), nullptr, 10);
+      }
+    }
+
+    onThread(tid, classifyThread(name), utime + stime);
+  });
+}
+
+u64 clockTicksPerSecond() {
+  static const u64 ticks = static_cast<u64>(sysconf(_SC_CLK_TCK));
+  return ticks;
+}
+
+u64 readProcessMemoryKb(std::string_view field) {
+  std::ifstream stream("/proc/self/status");
+  std::string line;
+
+  while (std::getline(stream, line)) {
+    if (line.starts_with(field)) {
+      return std::strtoull(line.c_str() + field.size(), nullptr, 10);
+    }
+  }
+
+  return 0;
+}
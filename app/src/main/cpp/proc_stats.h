@@ -0,0 +1,35 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <functional>
+#include <string_view>
+
+// Readers for the procfs counters used by the benchmark and telemetry code
+
+enum class ThreadClass : u8 {
+  ppu,
+  spu,
+  rsx,
+  other,
+};
+
+inline constexpr usz kThreadClassCount = 4;
+
+// Classifies a native thread by name. Names are truncated to 15 characters,
+// but the "PPU[0x...", "SPU[0x..." and "rsx::thread" prefixes survive
+ThreadClass classifyThread(std::string_view name);
+
+// Calls onThread with the name of every thread of this process
+void forEachThreadName(
+    const std::function<void(int tid, std::string_view name)> &onThread);
+
+// Calls onThread with the accumulated user + system time of every thread of
+// this process, in clock ticks
+void forEachThreadCpuTime(
+    const std::function<void(int tid, ThreadClass cls, u64 ticks)> &onThread);
+
+u64 clockTicksPerSecond();
+
+// Field of /proc/self/status in kB, e.g. "VmRSS:" or "VmHWM:"
+u64 readProcessMemoryKb(std::string_view field);
@@ -0,0 +1,135 @@
+#include "surface_manager.h"
+
+#include "util/logs.hpp"
+
+LOG_CHANNEL(surface_log, "Surface");
+
+namespace {
+void queryMetrics(SurfaceManager::State &state) {
+  state.width = ANativeWindow_getWidth(state.window);
+  state.height = ANativeWindow_getHeight(state.window);
+  state.format = ANativeWindow_getFormat(state.window);
+}
+} // namespace
+
+void SurfaceManager::onCreated(ANativeWindow *window) {
+  ANativeWindow *prevWindow;
+  State state;
+
+  {
+    std::lock_guard lock(mutex);
+    prevWindow = current.window;
+    current.window = window;
+    queryMetrics(current);
+    current.generation++;
+    state = current;
+  }
+
+  surface_log.notice("Surface created: %dx%d, format %d", state.width,
+                     state.height, state.format);
+
+  cv.notify_all();
+  notify(Event::created, state);
+
+  // Either a stale window which was never reported lost, or the reference
+  // we got for the window we already own
+  if (prevWindow != nullptr) {
+    ANativeWindow_release(prevWindow);
+  }
+}
+
+void SurfaceManager::onChanged() {
+  State state;
+
+  {
+    std::lock_guard lock(mutex);
+
+    if (current.window == nullptr) {
+      return;
+    }
+
+    const State prev = current;
+    queryMetrics(current);
+
+    if (prev.width == current.width && prev.height == current.height &&
+        prev.format == current.format) {
+      return;
+    }
+
+    current.generation++;
+    state = current;
+  }
+
+  surface_log.notice("Surface changed: %dx%d, format %d", state.width,
+                     state.height, state.format);
+
+  notify(Event::changed, state);
+}
+
+void SurfaceManager::onLost() {
+  State state;
+
+  {
+    std::lock_guard lock(mutex);
+
+    if (current.window == nullptr) {
+      return;
+    }
+
+    state = current;
+    current = {.generation = current.generation + 1};
+  }
+
+  surface_log.notice("Surface lost");
+
+  notify(Event::lost, state);
+  ANativeWindow_release(state.window);
+}
+
+SurfaceManager::State SurfaceManager::wait() const {
+  std::unique_lock lock(mutex);
+  cv.wait(lock, [this] { return current.window != nullptr; });
+  return current;
+}
+
+SurfaceManager::State SurfaceManager::acquire() {
+  std::unique_lock lock(mutex);
+  cv.wait(lock, [this] { return current.window != nullptr; });
+
+  if (acquiredGeneration != current.generation) {
+    acquiredGeneration = current.generation;
+    cv.notify_all();
+  }
+
+  return current;
+}
+
+bool SurfaceManager::waitAcquired(u64 generation,
+                                  std::chrono::milliseconds timeout) const {
+  std::unique_lock lock(mutex);
+  return cv.wait_for(lock, timeout,
+                     [&] { return acquiredGeneration >= generation; });
+}
+
+SurfaceManager::State SurfaceManager::state() const {
+  std::lock_guard lock(mutex);
+  return current;
+}
+
+void SurfaceManager::addListener(Listener listener) {
+  std::lock_guard lock(mutex);
+  listeners.push_back(std::move(listener));
+}
+
+void SurfaceManager::notify(Event event, const State &state) {
+  std::vector<Listener> callbacks;
+
+  {
+    std::lock_guard lock(mutex);
+    callbacks = listeners;
+  }
+
+  for (auto &callback : callbacks) {
+    callback(event, state);
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <android/native_window.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Owns the ANativeWindow handed over by the SurfaceHolder callbacks.
+// Threads which need a window sleep in wait() until one arrives, and window
+// metrics are queried once per surface event instead of on every call.
+class SurfaceManager {
+public:
+  enum class Event {
+    created,
+    changed,
+    lost,
+  };
+
+  struct State {
+    ANativeWindow *window = nullptr;
+    s32 width = 0;
+    s32 height = 0;
+    s32 format = 0;
+
+    // Incremented on every event
+    u64 generation = 0;
+  };
+
+  // Listeners run on the thread which delivered the event, after the state
+  // was updated. A lost window stays valid until all listeners returned.
+  using Listener = std::function<void(Event, const State &)>;
+
+  SurfaceManager() = default;
+  SurfaceManager(const SurfaceManager &) = delete;
+  SurfaceManager &operator=(const SurfaceManager &) = delete;
+
+  // Takes over the reference returned by ANativeWindow_fromSurface
+  void onCreated(ANativeWindow *window);
+  void onChanged();
+  void onLost();
+
+  // Blocks until a window is available
+  State wait() const;
+
+  // wait() for the renderer, which builds its swapchain on the returned
+  // window. Records that it moved to the window's generation.
+  State acquire();
+
+  // Waits until the renderer acquired a window of at least generation.
+  // Returns false on timeout.
+  bool waitAcquired(u64 generation, std::chrono::milliseconds timeout) const;
+
+  // Returns the current state without waiting, window may be null
+  State state() const;
+
+  void addListener(Listener listener);
+
+private:
+  void notify(Event event, const State &state);
+
+  mutable std::mutex mutex;
+  mutable std::condition_variable cv;
+  State current;
+  u64 acquiredGeneration = 0;
+  std::vector<Listener> listeners;
+};
@@ -0,0 +1,172 @@
+#include "telemetry.h"
+
+#include "Emu/system_progress.hpp"
+
+#include <cstring>
+#include <pthread.h>
+
+namespace {
+template <typename T> void store(u8 *base, usz offset, T value) {
+  std::memcpy(base + offset, &value, sizeof(value));
+}
+
+u64 *counterAt(u8 *base, usz offset) {
+  return reinterpret_cast<u64 *>(base + offset);
+}
+
+u64 steadyClockNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+} // namespace
+
+TelemetryPublisher::TelemetryPublisher() : buffer(new u8[size()]()) {
+  u8 *header = buffer.get();
+  store<u32>(header, 0, kMagic);
+  store<u32>(header, 4, kVersion);
+  store<u32>(header, 8, kHeaderSize);
+  store<u32>(header, 12, kSampleSize);
+  store<u32>(header, 16, kCapacity);
+}
+
+TelemetryPublisher::~TelemetryPublisher() { stop(); }
+
+void TelemetryPublisher::start(std::chrono::milliseconds period) {
+  std::lock_guard lock(threadMutex);
+
+  if (thread.joinable()) {
+    return;
+  }
+
+  store<u32>(buffer.get(), 20, static_cast<u32>(period.count()));
+  stopRequested = false;
+  thread = std::thread([this, period] {
+    pthread_setname_np(pthread_self(), "Telemetry");
+    run(period);
+  });
+}
+
+void TelemetryPublisher::stop() {
+  std::lock_guard lock(threadMutex);
+
+  if (!thread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard wakeLock(wakeMutex);
+    stopRequested = true;
+  }
+
+  wakeCv.notify_all();
+  thread.join();
+}
+
+void TelemetryPublisher::onFrame(u64 now) {
+  const u64 prev = lastFrame.exchange(now);
+  if (prev == 0 || now <= prev) {
+    return;
+  }
+
+  const u64 frameTime = now - prev;
+  frames++;
+  frameTimeSum += frameTime;
+
+  u64 max = frameTimeMax.load();
+  while (frameTime > max &&
+         !frameTimeMax.compare_exchange_weak(max, frameTime)) {
+  }
+}
+
+void TelemetryPublisher::run(std::chrono::milliseconds period) {
+  // Baseline, so the first sample only shows load since start()
+  threadTicks.clear();
+  forEachThreadCpuTime([this](int tid, ThreadClass, u64 ticks) {
+    threadTicks[tid] = ticks;
+  });
+
+  frames = 0;
+  frameTimeSum = 0;
+  frameTimeMax = 0;
+
+  u64 lastSample = steadyClockNs();
+  auto next = std::chrono::steady_clock::now();
+
+  std::unique_lock lock(wakeMutex);
+
+  while (true) {
+    next += period;
+
+    if (wakeCv.wait_until(lock, next, [this] { return stopRequested; })) {
+      break;
+    }
+
+    lock.unlock();
+
+    const u64 now = steadyClockNs();
+    publish(now, static_cast<f64>(now - lastSample) / 1e9);
+    lastSample = now;
+
+    lock.lock();
+  }
+}
+
+void TelemetryPublisher::publish(u64 now, f64 elapsed) {
+  const u32 frameCount = frames.exchange(0);
+  const u64 frameTimeTotal = frameTimeSum.exchange(0);
+  const u64 frameTimeLongest = frameTimeMax.exchange(0);
+
+  f64 cpuTicks[kThreadClassCount] = {};
+  std::unordered_map<int, u64> currentTicks;
+  currentTicks.reserve(threadTicks.size());
+
+  forEachThreadCpuTime([&](int tid, ThreadClass cls, u64 ticks) {
+    currentTicks[tid] = ticks;
+
+    // Threads which appeared since the last sample are counted in full
+    const auto it = threadTicks.find(tid);
+    const u64 prev =
+        it != threadTicks.end() && it->second <= ticks ? it->second : 0;
+    cpuTicks[static_cast<usz>(cls)] += static_cast<f64>(ticks - prev);
+  });
+
+  threadTicks = std::move(currentTicks);
+
+  const f64 toPercent =
+      elapsed > 0 ? 100.0 / (static_cast<f64>(clockTicksPerSecond()) * elapsed)
+                  : 0;
+
+  const u32 modulesTotal = g_progr_ptotal;
+  const u32 modulesDone = g_progr_pdone;
+
+  const u64 index = published++;
+  u8 *slot = buffer.get() + kHeaderSize + (index % kCapacity) * kSampleSize;
+  u64 *sequence = counterAt(slot, 0);
+
+  // Seqlock: readers retry or skip a slot whose sequence is odd or changed
+  const u64 oldSequence = __atomic_load_n(sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(sequence, oldSequence + 1, __ATOMIC_RELAXED);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  store<u64>(slot, 8, index);
+  store<u64>(slot, 16, now);
+  store<f32>(slot, 24,
+             elapsed > 0 ? static_cast<f32>(frameCount / elapsed) : 0.f);
+  store<f32>(slot, 28,
+             frameCount != 0
+                 ? static_cast<f32>(frameTimeTotal / 1e6 / frameCount)
+                 : 0.f);
+  store<f32>(slot, 32, static_cast<f32>(frameTimeLongest / 1e6));
+
+  for (usz i = 0; i < kThreadClassCount; i++) {
+    store<f32>(slot, 36 + i * 4, static_cast<f32>(cpuTicks[i] * toPercent));
+  }
+
+  store<u32>(slot, 52,
+             modulesTotal > modulesDone ? modulesTotal - modulesDone : 0);
+  store<u64>(slot, 56, readProcessMemoryKb("VmRSS:"));
+
+  __atomic_store_n(sequence, oldSequence + 2, __ATOMIC_RELEASE);
+  __atomic_store_n(counterAt(buffer.get(), 24), published, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "proc_stats.h"
+#include "util/types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Publishes performance samples into a ring shared with Kotlin as a direct
+// ByteBuffer (net.rpcs3.TelemetryReader), so the UI can read a whole window
+// of samples without JNI calls. All values are little endian.
+//
+// Header, kHeaderSize bytes:
+//   0  u32 magic, 4 u32 version, 8 u32 header size, 12 u32 sample size,
+//   16 u32 capacity, 20 u32 period in ms, 24 u64 samples published
+//
+// Sample, kSampleSize bytes, slot (index % capacity):
+//   0  u64 sequence, odd while the slot is written
+//   8  u64 index, 16 u64 steady clock timestamp in ns
+//   24 f32 fps, 28 f32 average frame time ms, 32 f32 max frame time ms
+//   36 f32 PPU, 40 f32 SPU, 44 f32 RSX, 48 f32 other CPU load, in % of a core
+//   52 u32 PPU modules waiting for compilation
+//   56 u64 resident memory in kB
+//
+// Bump kVersion whenever the layout changes.
+class TelemetryPublisher {
+public:
+  static constexpr u32 kMagic = 0x4D4C5452; // "RTLM"
+  static constexpr u32 kVersion = 1;
+  static constexpr u32 kHeaderSize = 64;
+  static constexpr u32 kSampleSize = 64;
+  static constexpr u32 kCapacity = 256;
+
+  TelemetryPublisher();
+  ~TelemetryPublisher();
+
+  TelemetryPublisher(const TelemetryPublisher &) = delete;
+  TelemetryPublisher &operator=(const TelemetryPublisher &) = delete;
+
+  u8 *data() const { return buffer.get(); }
+  static constexpr usz size() { return kHeaderSize + kSampleSize * kCapacity; }
+
+  void start(std::chrono::milliseconds period);
+  void stop();
+
+  // Called by the renderer once per flip
+  void onFrame(u64 now);
+
+private:
+  void run(std::chrono::milliseconds period);
+  void publish(u64 now, f64 elapsed);
+
+  std::unique_ptr<u8[]> buffer;
+
+  std::mutex threadMutex;
+  std::thread thread;
+
+  std::mutex wakeMutex;
+  std::condition_variable wakeCv;
+  bool stopRequested = false;
+
+  // Accumulated by onFrame() between two samples
+  std::atomic<u64> lastFrame = 0;
+  std::atomic<u32> frames = 0;
+  std::atomic<u64> frameTimeSum = 0;
+  std::atomic<u64> frameTimeMax = 0;
+
+  // Owned by the publisher thread
+  std::unordered_map<int, u64> threadTicks;
+  u64 published = 0;
+};
@@ -0,0 +1,313 @@
+#include "thermal_governor.h"
+
+#include "util/logs.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <dirent.h>
+#include <fstream>
+#include <pthread.h>
+
+LOG_CHANNEL(thermal_log, "Thermal");
+
+namespace {
+std::optional<s64> readNumber(const std::string &path) {
+  std::ifstream stream(path);
+  s64 value = 0;
+
+  if (!(stream >> value)) {
+    return std::nullopt;
+  }
+
+  return value;
+}
+
+std::string readLine(const std::string &path) {
+  std::ifstream stream(path);
+  std::string line;
+  std::getline(stream, line);
+  return line;
+}
+
+std::vector<std::string> listEntries(const std::string &root,
+                                     std::string_view prefix) {
+  std::vector<std::string> result;
+
+  DIR *dir = opendir(root.c_str());
+  if (dir == nullptr) {
+    return result;
+  }
+
+  while (dirent *entry = readdir(dir)) {
+    if (std::string_view(entry->d_name).starts_with(prefix)) {
+      result.push_back(root + "/" + entry->d_name);
+    }
+  }
+
+  closedir(dir);
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+bool isCpuZone(std::string type) {
+  std::transform(type.begin(), type.end(), type.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  // Vendors name them cpu-1-0-usr, cpuss-0, tsens_tz_sensor1, mtktscpu,
+  // soc_max, big-cluster...
+  for (std::string_view name :
+       {"cpu", "soc", "tsens", "big", "little", "mid", "prime"}) {
+    if (type.find(name) != std::string::npos) {
+      return true;
+    }
+  }
+
+  return false;
+}
+} // namespace
+
+ThermalSensor::ThermalSensor(std::string thermalRoot,
+                             std::string cpufreqRoot) {
+  std::vector<std::string> allZones;
+
+  for (auto &zone : listEntries(thermalRoot, "thermal_zone")) {
+    if (isCpuZone(readLine(zone + "/type"))) {
+      zones.push_back(zone);
+    }
+
+    allZones.push_back(std::move(zone));
+  }
+
+  // Some kernels only export anonymous zones, the hottest one is still a
+  // better guess than nothing
+  if (zones.empty()) {
+    zones = std::move(allZones);
+  }
+
+  policies = listEntries(cpufreqRoot, "policy");
+}
+
+std::optional<ThermalSample> ThermalSensor::read() const {
+  ThermalSample sample;
+  bool hasTemperature = false;
+
+  for (auto &zone : zones) {
+    auto value = readNumber(zone + "/temp");
+    if (!value) {
+      continue;
+    }
+
+    // Millidegrees on almost every kernel, a few drivers report degrees
+    f64 temperature = static_cast<f64>(*value);
+    if (temperature > 1000 || temperature < -1000) {
+      temperature /= 1000;
+    }
+
+    // Disabled sensors report 0 or garbage
+    if (temperature <= 0 || temperature > 150) {
+      continue;
+    }
+
+    sample.temperature = hasTemperature
+                             ? std::max(sample.temperature, temperature)
+                             : temperature;
+    hasTemperature = true;
+  }
+
+  if (!hasTemperature) {
+    return std::nullopt;
+  }
+
+  for (auto &policy : policies) {
+    const auto cap = readNumber(policy + "/scaling_max_freq");
+    const auto max = readNumber(policy + "/cpuinfo_max_freq");
+
+    if (cap && max && *max > 0) {
+      sample.freqCap = std::min(
+          sample.freqCap, static_cast<f64>(*cap) / static_cast<f64>(*max));
+    }
+  }
+
+  return sample;
+}
+
+const char *thermalLevelName(ThermalLevel level) {
+  switch (level) {
+  case ThermalLevel::nominal:
+    return "nominal";
+  case ThermalLevel::warm:
+    return "warm";
+  case ThermalLevel::hot:
+    return "hot";
+  case ThermalLevel::critical:
+    break;
+  }
+
+  return "critical";
+}
+
+ThermalLevel ThermalController::levelFor(f64 temperature, f64 freqCap) const {
+  auto result = ThermalLevel::nominal;
+
+  for (usz i = 0; i < config.temperatures.size(); i++) {
+    if (temperature >= config.temperatures[i]) {
+      result = static_cast<ThermalLevel>(i + 1);
+    }
+  }
+
+  if (freqCap <= config.criticalFreqCap) {
+    result = ThermalLevel::critical;
+  } else if (freqCap <= config.hotFreqCap) {
+    result = std::max(result, ThermalLevel::hot);
+  }
+
+  return result;
+}
+
+bool ThermalController::update(u64 now, const ThermalSample &sample) {
+  if (!hasSample) {
+    smoothed = sample.temperature;
+    hasSample = true;
+  } else {
+    smoothed += config.smoothing * (sample.temperature - smoothed);
+  }
+
+  if (const ThermalLevel target = levelFor(smoothed, sample.freqCap);
+      target > current) {
+    current = target;
+    calm = false;
+    return true;
+  }
+
+  const ThermalLevel relaxed =
+      levelFor(smoothed + config.temperatureHysteresis,
+               sample.freqCap - config.freqCapHysteresis);
+
+  if (relaxed >= current) {
+    calm = false;
+    return false;
+  }
+
+  if (!calm) {
+    calm = true;
+    calmSince = now;
+    return false;
+  }
+
+  if (now - calmSince < config.cooldownNs) {
+    return false;
+  }
+
+  // One level at a time, the next step down needs another cooldown
+  current = static_cast<ThermalLevel>(static_cast<u8>(current) - 1);
+  calmSince = now;
+  return true;
+}
+
+const ThermalTunables &ThermalController::tunables() const {
+  return config.tunables[static_cast<usz>(current)];
+}
+
+ThermalGovernor::~ThermalGovernor() { stop(); }
+
+void ThermalGovernor::start(ThermalSensor newSensor,
+                            ThermalController newController, ApplyFn newApply,
+                            std::chrono::milliseconds period) {
+  std::lock_guard lock(threadMutex);
+
+  if (thread.joinable()) {
+    return;
+  }
+
+  if (!newSensor.read()) {
+    thermal_log.warning("No readable thermal zone, governor disabled");
+    return;
+  }
+
+  thermal_log.notice("Thermal governor: %u zones, sampling every %u ms",
+                     newSensor.zoneCount(), period.count());
+
+  {
+    std::lock_guard stateLock(mutex);
+    sensor = std::move(newSensor);
+    controller = std::move(newController);
+    apply = std::move(newApply);
+    stopRequested = false;
+  }
+
+  thread = std::thread([this, period] {
+    pthread_setname_np(pthread_self(), "Thermal");
+    run(period);
+  });
+}
+
+void ThermalGovernor::stop() {
+  std::lock_guard lock(threadMutex);
+
+  if (!thread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard stateLock(mutex);
+    stopRequested = true;
+  }
+
+  wakeCv.notify_all();
+  thread.join();
+}
+
+void ThermalGovernor::pause() {
+  // apply is called with the mutex held
+  std::lock_guard lock(mutex);
+  paused = true;
+}
+
+void ThermalGovernor::resume() {
+  std::lock_guard lock(mutex);
+  paused = false;
+
+  if (apply && controller.level() != ThermalLevel::nominal) {
+    apply(controller.tunables());
+  }
+}
+
+ThermalLevel ThermalGovernor::level() const {
+  std::lock_guard lock(mutex);
+  return controller.level();
+}
+
+void ThermalGovernor::run(std::chrono::milliseconds period) {
+  std::unique_lock lock(mutex);
+
+  while (!wakeCv.wait_for(lock, period, [this] { return stopRequested; })) {
+    // The sensor is only touched by this thread
+    lock.unlock();
+    const auto sample = sensor->read();
+    lock.lock();
+
+    if (!sample) {
+      continue;
+    }
+
+    const ThermalLevel prev = controller.level();
+    const u64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+
+    // While paused the level is still tracked, resume() applies it
+    if (!controller.update(now, *sample) || paused) {
+      continue;
+    }
+
+    const auto &tunables = controller.tunables();
+    thermal_log.warning(
+        "%s -> %s at %.1f C, cpufreq cap %.0f%%: SPU threads %u, frame limit "
+        "%u, compile threads %u (0 = user setting)",
+        thermalLevelName(prev), thermalLevelName(controller.level()),
+        controller.temperature(), sample->freqCap * 100, tunables.spuThreads,
+        tunables.frameLimit, tunables.compileThreads);
+
+    apply(tunables);
+  }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ThermalSample {
+  // Hottest CPU zone in degrees Celsius
+  f64 temperature = 0;
+
+  // Lowest scaling_max_freq / cpuinfo_max_freq over all cpufreq policies, 1
+  // while the kernel does not cap the CPU
+  f64 freqCap = 1;
+};
+
+// Reads CPU temperatures and cpufreq caps from sysfs. Both roots are
+// parameters so recorded traces can be replayed from a fake tree.
+class ThermalSensor {
+public:
+  static constexpr const char *kDefaultThermalRoot = "/sys/class/thermal";
+  static constexpr const char *kDefaultCpufreqRoot =
+      "/sys/devices/system/cpu/cpufreq";
+
+  explicit ThermalSensor(std::string thermalRoot = kDefaultThermalRoot,
+                         std::string cpufreqRoot = kDefaultCpufreqRoot);
+
+  // Nothing when no zone could be read
+  std::optional<ThermalSample> read() const;
+
+  usz zoneCount() const { return zones.size(); }
+
+private:
+  std::vector<std::string> zones;
+  std::vector<std::string> policies;
+};
+
+enum class ThermalLevel : u8 {
+  nominal,
+  warm,
+  hot,
+  critical,
+};
+
+inline constexpr usz kThermalLevelCount = 4;
+
+const char *thermalLevelName(ThermalLevel level);
+
+// Emulator settings for a thermal level, zero keeps the user's setting
+struct ThermalTunables {
+  u32 spuThreads = 0;
+  u32 frameLimit = 0;
+  u32 compileThreads = 0;
+
+  bool operator==(const ThermalTunables &) const = default;
+};
+
+// Decides the thermal level from samples. Levels go up as soon as a
+// threshold is crossed, but only come down one at a time after the sensors
+// stayed below the threshold minus the hysteresis for the whole cooldown, so
+// the settings do not flap around a threshold. Pure logic, time is passed in
+// as steady clock nanoseconds.
+class ThermalController {
+public:
+  struct Config {
+    // Temperature at which warm, hot and critical start
+    std::array<f64, kThermalLevelCount - 1> temperatures = {70, 80, 90};
+
+    // freqCap at or below which hot and critical start. The kernel capping
+    // the clocks means the SoC is already throttling
+    f64 hotFreqCap = 0.85;
+    f64 criticalFreqCap = 0.6;
+
+    f64 temperatureHysteresis = 5;
+    f64 freqCapHysteresis = 0.05;
+    u64 cooldownNs = 30'000'000'000;
+
+    // Smoothing of the temperature, sensors report single hot spots
+    f64 smoothing = 0.3;
+
+    std::array<ThermalTunables, kThermalLevelCount> tunables = {{
+        {},
+        {.compileThreads = 2},
+        {.spuThreads = 3, .frameLimit = 30, .compileThreads = 1},
+        {.spuThreads = 2, .frameLimit = 30, .compileThreads = 1},
+    }};
+  };
+
+  ThermalController() = default;
+  explicit ThermalController(const Config &settings) : config(settings) {}
+
+  // Returns true when the level changed
+  bool update(u64 now, const ThermalSample &sample);
+
+  ThermalLevel level() const { return current; }
+  f64 temperature() const { return smoothed; }
+  const ThermalTunables &tunables() const;
+
+private:
+  ThermalLevel levelFor(f64 temperature, f64 freqCap) const;
+
+  Config config;
+  ThermalLevel current = ThermalLevel::nominal;
+  f64 smoothed = 0;
+  bool hasSample = false;
+  bool calm = false;
+  u64 calmSince = 0;
+};
+
+// Samples a ThermalSensor on its own thread and hands the tunables of every
+// new level to the apply callback. Every change is logged.
+class ThermalGovernor {
+public:
+  using ApplyFn = std::function<void(const ThermalTunables &)>;
+
+  ~ThermalGovernor();
+
+  void start(ThermalSensor sensor, ThermalController controller,
+             ApplyFn apply, std::chrono::milliseconds period);
+  void stop();
+
+  // Holds back level changes until resume(), e.g. while a boot reloads the
+  // settings. Returns once an apply in progress finished
+  void pause();
+
+  // Calls the apply callback with the current tunables unless nominal, and
+  // applies level changes again
+  void resume();
+
+  ThermalLevel level() const;
+
+private:
+  void run(std::chrono::milliseconds period);
+
+  std::mutex threadMutex;
+  std::thread thread;
+
+  mutable std::mutex mutex;
+  std::condition_variable wakeCv;
+  bool stopRequested = false;
+  bool paused = false;
+  std::optional<ThermalSensor> sensor;
+  ThermalController controller;
+  ApplyFn apply;
+};
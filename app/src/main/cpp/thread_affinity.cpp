@@ -0,0 +1,290 @@
+#include "thread_affinity.h"
+
+#include "proc_stats.h"
+#include "util/logs.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unordered_set>
+
+LOG_CHANNEL(affinity_log, "Affinity");
+
+namespace {
+bool setThreadAffinity(int tid, u64 mask) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  for (u32 cpu = 0; cpu < 64; cpu++) {
+    if (mask & (u64{1} << cpu)) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  return sched_setaffinity(tid, sizeof(set), &set) == 0;
+}
+
+std::string maskToString(u64 mask) {
+  std::string result;
+
+  for (u32 cpu = 0; cpu < 64; cpu++) {
+    if (mask & (u64{1} << cpu)) {
+      result += result.empty() ? "" : ",";
+      result += std::to_string(cpu);
+    }
+  }
+
+  return result.empty() ? "any" : result;
+}
+} // namespace
+
+ThreadRole classifyThreadRole(std::string_view name) {
+  // Thread names are truncated to 15 characters
+  for (std::string_view prefix : {"PPU Worker", "SPU Worker", "SPRX Worker",
+                                  "LLVM", "PPU Precompile"}) {
+    if (name.starts_with(prefix)) {
+      return ThreadRole::compiler;
+    }
+  }
+
+  for (std::string_view prefix :
+       {"cellFs", "FS ", "File ", "Log Sink", "Binary Log", "Telemetry"}) {
+    if (name.starts_with(prefix)) {
+      return ThreadRole::io;
+    }
+  }
+
+  switch (classifyThread(name)) {
+  case ThreadClass::ppu:
+    return ThreadRole::ppu;
+  case ThreadClass::spu:
+    return ThreadRole::spu;
+  case ThreadClass::rsx:
+    return ThreadRole::rsx;
+  case ThreadClass::other:
+    break;
+  }
+
+  return ThreadRole::other;
+}
+
+const char *threadRoleName(ThreadRole role) {
+  switch (role) {
+  case ThreadRole::ppu:
+    return "PPU";
+  case ThreadRole::spu:
+    return "SPU";
+  case ThreadRole::rsx:
+    return "RSX";
+  case ThreadRole::compiler:
+    return "Compiler";
+  case ThreadRole::io:
+    return "I/O";
+  case ThreadRole::other:
+    break;
+  }
+
+  return "Other";
+}
+
+AffinityPolicy AffinityPolicy::fromTopology(const CpuTopology &topology) {
+  AffinityPolicy result;
+
+  if (!topology.isHeterogeneous()) {
+    return result;
+  }
+
+  const auto &clusters = topology.clusters();
+  const u64 little = clusters.front().mask();
+  const u64 all = topology.mask();
+  const u64 big = all & ~little;
+
+  // With a single fast core the guest threads would queue behind each other,
+  // sharing the little cores is the lesser evil then
+  const u64 guest = std::popcount(big) >= 2 ? big : 0;
+
+  result.masks[static_cast<usz>(ThreadRole::ppu)] = guest;
+  result.masks[static_cast<usz>(ThreadRole::spu)] = guest;
+  result.masks[static_cast<usz>(ThreadRole::rsx)] = guest;
+
+  // Compilation is throughput bound, mostly runs before the title starts and
+  // would otherwise be stuck on whatever core its parent was placed on
+  result.masks[static_cast<usz>(ThreadRole::compiler)] = all;
+  result.masks[static_cast<usz>(ThreadRole::io)] = little;
+
+  // Threads inherit the mask of the thread which started them, give the rest
+  // every core back
+  result.masks[static_cast<usz>(ThreadRole::other)] = all;
+
+  return result;
+}
+
+bool AffinityPolicy::empty() const {
+  for (u64 mask : masks) {
+    if (mask != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::string AffinityPolicy::toString() const {
+  std::string result;
+
+  for (usz i = 0; i < kThreadRoleCount; i++) {
+    if (!result.empty()) {
+      result += ", ";
+    }
+
+    result += threadRoleName(static_cast<ThreadRole>(i));
+    result += ": ";
+    result += maskToString(masks[i]);
+  }
+
+  return result;
+}
+
+ThreadPlacer::~ThreadPlacer() { stop(); }
+
+void ThreadPlacer::start(const AffinityPolicy &newPolicy,
+                         std::chrono::milliseconds period,
+                         std::chrono::milliseconds maxPeriod) {
+  std::lock_guard lock(threadMutex);
+
+  if (thread.joinable()) {
+    return;
+  }
+
+  affinity_log.notice("Thread placement: %s", newPolicy.toString());
+
+  if (newPolicy.empty()) {
+    return;
+  }
+
+  policy = newPolicy;
+  placed.clear();
+  stopRequested = false;
+  thread = std::thread([this, period, maxPeriod] {
+    pthread_setname_np(pthread_self(), "Thread Placer");
+    run(period, maxPeriod);
+  });
+}
+
+void ThreadPlacer::stop() {
+  std::lock_guard lock(threadMutex);
+
+  if (!thread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard wakeLock(wakeMutex);
+    stopRequested = true;
+  }
+
+  wakeCv.notify_all();
+  thread.join();
+}
+
+void ThreadPlacer::activate() {
+  {
+    std::lock_guard lock(wakeMutex);
+    active = true;
+    activations++;
+  }
+
+  wakeCv.notify_all();
+}
+
+void ThreadPlacer::deactivate() {
+  std::lock_guard lock(wakeMutex);
+  active = false;
+}
+
+void ThreadPlacer::run(std::chrono::milliseconds period,
+                       std::chrono::milliseconds maxPeriod) {
+  std::unique_lock lock(wakeMutex);
+  auto delay = period;
+  u64 seenActivations = activations;
+
+  while (true) {
+    // Waits for the delay while active, indefinitely otherwise. A new
+    // activation scans right away
+    const auto woken = [&] {
+      return stopRequested || activations != seenActivations;
+    };
+
+    if (active) {
+      wakeCv.wait_for(lock, delay, woken);
+    } else {
+      wakeCv.wait(lock, woken);
+    }
+
+    if (stopRequested) {
+      return;
+    }
+
+    if (activations != seenActivations) {
+      seenActivations = activations;
+      delay = period;
+    }
+
+    if (!active) {
+      continue;
+    }
+
+    lock.unlock();
+    const usz count = scan();
+    lock.lock();
+
+    // Threads are mostly started while a title boots, once that settled
+    // there is little point in walking /proc/self/task often
+    delay = count != 0 ? period : std::min(delay * 2, maxPeriod);
+  }
+}
+
+usz ThreadPlacer::scan() {
+  std::unordered_set<int> alive;
+  usz count = 0;
+
+  forEachThreadName([&](int tid, std::string_view name) {
+    alive.insert(tid);
+
+    auto [it, inserted] = placed.try_emplace(tid, name);
+    if (!inserted) {
+      if (it->second == name) {
+        return;
+      }
+
+      it->second = name;
+    }
+
+    const std::string &threadName = it->second;
+    const ThreadRole role = classifyThreadRole(threadName);
+    const u64 mask = policy.mask(role);
+
+    if (mask == 0) {
+      return;
+    }
+
+    if (!setThreadAffinity(tid, mask)) {
+      affinity_log.warning("Failed to place thread %d (%s): %s", tid,
+                           threadName, strerror(errno));
+      return;
+    }
+
+    affinity_log.trace("Placed %s thread %d (%s) on %s", threadRoleName(role),
+                       tid, threadName, maskToString(mask));
+    count++;
+  });
+
+  std::erase_if(placed, [&](const auto &entry) {
+    return !alive.contains(entry.first);
+  });
+
+  return count;
+}
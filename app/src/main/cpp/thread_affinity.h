@@ -0,0 +1,85 @@
+#pragma once
+
+#include "cpu_topology.h"
+#include "util/types.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+enum class ThreadRole : u8 {
+  ppu,
+  spu,
+  rsx,
+  compiler,
+  io,
+  other,
+};
+
+inline constexpr usz kThreadRoleCount = 6;
+
+// Classifies a thread by the name named_thread gives it. LLVM workers are
+// checked first, their names start with "PPU" and "SPU" as well
+ThreadRole classifyThreadRole(std::string_view name);
+
+const char *threadRoleName(ThreadRole role);
+
+// CPU mask for every thread role, zero leaves the thread's mask alone
+struct AffinityPolicy {
+  std::array<u64, kThreadRoleCount> masks{};
+
+  u64 mask(ThreadRole role) const { return masks[static_cast<usz>(role)]; }
+
+  // Guest threads go to the big clusters, compilers may use every core and
+  // I/O stays on the little cluster. Homogeneous CPUs get an empty policy
+  static AffinityPolicy fromTopology(const CpuTopology &topology);
+
+  bool empty() const;
+  std::string toString() const;
+};
+
+// Applies an AffinityPolicy to the threads of this process. rpcs3 has no
+// hook for thread creation, so /proc/self/task is polled and new threads are
+// placed within one period of starting. A thread is placed again when it
+// renames itself, named_thread does that right after it started.
+//
+// Polling only happens while the placer is active, i.e. while a title runs.
+// Every scan which finds nothing to place doubles the period up to
+// maxPeriod, activate() goes back to the initial period.
+class ThreadPlacer {
+public:
+  ~ThreadPlacer();
+
+  void start(const AffinityPolicy &policy, std::chrono::milliseconds period,
+             std::chrono::milliseconds maxPeriod);
+  void stop();
+
+  // Scans right away and keeps polling until deactivate()
+  void activate();
+  void deactivate();
+
+  // Places threads started or renamed since the last scan, returns how many
+  usz scan();
+
+private:
+  void run(std::chrono::milliseconds period,
+           std::chrono::milliseconds maxPeriod);
+
+  std::mutex threadMutex;
+  std::thread thread;
+
+  std::mutex wakeMutex;
+  std::condition_variable wakeCv;
+  bool stopRequested = false;
+  bool active = false;
+  u64 activations = 0;
+
+  // Owned by the placer thread
+  AffinityPolicy policy;
+  std::unordered_map<int, std::string> placed;
+};
@@ -0,0 +1,122 @@
+#include "usb_device_registry.h"
+
+#include <algorithm>
+
+namespace {
+constexpr u16 kSonyVendorId = 0x054C;
+
+struct KnownPad {
+  u16 productId;
+  UsbPadType type;
+};
+
+// Product ids the rpcs3 HID handlers open
+constexpr KnownPad kKnownPads[] = {
+    {0x0268, UsbPadType::ds3},       // DualShock 3
+    {0x05C4, UsbPadType::ds4},       // DualShock 4
+    {0x09CC, UsbPadType::ds4},       // DualShock 4 v2
+    {0x0BA0, UsbPadType::ds4},       // DualShock 4 wireless adapter
+    {0x0CE6, UsbPadType::dualsense}, // DualSense
+    {0x0DF2, UsbPadType::dualsense}, // DualSense Edge
+};
+} // namespace
+
+const char *usbPadTypeName(UsbPadType type) {
+  switch (type) {
+  case UsbPadType::ds3:
+    return "DS3";
+  case UsbPadType::ds4:
+    return "DS4";
+  case UsbPadType::dualsense:
+    return "DualSense";
+  case UsbPadType::unknown:
+    break;
+  }
+
+  return "unknown";
+}
+
+std::string usbPadDeviceName(const UsbDevice &device) {
+  // The prefixes ds3_pad_handler, ds4_pad_handler and dualsense_pad_handler
+  // pass to hid_pad_handler
+  switch (device.type) {
+  case UsbPadType::ds3:
+    return "DS3 Pad #" + std::to_string(device.padIndex + 1);
+  case UsbPadType::ds4:
+    return "DS4 Pad #" + std::to_string(device.padIndex + 1);
+  case UsbPadType::dualsense:
+    return "DualSense Pad #" + std::to_string(device.padIndex + 1);
+  case UsbPadType::unknown:
+    break;
+  }
+
+  return {};
+}
+
+UsbPadType UsbDeviceRegistry::classify(u16 vendorId, u16 productId) {
+  if (vendorId != kSonyVendorId) {
+    return UsbPadType::unknown;
+  }
+
+  for (auto &pad : kKnownPads) {
+    if (pad.productId == productId) {
+      return pad.type;
+    }
+  }
+
+  return UsbPadType::unknown;
+}
+
+std::optional<UsbDevice> UsbDeviceRegistry::attach(int fd, u16 vendorId,
+                                                   u16 productId) {
+  std::lock_guard lock(mutex);
+
+  if (std::ranges::find(entries, fd, &UsbDevice::fd) != entries.end()) {
+    return std::nullopt;
+  }
+
+  UsbDevice device{
+      .fd = fd,
+      .vendorId = vendorId,
+      .productId = productId,
+      .type = classify(vendorId, productId),
+  };
+
+  if (device.type != UsbPadType::unknown) {
+    for (u32 player = 0; player < kMaxPlayers; player++) {
+      if (std::ranges::none_of(entries, [player](const UsbDevice &dev) {
+            return dev.player == player;
+          })) {
+        device.player = player;
+        break;
+      }
+    }
+
+    while (std::ranges::any_of(entries, [&](const UsbDevice &dev) {
+      return dev.type == device.type && dev.padIndex == device.padIndex;
+    })) {
+      device.padIndex++;
+    }
+  }
+
+  entries.push_back(device);
+  return device;
+}
+
+std::optional<UsbDevice> UsbDeviceRegistry::detach(int fd) {
+  std::lock_guard lock(mutex);
+
+  auto it = std::ranges::find(entries, fd, &UsbDevice::fd);
+  if (it == entries.end()) {
+    return std::nullopt;
+  }
+
+  const UsbDevice device = *it;
+  entries.erase(it);
+  return device;
+}
+
+std::vector<UsbDevice> UsbDeviceRegistry::devices() const {
+  std::lock_guard lock(mutex);
+  return entries;
+}
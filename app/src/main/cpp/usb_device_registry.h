@@ -0,0 +1,60 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class UsbPadType : u8 {
+  unknown,
+  ds3,
+  ds4,
+  dualsense,
+};
+
+const char *usbPadTypeName(UsbPadType type);
+
+struct UsbDevice {
+  static constexpr u32 kNoPlayer = ~0u;
+
+  int fd = -1;
+  u16 vendorId = 0;
+  u16 productId = 0;
+  UsbPadType type = UsbPadType::unknown;
+
+  // Player slot the pad was bound to, kNoPlayer for other devices and pads
+  // attached while every slot was taken
+  u32 player = kNoPlayer;
+
+  // Lowest index not taken by another attached pad of the same type. The HID
+  // handlers number their devices the same way
+  u32 padIndex = 0;
+};
+
+// Name the rpcs3 HID handler gives the pad, e.g. "DS4 Pad #2". Empty for
+// unknown devices
+std::string usbPadDeviceName(const UsbDevice &device);
+
+// USB devices Android granted us, keyed by the fd of their connection. Known
+// pads are bound to the lowest free player slot when they are attached and
+// free it again when they are detached, every other device stays untouched.
+class UsbDeviceRegistry {
+public:
+  static constexpr u32 kMaxPlayers = 7;
+
+  static UsbPadType classify(u16 vendorId, u16 productId);
+
+  // Nothing when the fd is already registered
+  std::optional<UsbDevice> attach(int fd, u16 vendorId, u16 productId);
+
+  // Nothing when the fd was not registered
+  std::optional<UsbDevice> detach(int fd);
+
+  std::vector<UsbDevice> devices() const;
+
+private:
+  mutable std::mutex mutex;
+  std::vector<UsbDevice> entries;
+};
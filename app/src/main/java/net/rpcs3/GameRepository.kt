@@ -61,13 +61,18 @@ class GameRepository {
     companion object {
         private val instance = GameRepository()
 
+        // Roots of the PKGs mounted in this session, their paths are gone after a restart
+        private val mountedRoots = mutableSetOf<String>()
+
         fun save() {
             try {
                 File(RPCS3.rootDirectory + "games.json").writeText(Json.encodeToString(instance.games.map { game ->
                     toInfo(
                         game.info
                     )
-                }.filter { info -> info.path != "$" }))
+                }.filter { info ->
+                    info.path != "$" && mountedRoots.none { root -> info.path.startsWith(root) }
+                }))
             } catch (e: Exception) {
                 e.printStackTrace()
             }
@@ -108,17 +113,38 @@ class GameRepository {
                         existsGame.info.name.value = info.name ?: existsGame.info.name.value
                         existsGame.info.iconPath.value =
                             info.iconPath ?: existsGame.info.iconPath.value
-                        existsGame.addProgress(GameProgress(progressId, GameProgressType.Install))
+
+                        // cached entries can be reported again once the scan finds them modified
+                        if (existsGame.progressList.none { progress -> progress.id == progressId }) {
+                            existsGame.addProgress(GameProgress(progressId, GameProgressType.Install))
+                        }
                     }
                 }
                 save()
             }
         }
 
+        // Titles the native scan no longer finds, deleted or not bootable anymore
+        @JvmStatic
+        fun removePaths(paths: Array<String>) {
+            synchronized(instance) {
+                val removed = paths.toSet()
+                if (instance.games.removeIf { game -> game.info.path in removed }) {
+                    save()
+                }
+            }
+        }
+
         fun addPreview(gameInfos: Array<GameInfo>) {
             instance.games += gameInfos.map { info -> Game(toStore(info)) }
         }
 
+        fun addMountedRoot(root: String) {
+            synchronized(instance) {
+                mountedRoots += root
+            }
+        }
+
         fun onBoot(game: Game) {
             synchronized(instance) {
                 if (instance.games.first() != game) {
@@ -2,11 +2,14 @@ package net.rpcs3
 
 import android.content.Context
 import android.util.AttributeSet
+import android.view.Choreographer
 import android.view.SurfaceHolder
 import android.view.SurfaceView
 import kotlin.concurrent.thread
 
-class GraphicsFrame : SurfaceView, SurfaceHolder.Callback {
+class GraphicsFrame : SurfaceView, SurfaceHolder.Callback, Choreographer.FrameCallback {
+    private var vsyncActive = false
+
     constructor(context: Context) : super(context) {
         holder.addCallback(this)
     }
@@ -38,8 +41,23 @@ class GraphicsFrame : SurfaceView, SurfaceHolder.Callback {
         }
     }
 
+    override fun doFrame(frameTimeNanos: Long) {
+        if (!vsyncActive) {
+            return
+        }
+
+        RPCS3.instance.displayEvent(display?.refreshRate ?: 0f, frameTimeNanos)
+        Choreographer.getInstance().postFrameCallback(this)
+    }
+
     override fun surfaceCreated(p0: SurfaceHolder) {
         RPCS3.instance.surfaceEvent(p0.surface, 0)
+
+        // Feed vsync timestamps to the frame pacer while there is something to present to
+        if (!vsyncActive) {
+            vsyncActive = true
+            Choreographer.getInstance().postFrameCallback(this)
+        }
     }
 
     override fun surfaceChanged(p0: SurfaceHolder, p1: Int, p2: Int, p3: Int) {
@@ -47,6 +65,8 @@ class GraphicsFrame : SurfaceView, SurfaceHolder.Callback {
     }
 
     override fun surfaceDestroyed(p0: SurfaceHolder) {
+        vsyncActive = false
+        Choreographer.getInstance().removeFrameCallback(this)
         RPCS3.instance.surfaceEvent(p0.surface, 2)
     }
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+package net.rpcs3
+
+import androidx.compose.runtime.MutableState
+import androidx.compose.runtime.mutableStateOf
+import kotlinx.serialization.Serializable
+import kotlinx.serialization.json.Json
+import java.io.File
+
+@Serializable
+private data class InputSettingsInfo(val eventDriven: Boolean = false)
+
+class InputSettings {
+    companion object {
+        // Wake the pad thread on USB reports instead of polling, see setEventDrivenInput
+        val eventDriven: MutableState<Boolean> = mutableStateOf(false)
+
+        private fun file() = File(RPCS3.rootDirectory + "input.json")
+
+        fun load() {
+            try {
+                val file = file()
+                if (file.exists()) {
+                    val info = Json.decodeFromString<InputSettingsInfo>(file.readText())
+                    eventDriven.value = info.eventDriven
+                }
+            } catch (e: Exception) {
+                e.printStackTrace()
+            }
+
+            if (eventDriven.value && !RPCS3.instance.setEventDrivenInput(true)) {
+                eventDriven.value = false
+            }
+        }
+
+        fun setEventDriven(enabled: Boolean) {
+            if (!RPCS3.instance.setEventDrivenInput(enabled)) {
+                return
+            }
+
+            eventDriven.value = enabled
+
+            try {
+                file().writeText(Json.encodeToString(InputSettingsInfo(enabled)))
+            } catch (e: Exception) {
+                e.printStackTrace()
+            }
+        }
+    }
+}
@@ -1,5 +1,6 @@
 package net.rpcs3
 
+import android.app.ActivityManager
 import android.app.Notification
 import android.app.NotificationChannel
 import android.app.NotificationManager
@@ -104,6 +105,16 @@ class MainActivity : ComponentActivity() {
 
         RPCS3.instance.initialize(RPCS3.rootDirectory)
 
+        // Firmware packages are installed concurrently within this much memory
+        val memoryInfo = ActivityManager.MemoryInfo()
+        (getSystemService(ACTIVITY_SERVICE) as ActivityManager).getMemoryInfo(memoryInfo)
+        RPCS3.instance.setFirmwareInstallMemoryWindow(
+            (memoryInfo.totalMem / 16).coerceIn(32L shl 20, 512L shl 20)
+        )
+
+        MemoryPressure.register(this)
+        InputSettings.load()
+
         val filter = IntentFilter()
         filter.addAction(UsbManager.ACTION_USB_DEVICE_DETACHED)
         filter.addAction(UsbManager.ACTION_USB_DEVICE_ATTACHED)
@@ -0,0 +1,34 @@
+package net.rpcs3
+
+import android.content.ComponentCallbacks2
+import android.content.Context
+import android.content.res.Configuration
+
+/**
+ * Forwards the system's memory pressure signals to the native cache registry. Registered on the
+ * application context so every level is delivered once, whichever activity is alive.
+ */
+object MemoryPressure : ComponentCallbacks2 {
+    private var registered = false
+
+    fun register(context: Context) {
+        if (registered) {
+            return
+        }
+
+        registered = true
+        context.applicationContext.registerComponentCallbacks(this)
+    }
+
+    override fun onTrimMemory(level: Int) {
+        RPCS3.instance.trimMemory(level)
+    }
+
+    override fun onConfigurationChanged(newConfig: Configuration) {}
+
+    @Deprecated("Deprecated in Java")
+    @Suppress("DEPRECATION")
+    override fun onLowMemory() {
+        RPCS3.instance.trimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+    }
+}
@@ -1,14 +1,65 @@
 package net.rpcs3
 
 import android.view.Surface
+import java.nio.ByteBuffer
 
 class RPCS3 {
     external fun initialize(rootDir: String): Boolean
     external fun installFw(fd: Int, progressId: Long): Boolean
+
+    // Memory the firmware installer may use for packages in flight, at least 32 MB
+    external fun setFirmwareInstallMemoryWindow(bytes: Long): Boolean
+    external fun compileFirmware(progressId: Long): Boolean
     external fun installPkgFile(fd: Int, progressId: Long): Boolean
+    external fun installPkgFiles(fds: IntArray, progressId: Long): Boolean
+    external fun collectGameInfo(rootDir: String, progressId: Long): Boolean
+
+    // Serves the package contents read-only without installing it, returns the path of its
+    // root. Mounts last until the process exits
+    external fun mountPkg(fd: Int): String?
+
+    // Summed over mounted disc images (.rdim), reset clears them after reading:
+    // [reads, MB read, cache hits, cache misses, hit rate %, compressed MB read, inflate ms]
+    external fun getDiscImageStats(reset: Boolean): DoubleArray
     external fun boot(path: String): Boolean
+    external fun precompileGame(path: String, progressId: Long): Boolean
+
+    // Runs a title with Null renderer and audio for frames and/or seconds (0 = no limit), writes a JSON report
+    external fun runBenchmark(path: String, frames: Int, seconds: Int, reportPath: String): Boolean
     external fun surfaceEvent(surface: Surface, event: Int): Boolean
-    external fun usbDeviceEvent(fd: Int, event: Int): Boolean
+    external fun displayEvent(refreshRate: Float, vsyncTimeNanos: Long)
+
+    // [refresh rate, frames, missed deadlines, average frame time ms, max frame time ms, vsyncs per frame]
+    external fun getFramePacingStats(): DoubleArray
+
+    // format: 0 = RGBA8888, 1 = BGRA8888, 2 = RGB565. maxRate 0 delivers every frame
+    external fun configureFrameConsumer(maxRate: Int, scaleDivisor: Int, format: Int): Boolean
+    external fun disableFrameConsumer()
+
+    // The buffer wraps native memory and is only valid until releaseFrame()
+    external fun acquireFrame(timeoutMs: Int): ByteBuffer?
+
+    // [width, height, pitch, format, sequence, timestamp ns] of the acquired frame
+    external fun getAcquiredFrameInfo(): LongArray?
+    external fun releaseFrame()
+
+    // Starts sampling every periodMs and returns the shared ring for TelemetryReader (API 33+)
+    external fun startTelemetry(periodMs: Int): ByteBuffer?
+    external fun stopTelemetry()
+
+    // level is the ComponentCallbacks2 trim level, returns the bytes reclaimed
+    external fun trimMemory(level: Int): Long
+
+    // Bytes reclaimed so far for each trim level, RUNNING_MODERATE to COMPLETE
+    external fun getMemoryTrimStats(): LongArray
+    // Wakes the pad thread on USB reports instead of polling it
+    external fun setEventDrivenInput(enabled: Boolean): Boolean
+
+    // [reports, wakeups, average wake us, max wake us, frames, average report to flip ms, max ms]
+    external fun getInputLatencyStats(): DoubleArray
+    // event: 0 = attached, 1 = detached
+    external fun usbDeviceEvent(fd: Int, vendorId: Int, productId: Int, event: Int): Boolean
+    external fun setLogLevel(channel: String, level: Int): Boolean
 
     companion object {
         val instance = RPCS3()
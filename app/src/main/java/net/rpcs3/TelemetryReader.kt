@@ -0,0 +1,115 @@
+package net.rpcs3
+
+import android.os.Build
+import androidx.annotation.RequiresApi
+import java.lang.invoke.MethodHandles
+import java.lang.invoke.VarHandle
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Samples copied out of the telemetry ring, oldest first. Preallocated so polling from the UI
+ * does not allocate.
+ */
+class TelemetryWindow(capacity: Int = TelemetryReader.CAPACITY) {
+    var count = 0
+    val index = LongArray(capacity)
+    val timestampNanos = LongArray(capacity)
+    val fps = FloatArray(capacity)
+    val averageFrameTimeMs = FloatArray(capacity)
+    val maxFrameTimeMs = FloatArray(capacity)
+    val ppuLoad = FloatArray(capacity)
+    val spuLoad = FloatArray(capacity)
+    val rsxLoad = FloatArray(capacity)
+    val otherLoad = FloatArray(capacity)
+    val compileQueue = IntArray(capacity)
+    val rssKb = LongArray(capacity)
+
+    val capacity get() = index.size
+}
+
+/**
+ * Reads the ring published by native TelemetryPublisher (see telemetry.h for the layout). Slots
+ * which are being written while they are read are skipped instead of retried, a sample is
+ * published at most every few milliseconds so losing one is harmless.
+ *
+ * Needs API 33: sequences are read with acquire semantics through a VarHandle, before that
+ * Kotlin has no way to order plain ByteBuffer loads against them.
+ */
+@RequiresApi(Build.VERSION_CODES.TIRAMISU)
+class TelemetryReader(buffer: ByteBuffer) {
+    private val buffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+
+    val periodMs: Int
+
+    init {
+        require(this.buffer.capacity() >= HEADER_SIZE + SAMPLE_SIZE * CAPACITY) {
+            "telemetry buffer is too small"
+        }
+        require(this.buffer.getInt(0) == MAGIC) { "bad telemetry magic" }
+        require(this.buffer.getInt(4) == VERSION) {
+            "unsupported telemetry version ${this.buffer.getInt(4)}"
+        }
+        require(this.buffer.getInt(8) == HEADER_SIZE && this.buffer.getInt(12) == SAMPLE_SIZE &&
+                this.buffer.getInt(16) == CAPACITY) { "unexpected telemetry layout" }
+
+        periodMs = this.buffer.getInt(20)
+    }
+
+    fun published(): Long = LONGS.getAcquire(buffer, 24) as Long
+
+    /**
+     * Copies up to [maxSamples] of the newest samples into [window], returns the number of
+     * samples copied.
+     */
+    fun read(window: TelemetryWindow, maxSamples: Int = window.capacity): Int {
+        val published = published()
+        // The slot after the newest one may already be rewritten, don't count on it
+        val wanted = minOf(maxSamples, window.capacity, CAPACITY - 1).toLong()
+        val first = maxOf(0L, published - wanted)
+
+        window.count = 0
+
+        for (i in first until published) {
+            val slot = HEADER_SIZE + (i % CAPACITY).toInt() * SAMPLE_SIZE
+            // Acquire keeps the sample loads below from moving above this one
+            val sequence = LONGS.getAcquire(buffer, slot) as Long
+            if (sequence and 1L != 0L) {
+                continue
+            }
+
+            val n = window.count
+            window.index[n] = buffer.getLong(slot + 8)
+            window.timestampNanos[n] = buffer.getLong(slot + 16)
+            window.fps[n] = buffer.getFloat(slot + 24)
+            window.averageFrameTimeMs[n] = buffer.getFloat(slot + 28)
+            window.maxFrameTimeMs[n] = buffer.getFloat(slot + 32)
+            window.ppuLoad[n] = buffer.getFloat(slot + 36)
+            window.spuLoad[n] = buffer.getFloat(slot + 40)
+            window.rsxLoad[n] = buffer.getFloat(slot + 44)
+            window.otherLoad[n] = buffer.getFloat(slot + 48)
+            window.compileQueue[n] = buffer.getInt(slot + 52)
+            window.rssKb[n] = buffer.getLong(slot + 56)
+
+            // ...and this fence keeps them above the re-check
+            VarHandle.acquireFence()
+
+            if (buffer.getLong(slot) == sequence && window.index[n] == i) {
+                window.count++
+            }
+        }
+
+        return window.count
+    }
+
+    companion object {
+        const val MAGIC = 0x4D4C5452
+        const val VERSION = 1
+        const val HEADER_SIZE = 64
+        const val SAMPLE_SIZE = 64
+        const val CAPACITY = 256
+
+        private val LONGS =
+            MethodHandles.byteBufferViewVarHandle(LongArray::class.java, ByteOrder.LITTLE_ENDIAN)
+    }
+}
@@ -16,6 +16,7 @@ import androidx.compose.foundation.layout.wrapContentHeight
 import androidx.compose.foundation.lazy.grid.GridCells
 import androidx.compose.foundation.lazy.grid.LazyVerticalGrid
 import androidx.compose.material.icons.Icons
+import androidx.compose.material.icons.outlined.Build
 import androidx.compose.material.icons.outlined.Delete
 import androidx.compose.material3.Card
 import androidx.compose.material3.CircularProgressIndicator
@@ -41,11 +42,14 @@ import coil3.compose.AsyncImage
 import net.rpcs3.FirmwareRepository
 import net.rpcs3.Game
 import net.rpcs3.GameInfo
+import net.rpcs3.GameProgress
 import net.rpcs3.GameProgressType
 import net.rpcs3.GameRepository
 import net.rpcs3.ProgressRepository
+import net.rpcs3.RPCS3
 import net.rpcs3.RPCS3Activity
 import java.io.File
+import kotlin.concurrent.thread
 
 private fun withAlpha(color: Color, alpha: Float): Color {
     return Color(
@@ -80,6 +84,31 @@ fun GameItem(game: Game) {
                         // FIXME: delete cache
                     }
                 )
+
+                if (FirmwareRepository.version.value != null && FirmwareRepository.progressChannel.value == null &&
+                    game.findProgress(GameProgressType.Compile) == null
+                ) {
+                    DropdownMenuItem(
+                        text = { Text("Compile") },
+                        leadingIcon = { Icon(Icons.Outlined.Build, contentDescription = null) },
+                        onClick = {
+                            menuExpanded.value = false
+                            val progressId = ProgressRepository.create(context, "Compiling ${game.info.name.value ?: ""}")
+                            game.addProgress(GameProgress(progressId, GameProgressType.Compile))
+
+                            thread(isDaemon = true) {
+                                if (!RPCS3.instance.precompileGame(game.info.path, progressId)) {
+                                    try {
+                                        ProgressRepository.onProgressEvent(progressId, -1, 0)
+                                    } catch (e: Exception) {
+                                        e.printStackTrace()
+                                        ProgressRepository.cancel(progressId)
+                                    }
+                                }
+                            }
+                        }
+                    )
+                }
             }
         }
 
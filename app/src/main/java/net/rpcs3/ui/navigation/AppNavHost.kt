@@ -15,6 +15,8 @@ import androidx.compose.material.icons.Icons
 import androidx.compose.material.icons.filled.Add
 import androidx.compose.material.icons.filled.Menu
 import androidx.compose.material.icons.outlined.Build
+import androidx.compose.material.icons.outlined.PlayArrow
+import androidx.compose.material.icons.outlined.Settings
 import androidx.compose.material3.CenterAlignedTopAppBar
 import androidx.compose.material3.CircularProgressIndicator
 import androidx.compose.material3.DrawerValue
@@ -28,6 +30,7 @@ import androidx.compose.material3.ModalDrawerSheet
 import androidx.compose.material3.ModalNavigationDrawer
 import androidx.compose.material3.NavigationDrawerItem
 import androidx.compose.material3.Scaffold
+import androidx.compose.material3.Switch
 import androidx.compose.material3.Text
 import androidx.compose.material3.TopAppBarDefaults
 import androidx.compose.material3.rememberDrawerState
@@ -41,6 +44,7 @@ import androidx.compose.ui.unit.dp
 import kotlinx.coroutines.launch
 import net.rpcs3.FirmwareRepository
 import net.rpcs3.GameRepository
+import net.rpcs3.InputSettings
 import net.rpcs3.ProgressRepository
 import net.rpcs3.RPCS3
 import net.rpcs3.ui.games.GamesScreen
@@ -56,36 +60,40 @@ fun AppNavHost() {
     val context = LocalContext.current
 
     val installPkgLauncher = rememberLauncherForActivityResult(
-        contract = ActivityResultContracts.GetContent(),
-        onResult = { uri: Uri? ->
-            if (uri != null) {
-                val descriptor = context.contentResolver.openAssetFileDescriptor(uri, "r")
-                val fd = descriptor?.parcelFileDescriptor?.fd
+        contract = ActivityResultContracts.GetMultipleContents(),
+        onResult = { uris: List<Uri> ->
+            val descriptors = uris.mapNotNull { uri ->
+                context.contentResolver.openAssetFileDescriptor(uri, "r")
+            }
+            val fds = descriptors.mapNotNull { descriptor -> descriptor.parcelFileDescriptor?.fd }
 
-                if (fd != null) {
-                    val installProgress =
-                        ProgressRepository.create(context, "Package Installation")
-                    GameRepository.createGameInstallEntry(installProgress)
+            if (fds.isNotEmpty() && fds.size == descriptors.size) {
+                val installProgress =
+                    ProgressRepository.create(context, "Package Installation")
+                GameRepository.createGameInstallEntry(installProgress)
 
-                    thread(isDaemon = true) {
-                        if (!RPCS3.instance.installPkgFile(fd, installProgress)) {
-                            try {
-                                ProgressRepository.onProgressEvent(installProgress, -1, 0)
-                            } catch (e: Exception) {
-                                e.printStackTrace()
-                                ProgressRepository.cancel(installProgress)
-                            }
+                thread(isDaemon = true) {
+                    if (!RPCS3.instance.installPkgFiles(fds.toIntArray(), installProgress)) {
+                        try {
+                            ProgressRepository.onProgressEvent(installProgress, -1, 0)
+                        } catch (e: Exception) {
+                            e.printStackTrace()
+                            ProgressRepository.cancel(installProgress)
                         }
+                    }
 
+                    descriptors.forEach { descriptor ->
                         try {
                             descriptor.close()
                         } catch (e: Exception) {
                             e.printStackTrace()
                         }
                     }
-                } else {
+                }
+            } else {
+                descriptors.forEach { descriptor ->
                     try {
-                        descriptor?.close()
+                        descriptor.close()
                     } catch (e: Exception) {
                         e.printStackTrace()
                     }
@@ -94,6 +102,48 @@ fun AppNavHost() {
         }
     )
 
+    val mountPkgLauncher = rememberLauncherForActivityResult(
+        contract = ActivityResultContracts.GetContent(),
+        onResult = { uri: Uri? ->
+            val descriptor = uri?.let { context.contentResolver.openAssetFileDescriptor(it, "r") }
+            val fd = descriptor?.parcelFileDescriptor?.fd
+
+            if (fd != null) {
+                val mountProgress = ProgressRepository.create(context, "Package Mount")
+                GameRepository.createGameInstallEntry(mountProgress)
+
+                thread(isDaemon = true) {
+                    // The mount keeps its own descriptor
+                    val root = RPCS3.instance.mountPkg(fd)
+
+                    try {
+                        descriptor.close()
+                    } catch (e: Exception) {
+                        e.printStackTrace()
+                    }
+
+                    if (root != null) {
+                        GameRepository.addMountedRoot(root)
+                        RPCS3.instance.collectGameInfo(root, mountProgress)
+                    } else {
+                        try {
+                            ProgressRepository.onProgressEvent(mountProgress, -1, 0)
+                        } catch (e: Exception) {
+                            e.printStackTrace()
+                            ProgressRepository.cancel(mountProgress)
+                        }
+                    }
+                }
+            } else {
+                try {
+                    descriptor?.close()
+                } catch (e: Exception) {
+                    e.printStackTrace()
+                }
+            }
+        }
+    )
+
     val installFwLauncher = rememberLauncherForActivityResult(
         contract = ActivityResultContracts.GetContent(),
         onResult = { uri: Uri? ->
@@ -106,14 +156,14 @@ fun AppNavHost() {
                         ProgressRepository.create(context, "Firmware Installation") { entry ->
                             if (entry.isFinished()) {
                                 descriptor.close()
-                                FirmwareRepository.progressChannel.value = null
                             }
                         }
 
                     FirmwareRepository.progressChannel.value = installProgress
 
                     thread(isDaemon = true) {
-                        if (!RPCS3.instance.installFw(fd, installProgress)) {
+                        val installed = RPCS3.instance.installFw(fd, installProgress)
+                        if (!installed) {
                             try {
                                 ProgressRepository.onProgressEvent(installProgress, -1, 0)
                             } catch (e: Exception) {
@@ -126,6 +176,23 @@ fun AppNavHost() {
                         } catch (e: Exception) {
                             e.printStackTrace()
                         }
+
+                        if (installed) {
+                            // Build the firmware PPU cache now instead of on the first boot
+                            val compileProgress =
+                                ProgressRepository.create(context, "Firmware Compilation")
+                            FirmwareRepository.progressChannel.value = compileProgress
+
+                            if (!RPCS3.instance.compileFirmware(compileProgress)) {
+                                try {
+                                    ProgressRepository.onProgressEvent(compileProgress, -1, 0)
+                                } catch (e: Exception) {
+                                    e.printStackTrace()
+                                }
+                            }
+                        }
+
+                        FirmwareRepository.progressChannel.value = null
                     }
                 } else {
                     try {
@@ -195,6 +262,26 @@ fun AppNavHost() {
                                 }
                             }
                         )
+                        NavigationDrawerItem(
+                            label = { Text("Play PKG without installing") },
+                            selected = false,
+                            icon = { Icon(Icons.Outlined.PlayArrow, contentDescription = null) },
+                            onClick = { mountPkgLauncher.launch("*/*") }
+                        )
+                        NavigationDrawerItem(
+                            label = { Text("Event-driven input") },
+                            selected = false,
+                            icon = { Icon(Icons.Outlined.Settings, contentDescription = null) },
+                            badge = {
+                                Switch(
+                                    checked = InputSettings.eventDriven.value,
+                                    onCheckedChange = { InputSettings.setEventDriven(it) }
+                                )
+                            },
+                            onClick = {
+                                InputSettings.setEventDriven(!InputSettings.eventDriven.value)
+                            }
+                        )
                         HorizontalDivider(modifier = Modifier.padding(vertical = 8.dp))
                     }
                 }
@@ -0,0 +1,92 @@
+package net.rpcs3
+
+import org.junit.Assert.assertEquals
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+class TelemetryReaderTest {
+    private fun ring(): ByteBuffer {
+        val size = TelemetryReader.HEADER_SIZE + TelemetryReader.SAMPLE_SIZE * TelemetryReader.CAPACITY
+        val buffer = ByteBuffer.allocateDirect(size).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.putInt(0, TelemetryReader.MAGIC)
+        buffer.putInt(4, TelemetryReader.VERSION)
+        buffer.putInt(8, TelemetryReader.HEADER_SIZE)
+        buffer.putInt(12, TelemetryReader.SAMPLE_SIZE)
+        buffer.putInt(16, TelemetryReader.CAPACITY)
+        buffer.putInt(20, 250)
+        return buffer
+    }
+
+    private fun publish(buffer: ByteBuffer, index: Long) {
+        val slot = TelemetryReader.HEADER_SIZE +
+                (index % TelemetryReader.CAPACITY).toInt() * TelemetryReader.SAMPLE_SIZE
+        buffer.putLong(slot, buffer.getLong(slot) + 2)
+        buffer.putLong(slot + 8, index)
+        buffer.putLong(slot + 16, index * 250_000_000)
+        buffer.putFloat(slot + 24, index.toFloat())
+        buffer.putInt(slot + 52, index.toInt() * 2)
+        buffer.putLong(slot + 56, 1024 + index)
+        buffer.putLong(24, index + 1)
+    }
+
+    @Test
+    fun readsNewestSamplesOldestFirst() {
+        val buffer = ring()
+        for (i in 0L until 10L) {
+            publish(buffer, i)
+        }
+
+        val reader = TelemetryReader(buffer)
+        val window = TelemetryWindow(4)
+
+        assertEquals(250, reader.periodMs)
+        assertEquals(4, reader.read(window))
+        assertEquals(6L, window.index[0])
+        assertEquals(9L, window.index[3])
+        assertEquals(9f, window.fps[3])
+        assertEquals(18, window.compileQueue[3])
+        assertEquals(1033L, window.rssKb[3])
+    }
+
+    @Test
+    fun handlesWraparound() {
+        val buffer = ring()
+        val published = TelemetryReader.CAPACITY * 2L + 7
+        for (i in 0L until published) {
+            publish(buffer, i)
+        }
+
+        val window = TelemetryWindow()
+        val count = TelemetryReader(buffer).read(window)
+
+        assertEquals(TelemetryReader.CAPACITY - 1, count)
+        assertEquals(published - count, window.index[0])
+        assertEquals(published - 1, window.index[count - 1])
+        for (i in 1 until count) {
+            assertEquals(window.index[i - 1] + 1, window.index[i])
+        }
+    }
+
+    @Test
+    fun skipsSlotsBeingWritten() {
+        val buffer = ring()
+        for (i in 0L until 5L) {
+            publish(buffer, i)
+        }
+
+        val slot = TelemetryReader.HEADER_SIZE + 2 * TelemetryReader.SAMPLE_SIZE
+        buffer.putLong(slot, buffer.getLong(slot) + 1)
+
+        val window = TelemetryWindow()
+        assertEquals(4, TelemetryReader(buffer).read(window))
+        assertEquals(listOf(0L, 1L, 3L, 4L), window.index.take(window.count))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsUnknownVersion() {
+        val buffer = ring()
+        buffer.putInt(4, TelemetryReader.VERSION + 1)
+        TelemetryReader(buffer)
+    }
+}
@@ -0,0 +1,542 @@
+// Converts disc dumps and game folders to compressed disc images (.rdim),
+// which RPCS3 for Android finds in its game folders and boots in place.
+//
+// Usage:
+//   rpcs3-disc-image pack [-b block KB] [-l level] [-j threads] folder image
+//   rpcs3-disc-image list image
+//   rpcs3-disc-image verify image folder
+//   rpcs3-disc-image bench [-n reads] [-s read KB] [-c cache MB] image folder
+//
+// pack stores the folder contents, so a disc dump is packed from the folder
+// holding PS3_DISC.SFB and PS3_GAME. bench reads the same random ranges
+// from the image and from the folder and compares throughput.
+
+#include "disc_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+struct SourceFile {
+  std::string name;
+  std::filesystem::path path;
+  std::uint64_t size = 0;
+  bool directory = false;
+};
+
+// Files in a stable order, so packing the same folder twice gives the same
+// image. Names use '/' whatever the host uses
+std::vector<SourceFile> listFolder(const std::filesystem::path &folder) {
+  std::vector<SourceFile> files;
+
+  for (auto &entry : std::filesystem::recursive_directory_iterator(folder)) {
+    SourceFile file;
+    file.name = entry.path().lexically_relative(folder).generic_string();
+    file.path = entry.path();
+    file.directory = entry.is_directory();
+
+    if (!file.directory) {
+      if (!entry.is_regular_file()) {
+        continue;
+      }
+
+      file.size = entry.file_size();
+    }
+
+    files.push_back(std::move(file));
+  }
+
+  std::sort(files.begin(), files.end(),
+            [](auto &a, auto &b) { return a.name < b.name; });
+  return files;
+}
+
+// Concatenation of all files, read in blocks
+class DataStream {
+public:
+  explicit DataStream(const std::vector<SourceFile> &files) : files(files) {}
+
+  // Fills buffer, returns false if a file could not be read in full
+  bool read(std::uint8_t *buffer, std::uint64_t size) {
+    while (size != 0) {
+      if (!stream.is_open() || remaining == 0) {
+        if (!openNext()) {
+          return false;
+        }
+
+        continue;
+      }
+
+      const std::uint64_t count = std::min(size, remaining);
+      if (!stream.read(reinterpret_cast<char *>(buffer), count)) {
+        std::fprintf(stderr, "%s: read failed\n",
+                     files[current].path.string().c_str());
+        return false;
+      }
+
+      buffer += count;
+      size -= count;
+      remaining -= count;
+    }
+
+    return true;
+  }
+
+private:
+  bool openNext() {
+    stream.close();
+
+    while (++current < files.size()) {
+      const auto &file = files[current];
+      if (file.directory || file.size == 0) {
+        continue;
+      }
+
+      stream.open(file.path, std::ios::binary);
+      if (!stream) {
+        std::fprintf(stderr, "%s: cannot open file\n",
+                     file.path.string().c_str());
+        return false;
+      }
+
+      remaining = file.size;
+      return true;
+    }
+
+    return false;
+  }
+
+  const std::vector<SourceFile> &files;
+  std::ifstream stream;
+  std::size_t current = static_cast<std::size_t>(-1);
+  std::uint64_t remaining = 0;
+};
+
+bool writeAll(std::FILE *file, const void *data, std::size_t size) {
+  return std::fwrite(data, 1, size, file) == size;
+}
+
+int pack(const std::filesystem::path &folder, const char *imagePath,
+         std::uint32_t blockSize, int level, unsigned threads) {
+  const auto started = std::chrono::steady_clock::now();
+  std::vector<SourceFile> files;
+
+  try {
+    files = listFolder(folder);
+  } catch (const std::filesystem::filesystem_error &error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+
+  discimg::Header header{};
+  header.magic = discimg::kMagic;
+  header.version = discimg::kVersion;
+  header.blockSize = blockSize;
+  header.fileCount = static_cast<std::uint32_t>(files.size());
+
+  std::string table;
+
+  for (auto &file : files) {
+    discimg::FileRecord record{};
+    record.offset = header.dataSize;
+    record.size = file.size;
+    record.flags = file.directory ? discimg::kFlagDirectory : 0;
+    record.nameSize = static_cast<std::uint32_t>(file.name.size());
+    header.dataSize += file.size;
+
+    table.append(reinterpret_cast<const char *>(&record), sizeof(record));
+    table += file.name;
+  }
+
+  header.blockCount = discimg::blockCountFor(header.dataSize, blockSize);
+
+  std::FILE *image = std::fopen(imagePath, "wb");
+  if (image == nullptr) {
+    std::fprintf(stderr, "%s: cannot create file\n", imagePath);
+    return 1;
+  }
+
+  // The header is rewritten once the offsets are known
+  bool success = writeAll(image, &header, sizeof(header));
+
+  std::vector<std::uint64_t> index;
+  index.reserve(header.blockCount + 1);
+  index.push_back(sizeof(header));
+
+  // Blocks are compressed in batches on all threads and written in order
+  const std::uint64_t batchSize = threads * 4;
+  const uLong bound = compressBound(blockSize);
+  std::vector<std::vector<std::uint8_t>> raw(batchSize);
+  std::vector<std::vector<std::uint8_t>> packed(batchSize);
+  std::vector<uLongf> packedSizes(batchSize);
+  DataStream stream(files);
+
+  for (std::uint64_t first = 0; success && first < header.blockCount;
+       first += batchSize) {
+    const std::uint64_t count =
+        std::min(batchSize, header.blockCount - first);
+
+    for (std::uint64_t i = 0; i < count && success; i++) {
+      const std::uint64_t start = (first + i) * blockSize;
+      raw[i].resize(std::min<std::uint64_t>(blockSize,
+                                            header.dataSize - start));
+      success = stream.read(raw[i].data(), raw[i].size());
+    }
+
+    if (!success) {
+      break;
+    }
+
+    std::vector<std::thread> workers;
+
+    for (unsigned worker = 0; worker < threads; worker++) {
+      workers.emplace_back([&, worker] {
+        for (std::uint64_t i = worker; i < count; i += threads) {
+          packed[i].resize(bound);
+          packedSizes[i] = bound;
+
+          if (compress2(packed[i].data(), &packedSizes[i], raw[i].data(),
+                        raw[i].size(), level) != Z_OK) {
+            packedSizes[i] = raw[i].size();
+          }
+        }
+      });
+    }
+
+    for (auto &worker : workers) {
+      worker.join();
+    }
+
+    for (std::uint64_t i = 0; i < count && success; i++) {
+      // Blocks which do not shrink are stored as they are, the reader tells
+      // them apart by their size
+      if (packedSizes[i] < raw[i].size()) {
+        success = writeAll(image, packed[i].data(), packedSizes[i]);
+        index.push_back(index.back() + packedSizes[i]);
+      } else {
+        success = writeAll(image, raw[i].data(), raw[i].size());
+        index.push_back(index.back() + raw[i].size());
+      }
+    }
+
+    const std::uint64_t percent = (first + count) * 100 / header.blockCount;
+    if (percent != first * 100 / header.blockCount) {
+      std::fprintf(stderr, "\r%" PRIu64 "%%", percent);
+    }
+  }
+
+  if (success) {
+    std::fprintf(stderr, "\n");
+
+    const std::uint64_t padding = (8 - index.back() % 8) % 8;
+    const std::uint8_t zeros[8]{};
+    header.indexOffset = index.back() + padding;
+    header.tableOffset = header.indexOffset + index.size() * 8;
+    header.tableSize = table.size();
+
+    success = writeAll(image, zeros, padding) &&
+              writeAll(image, index.data(), index.size() * 8) &&
+              writeAll(image, table.data(), table.size()) &&
+              std::fseek(image, 0, SEEK_SET) == 0 &&
+              writeAll(image, &header, sizeof(header));
+  }
+
+  success &= std::fclose(image) == 0;
+
+  if (!success) {
+    std::fprintf(stderr, "%s: failed to write image\n", imagePath);
+    std::remove(imagePath);
+    return 1;
+  }
+
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - started)
+                             .count();
+  const std::uint64_t imageSize = std::filesystem::file_size(imagePath);
+
+  std::printf("%zu entries, %" PRIu64 " bytes -> %" PRIu64
+              " bytes (%.1f%%) in %.1f s\n",
+              files.size(), header.dataSize, imageSize,
+              header.dataSize != 0 ? imageSize * 100.0 / header.dataSize : 0.0,
+              seconds);
+  return 0;
+}
+
+std::shared_ptr<DiscImage> openImage(const char *path,
+                                     std::size_t cacheBytes =
+                                         DiscImage::kDefaultCacheBytes) {
+  std::string error;
+  auto image = DiscImage::open(path, cacheBytes, &error);
+
+  if (!image) {
+    std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+  }
+
+  return image;
+}
+
+int list(const char *imagePath) {
+  const auto image = openImage(imagePath);
+  if (!image) {
+    return 1;
+  }
+
+  for (auto &file : image->files()) {
+    if (file.directory) {
+      std::printf("%12s  %s/\n", "", file.name.c_str());
+    } else {
+      std::printf("%12" PRIu64 "  %s\n", file.size, file.name.c_str());
+    }
+  }
+
+  return 0;
+}
+
+int verify(const char *imagePath, const std::filesystem::path &folder) {
+  const auto image = openImage(imagePath);
+  if (!image) {
+    return 1;
+  }
+
+  std::vector<std::uint8_t> expected(1024 * 1024);
+  std::vector<std::uint8_t> actual(expected.size());
+  std::size_t mismatches = 0;
+
+  for (auto &file : image->files()) {
+    if (file.directory) {
+      continue;
+    }
+
+    std::ifstream stream(folder / file.name, std::ios::binary);
+    bool same = static_cast<bool>(stream) &&
+                std::filesystem::file_size(folder / file.name) == file.size;
+
+    for (std::uint64_t offset = 0; same && offset < file.size;
+         offset += expected.size()) {
+      const std::uint64_t count =
+          std::min<std::uint64_t>(expected.size(), file.size - offset);
+
+      same = stream.read(reinterpret_cast<char *>(expected.data()), count) &&
+             image->read(file, offset, actual.data(), count) == count &&
+             std::memcmp(expected.data(), actual.data(), count) == 0;
+    }
+
+    if (!same) {
+      std::printf("mismatch: %s\n", file.name.c_str());
+      mismatches++;
+    }
+  }
+
+  std::printf("%zu files differ\n", mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
+
+int bench(const char *imagePath, const std::filesystem::path &folder,
+          std::uint64_t reads, std::uint64_t readSize,
+          std::size_t cacheBytes) {
+  const auto image = openImage(imagePath, cacheBytes);
+  if (!image) {
+    return 1;
+  }
+
+  // Files are picked by size, like a title streaming its data
+  std::vector<const DiscImage::File *> candidates;
+  std::vector<double> weights;
+
+  for (auto &file : image->files()) {
+    if (!file.directory && file.size != 0) {
+      candidates.push_back(&file);
+      weights.push_back(static_cast<double>(file.size));
+    }
+  }
+
+  if (candidates.empty()) {
+    std::fprintf(stderr, "%s: no files to read\n", imagePath);
+    return 1;
+  }
+
+  struct Read {
+    const DiscImage::File *file;
+    std::uint64_t offset;
+  };
+
+  std::mt19937_64 random(1);
+  std::discrete_distribution<std::size_t> pick(weights.begin(),
+                                               weights.end());
+  std::vector<Read> plan(reads);
+
+  for (auto &read : plan) {
+    read.file = candidates[pick(random)];
+    read.offset = read.file->size > readSize
+                      ? random() % (read.file->size - readSize + 1)
+                      : 0;
+  }
+
+  std::vector<std::uint8_t> buffer(readSize);
+
+  auto run = [&](auto &&readAt) {
+    const auto start = std::chrono::steady_clock::now();
+    std::uint64_t bytes = 0;
+
+    for (auto &read : plan) {
+      bytes += readAt(read);
+    }
+
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    return std::pair{bytes, seconds};
+  };
+
+  std::vector<std::FILE *> handles(image->files().size(), nullptr);
+
+  const auto [folderBytes, folderSeconds] = run([&](const Read &read) {
+    auto &handle = handles[read.file - image->files().data()];
+    if (handle == nullptr) {
+      handle = std::fopen((folder / read.file->name).string().c_str(), "rb");
+    }
+
+    if (handle == nullptr ||
+        std::fseek(handle, static_cast<long>(read.offset), SEEK_SET) != 0) {
+      return std::uint64_t{0};
+    }
+
+    return static_cast<std::uint64_t>(
+        std::fread(buffer.data(), 1, readSize, handle));
+  });
+
+  for (auto *handle : handles) {
+    if (handle != nullptr) {
+      std::fclose(handle);
+    }
+  }
+
+  const auto [imageBytes, imageSeconds] = run([&](const Read &read) {
+    return image->read(*read.file, read.offset, buffer.data(), readSize);
+  });
+
+  const auto stats = image->stats();
+  const std::uint64_t lookups = stats.cacheHits + stats.cacheMisses;
+
+  std::printf("%" PRIu64 " random reads of %" PRIu64 " KB, %zu MB cache\n",
+              reads, readSize / 1024, cacheBytes / (1024 * 1024));
+  std::printf("folder: %8.1f MB/s %8.2f us/read\n",
+              folderBytes / folderSeconds / 1e6, folderSeconds * 1e6 / reads);
+  std::printf("image:  %8.1f MB/s %8.2f us/read\n",
+              imageBytes / imageSeconds / 1e6, imageSeconds * 1e6 / reads);
+  std::printf("cache hit rate %.1f%% (%" PRIu64 " hits, %" PRIu64
+              " misses), %.1f MB read from the image, %.1f ms inflating\n",
+              lookups != 0 ? stats.cacheHits * 100.0 / lookups : 0.0,
+              stats.cacheHits, stats.cacheMisses, stats.compressedBytes / 1e6,
+              stats.inflateNs / 1e6);
+
+  return folderBytes == imageBytes ? 0 : 1;
+}
+
+// Parses "-x value" options in front of the positional arguments
+bool parseOptions(int argc, char **argv, int &next, const char *names,
+                  std::uint64_t *values) {
+  while (next + 1 < argc && argv[next][0] == '-' && argv[next][2] == '\0') {
+    const char *option = std::strchr(names, argv[next][1]);
+    if (option == nullptr) {
+      return false;
+    }
+
+    char *end;
+    values[option - names] = std::strtoull(argv[next + 1], &end, 10);
+
+    if (*end != '\0') {
+      return false;
+    }
+
+    next += 2;
+  }
+
+  return true;
+}
+
+int usage(const char *program) {
+  std::fprintf(stderr,
+               "Usage:\n"
+               "  %s pack [-b block KB] [-l level] [-j threads] folder "
+               "image\n"
+               "  %s list image\n"
+               "  %s verify image folder\n"
+               "  %s bench [-n reads] [-s read KB] [-c cache MB] image "
+               "folder\n",
+               program, program, program, program);
+  return 1;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    return usage(argv[0]);
+  }
+
+  const std::string command = argv[1];
+  int next = 2;
+
+  if (command == "pack") {
+    std::uint64_t values[] = {discimg::kDefaultBlockSize / 1024,
+                              6,
+                              std::max(std::thread::hardware_concurrency(),
+                                       1u)};
+
+    if (!parseOptions(argc, argv, next, "blj", values) || argc - next != 2) {
+      return usage(argv[0]);
+    }
+
+    const std::uint64_t blockSize = values[0] * 1024;
+    if (blockSize < discimg::kMinBlockSize ||
+        blockSize > discimg::kMaxBlockSize) {
+      std::fprintf(stderr, "block size must be between %u and %u KB\n",
+                   discimg::kMinBlockSize / 1024,
+                   discimg::kMaxBlockSize / 1024);
+      return 1;
+    }
+
+    if (values[1] > 9) {
+      std::fprintf(stderr, "compression level must be between 0 and 9\n");
+      return 1;
+    }
+
+    return pack(argv[next], argv[next + 1],
+                static_cast<std::uint32_t>(blockSize),
+                static_cast<int>(values[1]),
+                static_cast<unsigned>(std::max<std::uint64_t>(values[2], 1)));
+  }
+
+  if (command == "list" && argc == 3) {
+    return list(argv[2]);
+  }
+
+  if (command == "verify" && argc == 4) {
+    return verify(argv[2], argv[3]);
+  }
+
+  if (command == "bench") {
+    std::uint64_t values[] = {20000, 4, 32};
+
+    if (!parseOptions(argc, argv, next, "nsc", values) || argc - next != 2 ||
+        values[0] == 0 || values[1] == 0) {
+      return usage(argv[0]);
+    }
+
+    return bench(argv[next], argv[next + 1], values[0], values[1] * 1024,
+                 values[2] * 1024 * 1024);
+  }
+
+  return usage(argv[0]);
+}
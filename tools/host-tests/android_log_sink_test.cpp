@@ -0,0 +1,84 @@
+#include "android_log_sink.h"
+#include "test.h"
+
+#include <android/log.h>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+std::mutex g_logd_mutex;
+std::vector<std::string> g_logd;
+
+// Waits for the drain thread to write count entries
+std::vector<std::string> waitForEntries(usz count) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+  while (std::chrono::steady_clock::now() < deadline) {
+    {
+      std::lock_guard lock(g_logd_mutex);
+      if (g_logd.size() >= count) {
+        return g_logd;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  std::lock_guard lock(g_logd_mutex);
+  return g_logd;
+}
+
+void testLongMessages() {
+  // Never destroyed, like in native-lib: the drain thread is detached
+  auto &sink = *new AndroidLogSink();
+  const logs::message msg{logs::level::warning};
+
+  const std::string fits(AndroidLogSink::kMaxTextSize, 'a');
+  const std::string tooLong(AndroidLogSink::kMaxTextSize + 100, 'b');
+
+  sink.log(0, msg, {}, fits);
+  sink.log(0, msg, {}, tooLong);
+
+  const auto entries = waitForEntries(2);
+  CHECK(entries.size() >= 2);
+
+  if (entries.size() >= 2) {
+    CHECK(entries[0] == fits);
+    CHECK(entries[1] == tooLong.substr(0, AndroidLogSink::kMaxTextSize));
+  }
+
+  CHECK(sink.truncated() == 1);
+  CHECK(sink.dropped() == 0);
+
+  // The drain thread reports the truncation after the message
+  const auto reported = waitForEntries(3);
+  CHECK(reported.size() == 3 &&
+        reported[2].starts_with("Log sink: 1 messages truncated"));
+}
+} // namespace
+
+extern "C" int __android_log_write(int, const char *, const char *text) {
+  std::lock_guard lock(g_logd_mutex);
+  g_logd.emplace_back(text);
+  return 1;
+}
+
+extern "C" int __android_log_print(int, const char *, const char *fmt, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, fmt);
+  std::vsnprintf(text, sizeof(text), fmt, args);
+  va_end(args);
+  return __android_log_write(ANDROID_LOG_WARN, "RPCS3", text);
+}
+
+int main() {
+  testLongMessages();
+  return testResult();
+}
@@ -0,0 +1,155 @@
+#include "benchmark.h"
+#include "test.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <ctime>
+#include <pthread.h>
+#include <thread>
+
+namespace {
+constexpr u64 kMs = 1'000'000;
+
+// Value of "name": in the report, the names used below are unique
+f64 jsonNumber(const std::string &json, const std::string &name) {
+  const auto pos = json.find("\"" + name + "\": ");
+  if (pos == std::string::npos) {
+    return -1;
+  }
+
+  return std::strtod(json.c_str() + pos + name.size() + 4, nullptr);
+}
+
+f64 threadCpuSeconds() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Stands in for an emulator thread, named like rpcs3 names them. Stays
+// alive until exit is set
+void burnCpu(const char *name, f64 seconds, const std::atomic<bool> &exit,
+             std::atomic<int> &burnt) {
+  pthread_setname_np(pthread_self(), name);
+
+  volatile u64 sink = 0;
+  while (threadCpuSeconds() < seconds) {
+    for (int i = 0; i < 100000; i++) {
+      sink = sink + i;
+    }
+  }
+
+  burnt++;
+  burnt.notify_all();
+  exit.wait(false);
+}
+
+void waitFor(std::atomic<int> &counter, int value) {
+  for (int current = counter; current < value; current = counter) {
+    counter.wait(current);
+  }
+}
+
+// Frame limit, frame time percentiles and compile time on synthetic time
+void testFrames() {
+  BenchmarkRecorder recorder({.frames = 100});
+  const u64 start = 1'000 * kMs;
+  recorder.start(start);
+
+  // Two seconds of compiling before the first frame
+  for (u64 now = start; now <= start + 2'000 * kMs; now += 100 * kMs) {
+    recorder.sample(now, true);
+  }
+
+  u64 now = start + 2'000 * kMs;
+
+  // The first frame only starts the clock, 100 intervals follow: 90 of
+  // 10 ms and 10 of 40 ms
+  for (int i = 0; i <= 100; i++) {
+    CHECK(!recorder.done(now));
+    recorder.onFrame(now);
+    now += i % 10 == 9 ? 40 * kMs : 10 * kMs;
+  }
+
+  CHECK(recorder.done(now));
+  recorder.stop(now);
+
+  const auto json = recorder.toJson("Test \"Title\"\n", true);
+  CHECK(json.find("\"title\": \"Test \\\"Title\\\"\\n\"") != std::string::npos);
+  CHECK(json.find("\"completed\": true") != std::string::npos);
+  CHECK(json.find("\"frames\": 101") != std::string::npos);
+  CHECK(jsonNumber(json, "compile_time_s") == 2);
+  CHECK(jsonNumber(json, "time_to_first_frame_s") == 2);
+  CHECK(jsonNumber(json, "duration_s") == 1.3);
+  CHECK(jsonNumber(json, "avg") == 13);
+  CHECK(jsonNumber(json, "p50") == 10);
+  CHECK(jsonNumber(json, "p99") == 40);
+  CHECK(jsonNumber(json, "max") == 40);
+  CHECK(jsonNumber(json, "peak_rss_kb") > 0);
+}
+
+void testTimeLimit() {
+  BenchmarkRecorder recorder({.seconds = 2});
+  recorder.start(1'000 * kMs);
+
+  // Boot time does not count against the limit
+  CHECK(!recorder.done(10'000 * kMs));
+  recorder.onFrame(10'000 * kMs);
+  CHECK(!recorder.done(11'999 * kMs));
+  CHECK(recorder.done(12'000 * kMs));
+
+  // No frames, nothing to divide by
+  const auto json = recorder.toJson("", false);
+  CHECK(json.find("\"completed\": false") != std::string::npos);
+  CHECK(jsonNumber(json, "fps") == 0 && jsonNumber(json, "avg") == 0);
+}
+
+// CPU time is attributed by thread name, threads which exit before the end
+// of the run are still counted
+void testThreadTimes() {
+  BenchmarkRecorder recorder({.frames = 1});
+  recorder.start(1);
+
+  std::atomic<bool> exitFirst = false, exitRsx = false;
+  std::atomic<int> burnt = 0;
+
+  std::thread ppu(burnCpu, "PPU[0x1000000] ", 0.2, std::cref(exitFirst),
+                  std::ref(burnt));
+  std::thread spu(burnCpu, "SPU[0x2000000] ", 0.1, std::cref(exitFirst),
+                  std::ref(burnt));
+  waitFor(burnt, 2);
+
+  // Threads are sampled at most once a second
+  recorder.sample(2 * 1'000 * kMs, false);
+
+  exitFirst = true;
+  exitFirst.notify_all();
+  ppu.join();
+  spu.join();
+
+  // Exits between samples, its time is not seen. Runs sample every second,
+  // only short lived threads are missed
+  std::thread rsx(burnCpu, "rsx::thread", 0.1, std::cref(exitRsx),
+                  std::ref(burnt));
+  waitFor(burnt, 3);
+  exitRsx = true;
+  exitRsx.notify_all();
+  rsx.join();
+
+  recorder.sample(2 * 1'000 * kMs + 1, false);
+  recorder.stop(3 * 1'000 * kMs);
+
+  const auto json = recorder.toJson("", true);
+  CHECK(jsonNumber(json, "ppu") >= 0.15);
+  CHECK(jsonNumber(json, "spu") >= 0.05);
+  CHECK(jsonNumber(json, "rsx") == 0);
+}
+} // namespace
+
+int main() {
+  testFrames();
+  testTimeLimit();
+  testThreadTimes();
+  return testResult();
+}
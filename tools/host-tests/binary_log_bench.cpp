@@ -0,0 +1,135 @@
+// Compares the latency of a log call on hot emulator threads with the binary
+// log encoding records under one lock, as it did first, and with
+// BinaryLogListener, which only copies into a ring.
+// Usage: binary_log_bench [threads] [messages per burst]
+
+#include "binary_log.h"
+#include "binary_log_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+logs::channel g_spu{"SPU"};
+
+// The listener before the ring: a global lock, the channel lookup and the
+// encoding on the caller's thread
+class LockedBinaryLog final : public logs::listener {
+public:
+  void log(u64 stamp, const logs::message &msg, const std::string &prefix,
+           const std::string &text) override {
+    std::lock_guard lock(mutex);
+
+    auto [it, inserted] = channelIds.try_emplace(
+        msg->name, static_cast<u32>(channelIds.size() + 1));
+
+    if (inserted) {
+      pending += static_cast<char>(binlog::RecordType::channel);
+      binlog::putVarint(pending, it->second);
+      binlog::putString(pending, msg->name);
+    }
+
+    pending += static_cast<char>(binlog::RecordType::message);
+    binlog::putVarint(pending, stamp);
+    binlog::putVarint(pending, it->second);
+    pending += static_cast<char>(static_cast<logs::level>(msg));
+    binlog::putString(pending, prefix);
+    binlog::putString(pending, text);
+
+    // Stands in for the writer taking the buffer
+    if (pending.size() >= 64 * 1024) {
+      pending.clear();
+    }
+  }
+
+private:
+  std::mutex mutex;
+  std::unordered_map<const char *, u32> channelIds;
+  std::string pending;
+};
+
+struct Result {
+  double p50;
+  double p99;
+  double max;
+};
+
+// Every thread logs bursts of trace messages, as SPU threads do at trace
+// level, with a pause in between so the writer can catch up
+Result measure(logs::listener &listener, usz threadCount, usz burstSize) {
+  constexpr usz kBursts = 20;
+  std::vector<std::vector<double>> perThread(threadCount);
+  std::vector<std::thread> threads;
+
+  for (usz t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t] {
+      const std::string text = "SPU: Trace: MFC cmd GET, lsa=0x3f80, "
+                               "ea=0x30012340, size=0x80, tag=" +
+                               std::to_string(t);
+      auto &latencies = perThread[t];
+      latencies.reserve(kBursts * burstSize);
+
+      for (usz burst = 0; burst < kBursts; burst++) {
+        for (usz i = 0; i < burstSize; i++) {
+          const auto start = Clock::now();
+          listener.log(i, {logs::level::trace, &g_spu}, {}, text);
+          latencies.push_back(
+              std::chrono::duration<double, std::micro>(Clock::now() - start)
+                  .count());
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<double> latencies;
+  for (auto &values : perThread) {
+    latencies.insert(latencies.end(), values.begin(), values.end());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  return {latencies[latencies.size() / 2],
+          latencies[latencies.size() * 99 / 100], latencies.back()};
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const usz threadCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 6;
+  const usz burstSize = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+
+  char tmpl[] = "/tmp/binary_log_bench.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+
+  LockedBinaryLog locked;
+  auto &listener = *new BinaryLogListener();
+  listener.open((base / "logs").string() + "/", true);
+
+  const auto before = measure(locked, threadCount, burstSize);
+  const auto after = measure(listener, threadCount, burstSize);
+
+  std::printf("%zu threads, %zu messages per burst\n", threadCount,
+              burstSize);
+  std::printf("locked:            p50 %6.2f us  p99 %6.2f us  max %8.2f us\n",
+              before.p50, before.p99, before.max);
+  std::printf("BinaryLogListener: p50 %6.2f us  p99 %6.2f us  max %8.2f us, "
+              "%llu dropped\n",
+              after.p50, after.p99, after.max,
+              static_cast<unsigned long long>(listener.dropped()));
+
+  std::filesystem::remove_all(base);
+  return 0;
+}
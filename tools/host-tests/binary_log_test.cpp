@@ -0,0 +1,137 @@
+#include "binary_log.h"
+#include "binary_log_format.h"
+#include "test.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Decoded {
+  std::string channel;
+  logs::level level;
+  std::string text;
+};
+
+// Reads the messages of an uncompressed log
+std::vector<Decoded> decode(const std::string &path) {
+  std::ifstream stream(path, std::ios::binary);
+  const std::vector<u8> data{std::istreambuf_iterator<char>(stream),
+                             std::istreambuf_iterator<char>()};
+
+  binlog::FileHeader header{};
+  CHECK(data.size() >= sizeof(header));
+  if (data.size() < sizeof(header)) {
+    return {};
+  }
+
+  std::memcpy(&header, data.data(), sizeof(header));
+  CHECK(header.magic == binlog::kMagic && header.flags == 0);
+
+  binlog::RecordReader reader{data.data() + sizeof(header),
+                              data.size() - sizeof(header)};
+  std::map<u64, std::string> channels;
+  std::vector<Decoded> messages;
+  u8 type;
+
+  while (reader.getByte(type)) {
+    u64 id;
+    std::string_view name;
+
+    if (type == static_cast<u8>(binlog::RecordType::channel)) {
+      CHECK(reader.getVarint(id) && reader.getString(name));
+      channels[id] = name;
+      continue;
+    }
+
+    u64 stamp;
+    u8 level;
+    std::string_view prefix;
+    std::string_view text;
+    CHECK(reader.getVarint(stamp) && reader.getVarint(id) &&
+          reader.getByte(level) && reader.getString(prefix) &&
+          reader.getString(text));
+
+    // Every channel is defined before it is used
+    CHECK(id == 0 || channels.contains(id));
+    messages.push_back({channels[id], static_cast<logs::level>(level),
+                        std::string(text)});
+  }
+
+  return messages;
+}
+
+logs::channel g_ppu{"PPU"};
+logs::channel g_rsx{"RSX"};
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/binary_log_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+  const std::string dir = (base / "logs").string() + "/";
+
+  // Never destroyed, like the listener in native-lib
+  auto &listener = *new BinaryLogListener();
+
+  // Kept in memory until the directory is known
+  listener.log(1, {logs::level::notice, &g_ppu}, {}, "before open");
+  listener.open(dir, false);
+
+  // Hot threads on two channels, one long message
+  constexpr u32 kThreads = 4;
+  constexpr u32 kMessages = 1000;
+  std::vector<std::thread> threads;
+
+  for (u32 t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t] {
+      for (u32 i = 0; i < kMessages; i++) {
+        listener.log(2, {logs::level::trace, t % 2 ? &g_rsx : &g_ppu}, {},
+                     std::to_string(t) + ":" + std::to_string(i));
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const std::string longText(20000, 'x');
+  listener.log(3, {logs::level::error, &g_rsx}, {}, longText);
+  listener.log(4, {logs::level::fatal, &g_ppu}, {}, "fatal");
+
+  // The fatal message synced the file
+  const auto messages = decode(dir + "RPCS3.blog");
+  CHECK(!messages.empty() && messages.front().text == "before open");
+  CHECK(!messages.empty() && messages.back().text == "fatal" &&
+        messages.back().channel == "PPU");
+
+  // Each thread's messages arrive in order, none were lost unless counted
+  std::vector<u32> next(kThreads, 0);
+  usz received = 0;
+  bool longFound = false;
+
+  for (auto &message : messages) {
+    if (message.level == logs::level::trace) {
+      const u32 thread = std::stoul(message.text);
+      const u32 index = std::stoul(message.text.substr(2));
+      CHECK(message.channel == (thread % 2 ? "RSX" : "PPU"));
+      CHECK(index >= next[thread]);
+      next[thread] = index + 1;
+      received++;
+    }
+
+    longFound |= message.text == longText;
+  }
+
+  CHECK(longFound);
+  CHECK(received + listener.dropped() == kThreads * kMessages);
+  std::printf("%zu messages received, %llu dropped\n", received,
+              static_cast<unsigned long long>(listener.dropped()));
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
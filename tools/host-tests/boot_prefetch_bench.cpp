@@ -0,0 +1,147 @@
+// Measures the I/O wait of a synthetic boot with and without the prefetcher.
+// The boot reads its files in 1 MB chunks with some work in between, I/O
+// wait is the time it spent blocked in read. The files are evicted from the
+// page cache before every run, pass a root on the storage to measure.
+// Usage: boot_prefetch_bench [files] [MB per file] [root]
+
+#include "boot_prefetch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <future>
+#include <unistd.h>
+
+namespace {
+constexpr u64 kChunk = 1024 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+f64 seconds(Clock::duration duration) {
+  return std::chrono::duration<f64>(duration).count();
+}
+
+std::vector<std::string> makeFiles(const std::filesystem::path &root,
+                                   usz count, u64 size) {
+  std::filesystem::create_directories(root);
+  std::vector<std::string> files;
+  std::vector<char> chunk(kChunk, 'x');
+
+  for (usz i = 0; i < count; i++) {
+    files.push_back((root / ("file" + std::to_string(i) + ".sprx")).string());
+    const int fd = open(files.back().c_str(), O_WRONLY | O_CREAT | O_TRUNC |
+                                                  O_CLOEXEC,
+                        0644);
+
+    for (u64 done = 0; done < size; done += kChunk) {
+      [[maybe_unused]] auto r = write(fd, chunk.data(), chunk.size());
+    }
+
+    fsync(fd);
+    close(fd);
+  }
+
+  return files;
+}
+
+// Clean pages are dropped, which is why the files were synced
+void evict(const std::vector<std::string> &files) {
+  for (auto &file : files) {
+    const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+struct BootResult {
+  f64 ioWait = 0;
+  f64 total = 0;
+};
+
+BootResult boot(const std::vector<std::string> &files) {
+  BootResult result;
+  std::vector<char> buffer(kChunk);
+  const auto start = Clock::now();
+
+  for (auto &file : files) {
+    const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+    for (u64 offset = 0;; offset += kChunk) {
+      const auto before = Clock::now();
+      const auto r = pread(fd, buffer.data(), buffer.size(), offset);
+      result.ioWait += seconds(Clock::now() - before);
+
+      if (r <= 0) {
+        break;
+      }
+
+      // Parsing and relocating what was read
+      const auto until = Clock::now() + std::chrono::milliseconds(1);
+      while (Clock::now() < until) {
+      }
+    }
+
+    close(fd);
+  }
+
+  result.total = seconds(Clock::now() - start);
+  return result;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const usz count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+  const u64 size =
+      (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 32) * kChunk;
+
+  std::filesystem::path base;
+  if (argc > 3) {
+    base = argv[3];
+  } else {
+    char tmpl[] = "/tmp/boot_prefetch_bench.XXXXXX";
+    base = ::mkdtemp(tmpl);
+  }
+
+  const auto root = base / "title";
+  const auto files = makeFiles(root, count, size);
+
+  // First boot: cold, recorded
+  evict(files);
+  std::promise<BootTrace> recorded;
+  BootTraceRecorder recorder;
+  recorder.start({root.string()}, std::chrono::seconds(1),
+                 [&](BootTrace trace) {
+                   recorded.set_value(std::move(trace));
+                 });
+
+  const auto cold = boot(files);
+  const auto trace = recorded.get_future().get();
+
+  // Second boot: cold again, but prefetched
+  evict(files);
+  BootPrefetcher prefetcher;
+  prefetcher.start(trace, 4);
+  const auto prefetched = boot(files);
+  const auto stats = prefetcher.wait();
+
+  std::printf("%zu files, %llu MB, trace %zu ranges %llu MB\n", count,
+              static_cast<unsigned long long>(count * size >> 20),
+              trace.ranges.size(),
+              static_cast<unsigned long long>(trace.totalBytes() >> 20));
+  std::printf("cold:       I/O wait %.3f s, boot %.3f s\n", cold.ioWait,
+              cold.total);
+  std::printf("prefetched: I/O wait %.3f s, boot %.3f s (prefetch %llu MB in "
+              "%.3f s)\n",
+              prefetched.ioWait, prefetched.total,
+              static_cast<unsigned long long>(stats.bytes >> 20),
+              stats.seconds);
+
+  std::filesystem::remove_all(root);
+  if (argc <= 3) {
+    std::filesystem::remove_all(base);
+  }
+
+  return 0;
+}
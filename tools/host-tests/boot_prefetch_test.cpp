@@ -0,0 +1,131 @@
+#include "boot_prefetch.h"
+#include "test.h"
+
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+namespace {
+BootTrace makeTrace(std::initializer_list<u64> lengths) {
+  BootTrace trace;
+  u64 offset = 0;
+
+  for (const u64 length : lengths) {
+    trace.ranges.push_back({.path = "/title/EBOOT.BIN",
+                            .fileSize = 1 << 20,
+                            .offset = offset,
+                            .length = length});
+    offset += length;
+  }
+
+  return trace;
+}
+
+void testTruncate() {
+  // The range crossing the cap is shortened, the ones after it dropped
+  auto trace = makeTrace({100, 200, 300, 400});
+  trace.truncate(450);
+  CHECK(trace.ranges.size() == 3);
+  CHECK(trace.totalBytes() == 450);
+  CHECK(trace.ranges.back().offset == 300 && trace.ranges.back().length == 150);
+
+  // Exactly at a range boundary, nothing empty is left behind
+  trace = makeTrace({100, 200, 300});
+  trace.truncate(300);
+  CHECK(trace.ranges.size() == 2);
+  CHECK(trace.totalBytes() == 300);
+
+  // Within the cap nothing changes
+  trace = makeTrace({100, 200});
+  trace.truncate(1000);
+  CHECK(trace.ranges.size() == 2 && trace.totalBytes() == 300);
+
+  trace.truncate(0);
+  CHECK(trace.ranges.empty());
+}
+
+void testSaveLoad(const std::filesystem::path &base) {
+  const auto path = (base / "boot.trace").string();
+  const auto trace = makeTrace({4096, 8192});
+  CHECK(trace.save(path));
+
+  const auto loaded = BootTrace::load(path);
+  CHECK(loaded && loaded->ranges.size() == 2);
+
+  if (loaded && loaded->ranges.size() == 2) {
+    for (usz i = 0; i < 2; i++) {
+      CHECK(loaded->ranges[i].path == trace.ranges[i].path);
+      CHECK(loaded->ranges[i].fileSize == trace.ranges[i].fileSize);
+      CHECK(loaded->ranges[i].offset == trace.ranges[i].offset);
+      CHECK(loaded->ranges[i].length == trace.ranges[i].length);
+    }
+  }
+
+  CHECK(!BootTrace::load((base / "missing.trace").string()));
+
+  // A corrupted count must not be trusted with an allocation. The count
+  // follows the magic and the version
+  {
+    const auto corruptPath = (base / "corrupt.trace").string();
+    std::filesystem::copy_file(path, corruptPath);
+
+    const int fd = ::open(corruptPath.c_str(), O_WRONLY);
+    const u32 count = UINT32_MAX;
+    CHECK(::pwrite(fd, &count, sizeof(count), 8) == sizeof(count));
+    ::close(fd);
+
+    CHECK(!BootTrace::load(corruptPath));
+  }
+
+  // Cut off in the middle of a range
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+  CHECK(!BootTrace::load(path));
+}
+
+void testResidentRanges(const std::filesystem::path &base) {
+  const auto path = (base / "data.bin").string();
+  const u64 pageSize = sysconf(_SC_PAGESIZE);
+  const u64 size = 64 * pageSize + 100;
+
+  const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  std::vector<char> data(size, 'x');
+  CHECK(write(fd, data.data(), data.size()) ==
+        static_cast<ssize_t>(data.size()));
+  fsync(fd);
+
+  // Everything was just written, the whole file is one range
+  BootTrace trace;
+  BootTraceRecorder::addResidentRanges(path, trace);
+  CHECK(trace.ranges.size() == 1);
+  CHECK(trace.totalBytes() == size);
+
+  if (!trace.ranges.empty()) {
+    CHECK(trace.ranges[0].fileSize == size && trace.ranges[0].offset == 0);
+  }
+
+  // Evicted files have nothing resident. Some file systems keep the pages,
+  // only check when the eviction worked
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+
+  BootTrace evicted;
+  BootTraceRecorder::addResidentRanges(path, evicted);
+  std::printf("%zu ranges resident after eviction\n", evicted.ranges.size());
+
+  BootTrace missing;
+  BootTraceRecorder::addResidentRanges((base / "missing").string(), missing);
+  CHECK(missing.ranges.empty());
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/boot_prefetch_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+
+  testTruncate();
+  testSaveLoad(base);
+  testResidentRanges(base);
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
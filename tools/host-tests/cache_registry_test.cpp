@@ -0,0 +1,164 @@
+#include "cache_registry.h"
+#include "test.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+// Holds a number of bytes and records the order in which it was trimmed
+struct SyntheticCache {
+  std::string name;
+  u64 size;
+  std::vector<std::string> *trimOrder;
+  u64 lastRequest = 0;
+
+  u32 add(CacheRegistry &registry, u32 priority) {
+    return registry.add(
+        name, priority, [this] { return size; },
+        [this](u64 bytes) {
+          trimOrder->push_back(name);
+          lastRequest = bytes;
+          const u64 freed = std::min(bytes, size);
+          size -= freed;
+          return freed;
+        });
+  }
+};
+
+void testLevels() {
+  CHECK(!trimLevelFromAndroid(0));
+  CHECK(!trimLevelFromAndroid(4));
+  CHECK(trimLevelFromAndroid(5) == TrimLevel::runningModerate);
+  CHECK(trimLevelFromAndroid(10) == TrimLevel::runningLow);
+  CHECK(trimLevelFromAndroid(15) == TrimLevel::runningCritical);
+  CHECK(trimLevelFromAndroid(20) == TrimLevel::uiHidden);
+  CHECK(trimLevelFromAndroid(40) == TrimLevel::background);
+  CHECK(trimLevelFromAndroid(60) == TrimLevel::moderate);
+  CHECK(trimLevelFromAndroid(80) == TrimLevel::complete);
+
+  // Levels added by later Android versions map to the one below
+  CHECK(trimLevelFromAndroid(50) == TrimLevel::background);
+  CHECK(trimLevelFromAndroid(100) == TrimLevel::complete);
+}
+
+void testOrder() {
+  std::vector<std::string> order;
+  SyntheticCache jit{"jit", 400, &order};
+  SyntheticCache textures{"textures", 300, &order};
+  SyntheticCache frames{"frames", 200, &order};
+  SyntheticCache empty{"empty", 0, &order};
+  SyntheticCache shaders{"shaders", 100, &order};
+
+  // Registered out of order, equal priorities keep registration order
+  CacheRegistry registry;
+  jit.add(registry, 5);
+  textures.add(registry, 1);
+  frames.add(registry, 0);
+  empty.add(registry, 0);
+  shaders.add(registry, 1);
+
+  CHECK(registry.estimatedSize() == 1000);
+
+  // Everything is asked for, nothing left to trim in the empty cache
+  const auto report = registry.trim(TrimLevel::complete);
+  CHECK((order ==
+         std::vector<std::string>{"frames", "textures", "shaders", "jit"}));
+  CHECK(report.estimated == 1000);
+  CHECK(report.requested == 1000);
+  CHECK(report.reclaimed == 1000);
+  CHECK(report.cachesTrimmed == 4);
+  CHECK(registry.estimatedSize() == 0);
+}
+
+void testShares() {
+  std::vector<std::string> order;
+  SyntheticCache a{"a", 300, &order};
+  SyntheticCache b{"b", 300, &order};
+  SyntheticCache c{"c", 400, &order};
+
+  CacheRegistry registry;
+  a.add(registry, 0);
+  b.add(registry, 1);
+  c.add(registry, 2);
+
+  // A quarter of 1000: the first cache alone covers it, and is only asked
+  // for what is missing
+  auto report = registry.trim(TrimLevel::runningModerate);
+  CHECK(report.requested == 250);
+  CHECK(report.reclaimed == 250);
+  CHECK(report.cachesTrimmed == 1);
+  CHECK(a.lastRequest == 250 && a.size == 50);
+  CHECK((order == std::vector<std::string>{"a"}));
+
+  // Half of the 750 left. No cache is asked for more than it holds, the
+  // last one only for the rest
+  order.clear();
+  report = registry.trim(TrimLevel::background);
+  CHECK(report.estimated == 750);
+  CHECK(report.requested == 375);
+  CHECK(report.reclaimed == 375);
+  CHECK(report.cachesTrimmed == 3);
+  CHECK(a.lastRequest == 50 && b.lastRequest == 300 && c.lastRequest == 25);
+  CHECK(a.size == 0 && b.size == 0 && c.size == 375);
+  CHECK((order == std::vector<std::string>{"a", "b", "c"}));
+
+  // A cache which frees less than asked makes the next one pay
+  CacheRegistry partial;
+  const u32 id = partial.add(
+      "stubborn", 0, [] { return u64{500}; }, [](u64) { return u64{100}; });
+  SyntheticCache rest{"rest", 500, &order};
+  rest.add(partial, 1);
+
+  report = partial.trim(TrimLevel::moderate);
+  CHECK(report.requested == 750);
+  CHECK(report.reclaimed == 600);
+  CHECK(rest.lastRequest == 500 && rest.size == 0);
+
+  // Removed caches are not asked again
+  order.clear();
+  partial.remove(id);
+  CHECK(partial.estimatedSize() == 0);
+  report = partial.trim(TrimLevel::complete);
+  CHECK(report.reclaimed == 0 && report.cachesTrimmed == 0);
+  CHECK(order.empty());
+
+  // Totals per level
+  const auto reclaimed = registry.reclaimedPerLevel();
+  CHECK(reclaimed[static_cast<usz>(TrimLevel::runningModerate)] == 250);
+  CHECK(reclaimed[static_cast<usz>(TrimLevel::background)] == 375);
+  CHECK(reclaimed[static_cast<usz>(TrimLevel::complete)] == 0);
+
+  const auto partialReclaimed = partial.reclaimedPerLevel();
+  CHECK(partialReclaimed[static_cast<usz>(TrimLevel::moderate)] == 600);
+}
+
+void testAllShares() {
+  const std::pair<TrimLevel, u64> kShares[] = {
+      {TrimLevel::runningModerate, 250}, {TrimLevel::runningLow, 500},
+      {TrimLevel::runningCritical, 1000}, {TrimLevel::uiHidden, 250},
+      {TrimLevel::background, 500},      {TrimLevel::moderate, 750},
+      {TrimLevel::complete, 1000},
+  };
+
+  for (auto [level, requested] : kShares) {
+    std::vector<std::string> order;
+    SyntheticCache cache{"cache", 1000, &order};
+
+    CacheRegistry registry;
+    cache.add(registry, 0);
+
+    const auto report = registry.trim(level);
+    CHECK(report.requested == requested);
+    CHECK(report.reclaimed == requested && cache.size == 1000 - requested);
+  }
+}
+} // namespace
+
+int main() {
+  testLevels();
+  testOrder();
+  testShares();
+  testAllShares();
+  return testResult();
+}
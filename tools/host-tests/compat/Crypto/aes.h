@@ -0,0 +1,27 @@
+#pragma once
+
+// Stand-in for rpcs3's AES on top of OpenSSL, only the ECB encryption the
+// PKG keystreams use
+
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/aes.h>
+
+struct aes_context {
+  AES_KEY key;
+};
+
+inline int aes_setkey_enc(aes_context *ctx, const unsigned char *key,
+                          unsigned int keysize) {
+  return AES_set_encrypt_key(key, keysize, &ctx->key);
+}
+
+inline int aes_crypt_ecb(aes_context *ctx, int mode,
+                         const unsigned char input[16],
+                         unsigned char output[16]) {
+  if (mode != AES_ENCRYPT) {
+    return -1;
+  }
+
+  AES_encrypt(input, output, &ctx->key);
+  return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Stand-in for rpcs3's key vault. The keys are placeholders: host tests and
+// benchmarks build their own packages and encrypt them with these
+
+#include "util/types.hpp"
+
+inline constexpr u8 PKG_AES_KEY[0x10] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+};
+
+inline constexpr u8 PKG_AES_KEY2[0x10] = {
+    0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88,
+    0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00,
+};
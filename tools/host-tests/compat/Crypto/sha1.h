@@ -0,0 +1,13 @@
+#pragma once
+
+// Stand-in for rpcs3's SHA-1 on top of OpenSSL
+
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/sha.h>
+
+#include <cstddef>
+
+inline void sha1(const unsigned char *input, std::size_t ilen,
+                 unsigned char output[20]) {
+  SHA1(input, ilen, output);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Stand-in for the PKG layout of rpcs3's package_reader
+
+#include "util/types.hpp"
+
+enum : u16 {
+  PKG_RELEASE_TYPE_RELEASE = 0x8000,
+  PKG_RELEASE_TYPE_DEBUG = 0x0000,
+
+  PKG_PLATFORM_TYPE_PS3 = 0x0001,
+  PKG_PLATFORM_TYPE_PSP_PSVITA = 0x0002,
+};
+
+enum : u32 {
+  PKG_FILE_ENTRY_NPDRM = 1,
+  PKG_FILE_ENTRY_NPDRMEDAT = 2,
+  PKG_FILE_ENTRY_REGULAR = 3,
+  PKG_FILE_ENTRY_FOLDER = 4,
+
+  PKG_FILE_ENTRY_PSP = 0x10000000,
+};
+
+struct PKGHeader {
+  be_t<u32> pkg_magic;
+  be_t<u16> pkg_type;
+  be_t<u16> pkg_platform;
+  be_t<u32> meta_offset;
+  be_t<u32> meta_count;
+  be_t<u32> meta_size;
+  be_t<u32> file_count;
+  be_t<u64> pkg_size;
+  be_t<u64> data_offset;
+  be_t<u64> data_size;
+  char title_id[48];
+  u8 qa_digest[16];
+  u8 klicensee[16];
+};
+
+static_assert(sizeof(PKGHeader) == 0x80);
+
+struct PKGEntry {
+  be_t<u32> name_offset;
+  be_t<u32> name_size;
+  be_t<u64> file_offset;
+  be_t<u64> file_size;
+  be_t<u32> type;
+  be_t<u32> pad;
+};
+
+static_assert(sizeof(PKGEntry) == 0x20);
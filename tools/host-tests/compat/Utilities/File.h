@@ -0,0 +1,341 @@
+#pragma once
+
+// Stand-in for the part of rpcs3's fs the frontend uses: files behind a
+// file_base, reading a whole file and replacing one atomically, and the
+// virtual devices archives are mounted as
+
+#include "util/types.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs {
+enum class open_mode : u32 { read, write, append, create, trunc, excl };
+
+constexpr auto read = open_mode::read;
+constexpr auto write = open_mode::write;
+constexpr auto append = open_mode::append;
+constexpr auto create = open_mode::create;
+constexpr auto trunc = open_mode::trunc;
+constexpr auto excl = open_mode::excl;
+} // namespace fs
+
+// Set of flags of an enum, like rpcs3's bs_t
+template <typename T> class bs_t {
+public:
+  constexpr bs_t() = default;
+  constexpr bs_t(T flag) : bits(1u << static_cast<u32>(flag)) {}
+
+  constexpr bs_t operator+(bs_t other) const {
+    return fromBits(bits | other.bits);
+  }
+  constexpr bool operator&(T flag) const {
+    return bits & (1u << static_cast<u32>(flag));
+  }
+
+private:
+  static constexpr bs_t fromBits(u32 bits) {
+    bs_t result;
+    result.bits = bits;
+    return result;
+  }
+
+  u32 bits = 0;
+};
+
+namespace fs {
+constexpr bs_t<open_mode> operator+(open_mode a, open_mode b) {
+  return bs_t<open_mode>(a) + bs_t<open_mode>(b);
+}
+
+constexpr bs_t<open_mode> rewrite = write + create + trunc;
+
+enum class seek_mode : u32 { seek_set, seek_cur, seek_end };
+using enum seek_mode;
+
+enum class error : u32 { ok, inval, noent, exist, acces, readonly, isdir };
+inline thread_local error g_tls_error = error::ok;
+
+using native_handle = int;
+
+struct stat_t {
+  bool is_directory;
+  bool is_symlink;
+  bool is_writable;
+  u64 size;
+  s64 atime;
+  s64 mtime;
+  s64 ctime;
+};
+
+struct dir_entry : stat_t {
+  std::string name;
+};
+
+struct device_stat {
+  u64 block_size;
+  u64 total_size;
+  u64 total_free;
+  u64 avail_free;
+};
+
+struct file_base {
+  virtual ~file_base() = default;
+
+  virtual stat_t get_stat() = 0;
+  virtual bool trunc(u64 length) = 0;
+  virtual u64 read(void *buffer, u64 size) = 0;
+  virtual u64 read_at(u64 offset, void *buffer, u64 size) = 0;
+  virtual u64 write(const void *buffer, u64 size) = 0;
+  virtual u64 seek(s64 offset, seek_mode whence) = 0;
+  virtual u64 size() = 0;
+  virtual void sync() {}
+};
+
+struct dir_base {
+  virtual ~dir_base() = default;
+
+  virtual bool read(dir_entry &entry) = 0;
+  virtual void rewind() = 0;
+};
+
+// Devices own the paths starting with fs_prefix
+struct device_base {
+  const std::string fs_prefix;
+
+  device_base() : fs_prefix(makePrefix()) {}
+  virtual ~device_base() = default;
+
+  virtual bool stat(const std::string &path, stat_t &info) = 0;
+  virtual bool statfs(const std::string &path, device_stat &info) = 0;
+  virtual std::unique_ptr<file_base> open(const std::string &path,
+                                          bs_t<open_mode> mode) = 0;
+  virtual std::unique_ptr<dir_base> open_dir(const std::string &path) = 0;
+
+private:
+  static std::string makePrefix() {
+    static std::atomic<u64> next{0};
+    return "/vfsv0_host" + std::to_string(next++) + "_";
+  }
+};
+
+namespace detail {
+struct devices {
+  std::mutex mutex;
+  std::map<std::string, std::shared_ptr<device_base>> byPrefix;
+
+  static devices &get() {
+    static devices instance;
+    return instance;
+  }
+};
+} // namespace detail
+
+inline std::shared_ptr<device_base>
+set_virtual_device(const std::string &name,
+                   std::shared_ptr<device_base> device) {
+  auto &devices = detail::devices::get();
+  std::lock_guard lock(devices.mutex);
+
+  if (device) {
+    devices.byPrefix[name] = device;
+  } else {
+    devices.byPrefix.erase(name);
+  }
+
+  return device;
+}
+
+inline std::shared_ptr<device_base>
+get_virtual_device(const std::string &path) {
+  auto &devices = detail::devices::get();
+  std::lock_guard lock(devices.mutex);
+
+  for (auto &[prefix, device] : devices.byPrefix) {
+    if (path.starts_with(prefix)) {
+      return device;
+    }
+  }
+
+  return nullptr;
+}
+
+namespace detail {
+class native_file final : public file_base {
+public:
+  explicit native_file(native_handle fd) : fd(fd) {}
+  ~native_file() override { ::close(fd); }
+
+  stat_t get_stat() override {
+    struct ::stat native {};
+    ::fstat(fd, &native);
+
+    stat_t info{};
+    info.is_directory = S_ISDIR(native.st_mode);
+    info.is_writable = true;
+    info.size = native.st_size;
+    info.atime = native.st_atime;
+    info.mtime = native.st_mtime;
+    info.ctime = native.st_ctime;
+    return info;
+  }
+
+  bool trunc(u64 length) override { return ::ftruncate(fd, length) == 0; }
+  void sync() override { ::fsync(fd); }
+
+  u64 read(void *buffer, u64 size) override {
+    const auto result = ::read(fd, buffer, size);
+    return result < 0 ? 0 : result;
+  }
+
+  u64 read_at(u64 offset, void *buffer, u64 size) override {
+    u64 done = 0;
+
+    while (done < size) {
+      const auto result = ::pread(fd, static_cast<u8 *>(buffer) + done,
+                                  size - done, offset + done);
+      if (result <= 0) {
+        break;
+      }
+
+      done += result;
+    }
+
+    return done;
+  }
+
+  u64 write(const void *buffer, u64 size) override {
+    const auto result = ::write(fd, buffer, size);
+    return result < 0 ? 0 : result;
+  }
+
+  u64 seek(s64 offset, seek_mode whence) override {
+    const int native = whence == seek_set   ? SEEK_SET
+                       : whence == seek_cur ? SEEK_CUR
+                                            : SEEK_END;
+    return ::lseek(fd, offset, native);
+  }
+
+  u64 size() override { return get_stat().size; }
+
+private:
+  native_handle fd;
+};
+} // namespace detail
+
+class file {
+public:
+  file() = default;
+
+  explicit file(const std::string &path,
+                bs_t<open_mode> mode = open_mode::read) {
+    int flags = mode & open_mode::write ? O_RDWR : O_RDONLY;
+    flags |= mode & open_mode::append ? O_APPEND : 0;
+    flags |= mode & open_mode::create ? O_CREAT : 0;
+    flags |= mode & open_mode::trunc ? O_TRUNC : 0;
+    flags |= mode & open_mode::excl ? O_EXCL : 0;
+
+    const int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+      impl = std::make_unique<detail::native_file>(fd);
+    }
+  }
+
+  static file from_native_handle(native_handle fd) {
+    file result;
+    if (fd >= 0) {
+      result.impl = std::make_unique<detail::native_file>(fd);
+    }
+
+    return result;
+  }
+
+  void reset(std::unique_ptr<file_base> &&ptr = nullptr) {
+    impl = std::move(ptr);
+  }
+
+  explicit operator bool() const { return impl != nullptr; }
+
+  u64 read(void *buffer, u64 size) const { return impl->read(buffer, size); }
+  u64 read_at(u64 offset, void *buffer, u64 size) const {
+    return impl->read_at(offset, buffer, size);
+  }
+
+  u64 write(const void *data, u64 size) const {
+    return impl->write(data, size);
+  }
+
+  u64 size() const { return impl->size(); }
+  void sync() const { impl->sync(); }
+  stat_t get_stat() const { return impl->get_stat(); }
+
+  template <typename T> std::vector<T> to_vector() const {
+    std::vector<T> result(impl->size() / sizeof(T));
+    result.resize(impl->read_at(0, result.data(), result.size() * sizeof(T)) /
+                  sizeof(T));
+    return result;
+  }
+
+  bool close() {
+    impl.reset();
+    return true;
+  }
+
+private:
+  std::unique_ptr<file_base> impl;
+};
+
+inline bool create_path(const std::string &path) {
+  std::error_code ec;
+  std::filesystem::create_directories(path, ec);
+  return std::filesystem::is_directory(path, ec);
+}
+
+inline bool remove_file(const std::string &path) {
+  return ::unlink(path.c_str()) == 0;
+}
+
+inline bool rename(const std::string &from, const std::string &to,
+                   bool overwrite) {
+  std::error_code ec;
+  if (!overwrite && std::filesystem::exists(to, ec)) {
+    g_tls_error = error::exist;
+    return false;
+  }
+
+  return ::rename(from.c_str(), to.c_str()) == 0;
+}
+
+// Written to a temporary file which replaces path on commit()
+class pending_file {
+public:
+  fs::file file;
+
+  explicit pending_file(const std::string &path)
+      : file(path + ".tmp", rewrite), target(path) {}
+
+  ~pending_file() {
+    if (file) {
+      file.close();
+      std::remove((target + ".tmp").c_str());
+    }
+  }
+
+  bool commit() {
+    return file.close() &&
+           std::rename((target + ".tmp").c_str(), target.c_str()) == 0;
+  }
+
+private:
+  std::string target;
+};
+} // namespace fs
@@ -0,0 +1,36 @@
+#pragma once
+
+// Stand-in for rpcs3's named_thread_group: every thread runs its own copy of
+// the function, the group joins them when destroyed
+
+#include "util/types.hpp"
+
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class named_thread_group {
+public:
+  template <typename F>
+  named_thread_group(std::string_view, u32 count, const F &func) {
+    for (u32 i = 0; i < count; i++) {
+      threads.emplace_back(func);
+    }
+  }
+
+  named_thread_group(const named_thread_group &) = delete;
+  named_thread_group &operator=(const named_thread_group &) = delete;
+
+  ~named_thread_group() { join(); }
+
+  void join() {
+    for (auto &thread : threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+private:
+  std::vector<std::thread> threads;
+};
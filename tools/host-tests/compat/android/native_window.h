@@ -0,0 +1,19 @@
+#pragma once
+
+// Stand-in for the NDK window API. ANativeWindow is opaque, tests define it
+// together with the functions below
+
+#include <cstdint>
+
+struct ANativeWindow;
+
+enum {
+  WINDOW_FORMAT_RGBA_8888 = 1,
+  WINDOW_FORMAT_RGBX_8888 = 2,
+  WINDOW_FORMAT_RGB_565 = 4,
+};
+
+int32_t ANativeWindow_getWidth(ANativeWindow *window);
+int32_t ANativeWindow_getHeight(ANativeWindow *window);
+int32_t ANativeWindow_getFormat(ANativeWindow *window);
+void ANativeWindow_release(ANativeWindow *window);
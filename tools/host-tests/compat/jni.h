@@ -0,0 +1,55 @@
+#pragma once
+
+// Stand-in for the JNI interface, only the calls the marshalling code makes.
+// References are opaque handles as in the real interface; JNIEnv forwards to
+// virtual functions which each test or benchmark implements, see fake_jni.h
+
+#include <cstdarg>
+#include <cstdint>
+
+using jint = std::int32_t;
+using jlong = std::int64_t;
+using jsize = jint;
+
+class _jobject {};
+class _jclass : public _jobject {};
+class _jstring : public _jobject {};
+class _jarray : public _jobject {};
+class _jobjectArray : public _jarray {};
+
+using jobject = _jobject *;
+using jclass = _jclass *;
+using jstring = _jstring *;
+using jobjectArray = _jobjectArray *;
+
+struct _jmethodID;
+using jmethodID = _jmethodID *;
+
+inline constexpr jint JNI_OK = 0;
+inline constexpr jint JNI_ERR = -1;
+
+struct _JNIEnv {
+  virtual ~_JNIEnv() = default;
+
+  virtual jint PushLocalFrame(jint capacity) = 0;
+  virtual jobject PopLocalFrame(jobject result) = 0;
+  virtual void DeleteLocalRef(jobject ref) = 0;
+
+  virtual jstring NewStringUTF(const char *bytes) = 0;
+  virtual jobjectArray NewObjectArray(jsize length, jclass elementClass,
+                                      jobject initialElement) = 0;
+  virtual void SetObjectArrayElement(jobjectArray array, jsize index,
+                                     jobject value) = 0;
+  virtual jobject NewObjectV(jclass clazz, jmethodID methodID,
+                             va_list args) = 0;
+
+  jobject NewObject(jclass clazz, jmethodID methodID, ...) {
+    va_list args;
+    va_start(args, methodID);
+    jobject result = NewObjectV(clazz, methodID, args);
+    va_end(args);
+    return result;
+  }
+};
+
+using JNIEnv = _JNIEnv;
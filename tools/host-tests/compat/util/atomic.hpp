@@ -0,0 +1,14 @@
+#pragma once
+
+// Stand-in for rpcs3's atomic_t, std::atomic already provides wait/notify
+
+#include <atomic>
+
+template <typename T> class atomic_t : public std::atomic<T> {
+public:
+  using std::atomic<T>::atomic;
+  using std::atomic<T>::operator=;
+
+  T observe() const { return this->load(); }
+  void release(T value) { this->store(value, std::memory_order_release); }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+// Stand-in for rpcs3's logging. Errors and warnings are printed with their
+// format string only, the tests check behaviour rather than log text
+
+#include "util/types.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace logs {
+enum class level : unsigned {
+  always,
+  fatal,
+  error,
+  todo,
+  success,
+  warning,
+  notice,
+  trace,
+};
+
+struct channel;
+
+struct message {
+  level sev;
+  const channel *ch = nullptr;
+
+  operator level() const { return sev; }
+  const channel *operator->() const { return ch; }
+};
+
+class listener {
+public:
+  virtual ~listener() = default;
+  virtual void log(u64 stamp, const message &msg, const std::string &prefix,
+                   const std::string &text) = 0;
+  virtual void sync() {}
+
+  static void add(listener *) {}
+};
+
+struct channel {
+  const char *name;
+
+  template <typename... Args>
+  void fatal(const char *fmt, const Args &...) const {
+    print("F", fmt);
+  }
+
+  template <typename... Args>
+  void error(const char *fmt, const Args &...) const {
+    print("E", fmt);
+  }
+
+  template <typename... Args>
+  void warning(const char *fmt, const Args &...) const {
+    print("W", fmt);
+  }
+
+  template <typename... Args> void todo(const char *, const Args &...) const {}
+  template <typename... Args>
+  void success(const char *, const Args &...) const {}
+  template <typename... Args>
+  void notice(const char *, const Args &...) const {}
+  template <typename... Args> void trace(const char *, const Args &...) const {}
+
+private:
+  void print(const char *severity, const char *fmt) const {
+    std::fprintf(stderr, "%s %s: %s\n", severity, name, fmt);
+  }
+};
+} // namespace logs
+
+#define LOG_CHANNEL(var, name) inline logs::channel var{name}
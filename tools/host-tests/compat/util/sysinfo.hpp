@@ -0,0 +1,12 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace utils {
+inline u32 get_thread_count() {
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+} // namespace utils
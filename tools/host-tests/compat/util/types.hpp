@@ -0,0 +1,44 @@
+#pragma once
+
+// Stand-in for rpcs3's util/types.hpp with the aliases the frontend sources
+// use, so they build on the host without the emulator
+
+#include <cstddef>
+#include <cstdint>
+
+using u8 = std::uint8_t;
+using u16 = std::uint16_t;
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+using u128 = __uint128_t;
+using s8 = std::int8_t;
+using s16 = std::int16_t;
+using s32 = std::int32_t;
+using s64 = std::int64_t;
+using usz = std::size_t;
+using f32 = float;
+using f64 = double;
+
+// Big-endian value as stored in PS3 file formats, the host is little-endian
+template <typename T> class be_t {
+public:
+  be_t() = default;
+  be_t(T value) : stored(swap(value)) {}
+
+  operator T() const { return swap(stored); }
+
+private:
+  static T swap(T value) {
+    if constexpr (sizeof(T) == 1) {
+      return value;
+    } else if constexpr (sizeof(T) == 2) {
+      return static_cast<T>(__builtin_bswap16(value));
+    } else if constexpr (sizeof(T) == 4) {
+      return static_cast<T>(__builtin_bswap32(value));
+    } else {
+      return static_cast<T>(__builtin_bswap64(value));
+    }
+  }
+
+  T stored;
+};
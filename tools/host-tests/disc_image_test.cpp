@@ -0,0 +1,121 @@
+#include "disc_image.h"
+#include "test.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::uint32_t kBlockSize = discimg::kMinBlockSize;
+constexpr char kName[] = "PS3_GAME/PARAM.SFO";
+
+// One file in one block, stored as is
+struct TinyImage {
+  discimg::Header header{};
+  std::vector<std::uint8_t> data = std::vector<std::uint8_t>(kBlockSize);
+
+  TinyImage() {
+    for (std::size_t i = 0; i < data.size(); i++) {
+      data[i] = static_cast<std::uint8_t>(i * 31);
+    }
+
+    header.magic = discimg::kMagic;
+    header.version = discimg::kVersion;
+    header.blockSize = kBlockSize;
+    header.fileCount = 1;
+    header.dataSize = data.size();
+    header.blockCount = 1;
+    header.indexOffset = sizeof(header) + data.size();
+    header.tableOffset = header.indexOffset + 2 * 8;
+    header.tableSize = sizeof(discimg::FileRecord) + std::strlen(kName);
+  }
+
+  void write(const std::string &path) const {
+    const std::uint64_t index[2] = {sizeof(header), header.indexOffset};
+    const discimg::FileRecord record{
+        .offset = 0,
+        .size = data.size(),
+        .flags = 0,
+        .nameSize = static_cast<std::uint32_t>(std::strlen(kName)),
+    };
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(data.data()), data.size());
+    out.write(reinterpret_cast<const char *>(index), sizeof(index));
+    out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    out.write(kName, record.nameSize);
+  }
+};
+
+void testValid(const std::string &path) {
+  const TinyImage tiny;
+  tiny.write(path);
+
+  std::string error;
+  const auto image = DiscImage::open(path, kBlockSize, &error);
+  CHECK(image != nullptr);
+
+  if (!image) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return;
+  }
+
+  CHECK(image->files().size() == 1);
+  CHECK(image->files()[0].name == kName);
+
+  std::vector<std::uint8_t> contents(tiny.data.size());
+  CHECK(image->read(image->files()[0], 0, contents.data(), contents.size()) ==
+        contents.size());
+  CHECK(contents == tiny.data);
+}
+
+void checkRejected(const std::string &path, const TinyImage &tiny,
+                   const std::string &expected) {
+  tiny.write(path);
+
+  std::string error;
+  CHECK(DiscImage::open(path, kBlockSize, &error) == nullptr);
+  CHECK(error == expected);
+}
+
+void testCorrupted(const std::string &path) {
+  // Rounding the data size up to whole blocks would wrap, and the wrapped
+  // block count would match
+  TinyImage tiny;
+  tiny.header.dataSize = UINT64_MAX - 100;
+  tiny.header.blockCount = 0;
+  checkRejected(path, tiny, "corrupted header");
+
+  tiny = {};
+  tiny.header.blockSize = discimg::kMaxBlockSize * 2;
+  checkRejected(path, tiny, "corrupted header");
+
+  // A count the table cannot hold is rejected before anything is reserved
+  tiny = {};
+  tiny.header.fileCount = UINT32_MAX;
+  checkRejected(path, tiny, "truncated file table");
+
+  tiny = {};
+  tiny.header.fileCount = 2;
+  checkRejected(path, tiny, "truncated file table");
+
+  tiny = {};
+  tiny.header.magic = 0;
+  checkRejected(path, tiny, "not a disc image or unsupported version");
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/disc_image_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+  const auto path = (base / "game.rdim").string();
+
+  testValid(path);
+  testCorrupted(path);
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+// JNIEnv for the marshalling test and benchmark. Objects live in memory,
+// local references are handles into per-frame tables like in ART, so the
+// tests see how many references a call keeps alive and catch uses of deleted
+// ones. Nothing is ever collected, reset() drops everything.
+
+#include "util/types.hpp"
+
+#include <jni.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+class FakeJni final : public JNIEnv {
+public:
+  struct Object {
+    enum class Kind { string, array, instance } kind;
+    std::string text;
+
+    // Array elements or constructor arguments, as object indices. npos for
+    // null
+    std::vector<usz> references;
+  };
+
+  static constexpr usz npos = static_cast<usz>(-1);
+
+  FakeJni() { reset(); }
+
+  // Classes are not looked at, constructors only by their argument count
+  static jclass fakeClass() { return reinterpret_cast<jclass>(uintptr_t{1}); }
+  static jmethodID constructor(usz argCount) {
+    return reinterpret_cast<jmethodID>(static_cast<uintptr_t>(argCount));
+  }
+
+  void reset() {
+    objects.clear();
+    refs.clear();
+    frames.assign(1, {});
+    live = 0;
+    peak = 0;
+    callCount = 0;
+    errorCount = 0;
+  }
+
+  // The object behind a live local reference, nullptr otherwise
+  const Object *object(jobject ref) const {
+    const usz index = objectIndex(ref);
+    return index == npos ? nullptr : &objects[index];
+  }
+
+  const Object &objectAt(usz index) const { return objects[index]; }
+
+  usz liveRefs() const { return live; }
+  usz peakRefs() const { return peak; }
+  void resetPeak() { peak = live; }
+
+  // JNI calls made so far
+  u64 calls() const { return callCount; }
+
+  // Uses of deleted or unknown references, pops without a frame
+  u64 errors() const { return errorCount; }
+
+  jint PushLocalFrame(jint) override {
+    callCount++;
+    frames.emplace_back();
+    return JNI_OK;
+  }
+
+  jobject PopLocalFrame(jobject result) override {
+    callCount++;
+
+    if (frames.size() == 1) {
+      errorCount++;
+      return nullptr;
+    }
+
+    const usz target = result ? objectIndex(result) : npos;
+
+    for (const usz ref : frames.back()) {
+      if (refs[ref] != npos) {
+        refs[ref] = npos;
+        live--;
+      }
+    }
+
+    frames.pop_back();
+    return target == npos ? nullptr : newRef<_jobject>(target);
+  }
+
+  void DeleteLocalRef(jobject ref) override {
+    callCount++;
+
+    if (ref == nullptr) {
+      return;
+    }
+
+    const usz index = refIndex(ref);
+    if (index == npos || refs[index] == npos) {
+      errorCount++;
+      return;
+    }
+
+    refs[index] = npos;
+    live--;
+  }
+
+  jstring NewStringUTF(const char *bytes) override {
+    callCount++;
+    objects.push_back({Object::Kind::string, bytes, {}});
+    return newRef<_jstring>(objects.size() - 1);
+  }
+
+  jobjectArray NewObjectArray(jsize length, jclass, jobject) override {
+    callCount++;
+    objects.push_back({Object::Kind::array, {},
+                       std::vector<usz>(static_cast<usz>(length), npos)});
+    return newRef<_jobjectArray>(objects.size() - 1);
+  }
+
+  void SetObjectArrayElement(jobjectArray array, jsize index,
+                             jobject value) override {
+    callCount++;
+    const usz arrayIndex = objectIndex(array);
+    const usz valueIndex = value ? objectIndex(value) : npos;
+
+    if (arrayIndex == npos || (value && valueIndex == npos) ||
+        static_cast<usz>(index) >= objects[arrayIndex].references.size()) {
+      errorCount++;
+      return;
+    }
+
+    objects[arrayIndex].references[index] = valueIndex;
+  }
+
+  jobject NewObjectV(jclass, jmethodID methodID, va_list args) override {
+    callCount++;
+    Object object{Object::Kind::instance, {}, {}};
+
+    for (uintptr_t i = 0; i < reinterpret_cast<uintptr_t>(methodID); i++) {
+      const jobject arg = va_arg(args, jobject);
+      const usz index = arg ? objectIndex(arg) : npos;
+
+      if (arg && index == npos) {
+        errorCount++;
+      }
+
+      object.references.push_back(index);
+    }
+
+    objects.push_back(std::move(object));
+    return newRef<_jobject>(objects.size() - 1);
+  }
+
+private:
+  template <typename T> T *newRef(usz object) {
+    refs.push_back(object);
+    frames.back().push_back(refs.size() - 1);
+    peak = std::max(peak, ++live);
+    return reinterpret_cast<T *>(static_cast<uintptr_t>(refs.size()));
+  }
+
+  usz refIndex(jobject ref) const {
+    const auto handle = reinterpret_cast<uintptr_t>(ref);
+    return handle == 0 || handle > refs.size() ? npos : handle - 1;
+  }
+
+  usz objectIndex(jobject ref) const {
+    const usz index = refIndex(ref);
+    return index == npos ? npos : refs[index];
+  }
+
+  std::deque<Object> objects;
+
+  // Object index of every local reference ever created, npos once deleted
+  std::vector<usz> refs;
+  std::vector<std::vector<usz>> frames;
+  usz live = 0;
+  usz peak = 0;
+  u64 callCount = 0;
+  u64 errorCount = 0;
+};
@@ -0,0 +1,132 @@
+#include "fd_window_file.h"
+#include "test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+struct TarSource {
+  std::string name;
+  std::string prefix;
+  char type = '0';
+  std::vector<u8> data;
+};
+
+// Writes a ustar archive, headers carry no checksum since nothing checks it
+std::vector<u8> buildTar(const std::vector<TarSource> &sources) {
+  std::vector<u8> tar;
+
+  for (auto &source : sources) {
+    char header[512]{};
+    std::memcpy(header, source.name.data(), source.name.size());
+    std::snprintf(header + 124, 12, "%011llo",
+                  static_cast<unsigned long long>(source.data.size()));
+    header[156] = source.type;
+    std::memcpy(header + 257, "ustar", 6);
+    std::memcpy(header + 345, source.prefix.data(), source.prefix.size());
+
+    tar.insert(tar.end(), header, header + sizeof(header));
+    tar.insert(tar.end(), source.data.begin(), source.data.end());
+    tar.resize((tar.size() + 511) / 512 * 512);
+  }
+
+  tar.resize(tar.size() + 1024);
+  return tar;
+}
+
+std::vector<u8> pattern(usz size, u8 seed) {
+  std::vector<u8> data(size);
+  for (usz i = 0; i < size; i++) {
+    data[i] = static_cast<u8>(i * 13 + seed);
+  }
+
+  return data;
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/fd_window_file_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+  const auto path = (base / "update.pup").string();
+
+  const std::vector<TarSource> sources = {
+      {"dev_flash_000.tar.aa.2010_11_27_051337", {}, '0', pattern(700, 1)},
+      {"dev_flash", {}, '5', {}},
+      {"dev_flash_001.tar.aa.2010_11_27_051337", {}, '\0', pattern(1024, 2)},
+      {"dev_flash_002.tar", "prefix", '0', pattern(3, 3)},
+      {"empty", {}, '0', {}},
+  };
+
+  // The TAR sits inside a larger file, like the update entry of a PUP
+  constexpr u64 kTarBase = 0x1234;
+  const auto tar = buildTar(sources);
+  std::vector<u8> file(kTarBase, 0xee);
+  file.insert(file.end(), tar.begin(), tar.end());
+  file.resize(file.size() + 100, 0xee);
+
+  {
+    std::FILE *out = std::fopen(path.c_str(), "wb");
+    std::fwrite(file.data(), 1, file.size(), out);
+    std::fclose(out);
+  }
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  CHECK(fd >= 0);
+
+  const fs::file archive = FdWindowFile::open(fd, kTarBase, tar.size());
+  CHECK(archive.size() == tar.size());
+
+  std::vector<TarEntry> entries;
+  CHECK(listTarEntries(archive, entries));
+  CHECK(entries.size() == 4);
+
+  if (entries.size() == 4) {
+    CHECK(entries[0].name == sources[0].name);
+    CHECK(entries[1].name == sources[2].name);
+    CHECK(entries[2].name == "prefix/dev_flash_002.tar");
+    CHECK(entries[3].name == "empty" && entries[3].size == 0);
+
+    // Packages are read concurrently, each through its own view
+    const usz expected[] = {0, 2, 3};
+    std::vector<std::thread> threads;
+    bool matches[3]{};
+
+    for (usz i = 0; i < 3; i++) {
+      threads.emplace_back([&, i] {
+        const auto &entry = entries[i];
+        const fs::file view =
+            FdWindowFile::open(fd, kTarBase + entry.offset, entry.size);
+
+        // Reads stop at the end of the view, not of the file
+        std::vector<u8> data(entry.size + 64);
+        data.resize(view.read(data.data(), data.size()));
+        matches[i] = data == sources[expected[i]].data;
+      });
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    CHECK(matches[0] && matches[1] && matches[2]);
+  }
+
+  // A header whose data runs past the end of the archive
+  std::vector<TarEntry> truncated;
+  CHECK(!listTarEntries(FdWindowFile::open(fd, kTarBase, 512 + 100),
+                        truncated));
+
+  // Not a TAR
+  std::vector<TarEntry> garbage;
+  CHECK(!listTarEntries(FdWindowFile::open(fd, 0, kTarBase), garbage));
+
+  ::close(fd);
+  std::filesystem::remove_all(base);
+  return testResult();
+}
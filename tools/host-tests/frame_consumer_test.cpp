@@ -0,0 +1,195 @@
+#include "frame_consumer.h"
+#include "test.h"
+
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace {
+using PixelFormat = FrameConsumer::PixelFormat;
+
+// A frame in its own allocation of exactly pitch * height bytes, so the
+// sanitizer catches reads past its end
+struct Image {
+  u32 width;
+  u32 height;
+  u32 pitch;
+  std::unique_ptr<u8[]> data;
+
+  Image(u32 width, u32 height, u32 padding = 0)
+      : width(width), height(height), pitch(width * 4 + padding),
+        data(new u8[static_cast<usz>(pitch) * height]) {
+    for (u32 y = 0; y < height; y++) {
+      for (u32 x = 0; x < width; x++) {
+        u8 *pixel = at(x, y);
+        pixel[0] = static_cast<u8>(x * 8);
+        pixel[1] = static_cast<u8>(y * 8);
+        pixel[2] = static_cast<u8>(x + y);
+        pixel[3] = 0xff;
+      }
+    }
+  }
+
+  u8 *at(u32 x, u32 y) const { return data.get() + y * pitch + x * 4; }
+
+  void submit(FrameConsumer &consumer, bool isBgra, u64 now) const {
+    consumer.submit(data.get(), pitch, width, height, isBgra, now);
+  }
+};
+
+const u8 *pixelAt(const FrameConsumer::Frame &frame, u32 x, u32 y) {
+  const u32 bytesPerPixel = frame.pitch / frame.width;
+  return frame.pixels.data() + y * frame.pitch + x * bytesPerPixel;
+}
+
+void testConversion() {
+  FrameConsumer consumer;
+  const Image image(8, 6, 12);
+
+  // Padding is dropped, the pixels are copied as is
+  CHECK(consumer.configure({}));
+  image.submit(consumer, false, 1);
+  auto frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->width == 8 && frame->height == 6 && frame->pitch == 32);
+  CHECK(frame && std::memcmp(pixelAt(*frame, 5, 4), image.at(5, 4), 4) == 0);
+
+  // BGRA input is swapped into RGBA
+  image.submit(consumer, true, 2);
+  frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && pixelAt(*frame, 3, 2)[0] == image.at(3, 2)[2] &&
+        pixelAt(*frame, 3, 2)[2] == image.at(3, 2)[0]);
+
+  // Box filter over divisor x divisor pixels
+  CHECK(consumer.configure({.scaleDivisor = 2}));
+  image.submit(consumer, false, 3);
+  frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->width == 4 && frame->height == 3);
+  CHECK(frame && pixelAt(*frame, 1, 1)[0] == (16 + 24) / 2 &&
+        pixelAt(*frame, 1, 1)[1] == (16 + 24) / 2 &&
+        pixelAt(*frame, 1, 1)[2] == (4 + 5 + 5 + 6) / 4);
+
+  CHECK(consumer.configure({.format = PixelFormat::rgb565}));
+  image.submit(consumer, false, 4);
+  frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->pitch == 16 && frame->format == PixelFormat::rgb565);
+
+  if (frame) {
+    u16 pixel;
+    std::memcpy(&pixel, pixelAt(*frame, 7, 5), sizeof(pixel));
+    CHECK(pixel == (((56 >> 3) << 11) | ((40 >> 2) << 5) | (12 >> 3)));
+  }
+
+  consumer.release();
+}
+
+// Frames smaller than the divisor are scaled to a single pixel row or column
+// instead of sampling past the source
+void testSmallFrames() {
+  FrameConsumer consumer;
+  CHECK(consumer.configure({.scaleDivisor = 16}));
+
+  const Image tall(3, 40);
+  tall.submit(consumer, false, 1);
+  auto frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->width == 1 && frame->height == 13);
+
+  const Image wide(50, 1);
+  wide.submit(consumer, true, 2);
+  frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->width == 50 && frame->height == 1);
+
+  const Image single(1, 1);
+  single.submit(consumer, false, 3);
+  frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->width == 1 && frame->height == 1);
+  CHECK(frame && std::memcmp(frame->pixels.data(), single.at(0, 0), 4) == 0);
+
+  consumer.release();
+}
+
+void testPool() {
+  FrameConsumer consumer;
+  const Image image(4, 4);
+
+  CHECK(!consumer.configure({.scaleDivisor = 0}));
+  CHECK(!consumer.configure({.scaleDivisor = 17}));
+  CHECK(!consumer.wantsFrame(1));
+
+  CHECK(consumer.configure({.maxRate = 10}));
+  CHECK(consumer.wantsFrame(1));
+  image.submit(consumer, false, 1'000'000'000);
+  CHECK(!consumer.wantsFrame(1'050'000'000));
+  CHECK(consumer.wantsFrame(1'100'000'000));
+
+  // The consumer fell behind, the oldest unread frames are overwritten and
+  // it gets the newest
+  for (u64 i = 2; i <= 5; i++) {
+    image.submit(consumer, false, i * 1'000'000'000);
+  }
+
+  auto frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->timestamp == 5'000'000'000);
+  CHECK(consumer.acquired() == frame);
+  CHECK(consumer.dropped() == 4);
+
+  // The frame being read is never overwritten
+  for (u64 i = 6; i <= 10; i++) {
+    image.submit(consumer, false, i * 1'000'000'000);
+  }
+
+  CHECK(frame && frame->timestamp == 5'000'000'000);
+
+  consumer.release();
+  CHECK(consumer.acquired() == nullptr);
+
+  // Buffers in use survive a trim, free ones are dropped
+  frame = consumer.acquire(std::chrono::milliseconds(0));
+  CHECK(frame && frame->timestamp == 10'000'000'000);
+  CHECK(consumer.memoryUsage() >= 3 * 64);
+  CHECK(consumer.trim() >= 2 * 64);
+  CHECK(frame && frame->pixels.size() == 64);
+
+  consumer.disable();
+  CHECK(consumer.acquire(std::chrono::milliseconds(0)) == nullptr);
+  CHECK(consumer.acquired() == nullptr);
+  CHECK(consumer.trim() == 64);
+  CHECK(consumer.memoryUsage() == 0);
+}
+
+// Renderer and consumer on their own threads, as in the app
+void testThreads() {
+  FrameConsumer consumer;
+  CHECK(consumer.configure({.scaleDivisor = 2}));
+  const Image image(64, 64);
+
+  std::thread renderer([&] {
+    for (u64 i = 1; i <= 2000; i++) {
+      image.submit(consumer, i % 2, i);
+    }
+
+    consumer.disable();
+  });
+
+  u64 lastSequence = 0;
+  u64 received = 0;
+
+  while (auto frame = consumer.acquire(std::chrono::seconds(5))) {
+    CHECK(frame->sequence > lastSequence);
+    CHECK(frame->width == 32 && frame->pixels.size() == 32 * 32 * 4);
+    lastSequence = frame->sequence;
+    received++;
+  }
+
+  renderer.join();
+  CHECK(received > 0);
+  CHECK(received + consumer.dropped() <= 2000);
+}
+} // namespace
+
+int main() {
+  testConversion();
+  testSmallFrames();
+  testPool();
+  testThreads();
+  return testResult();
+}
@@ -0,0 +1,135 @@
+#include "frame_pacer.h"
+#include "test.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+constexpr u64 kMs = 1'000'000;
+
+// Synthetic display: reports a vsync every period up to the current time,
+// like Choreographer does on the UI thread
+struct VsyncSource {
+  FramePacer &pacer;
+  f64 rate;
+  u64 period = static_cast<u64>(1e9 / rate);
+  u64 next = 1'000 * kMs;
+
+  void advance(u64 now) {
+    for (; next <= now; next += period) {
+      pacer.onVsync(next, rate);
+    }
+  }
+};
+
+// Renders frames which take work(i) ns each and sleeps until the time the
+// pacer returns. Returns the start time of every frame.
+template <typename Work>
+std::vector<u64> render(FramePacer &pacer, VsyncSource &display, u64 &now,
+                        usz frames, Work &&work) {
+  std::vector<u64> starts;
+
+  for (usz i = 0; i < frames; i++) {
+    now += work(i);
+    display.advance(now);
+    now = std::max(pacer.onFrame(now), now);
+    starts.push_back(now);
+  }
+
+  return starts;
+}
+
+bool onGrid(const VsyncSource &display, u64 time) {
+  const s64 offset = static_cast<s64>(time - display.next) %
+                     static_cast<s64>(display.period);
+  const s64 distance = std::min<s64>(std::abs(offset),
+                                     display.period - std::abs(offset));
+  return distance < 1'000;
+}
+
+// Frames keep the smallest whole number of vsyncs they fit in, frames of
+// 30 ms on a 120 Hz panel are shown for exactly four refreshes
+void testCadence(f64 rate, u64 work, u32 cadence) {
+  FramePacer pacer;
+  VsyncSource display{pacer, rate};
+  u64 now = display.next;
+  display.advance(now);
+
+  const auto starts =
+      render(pacer, display, now, 300, [&](usz) { return work; });
+
+  const auto stats = pacer.stats();
+  CHECK(stats.cadence == cadence);
+  CHECK(stats.refreshRate == rate);
+  CHECK(stats.frames == 300);
+
+  // After the averages settled every frame starts on a vsync and lasts the
+  // same number of them
+  for (usz i = 100; i < starts.size(); i++) {
+    CHECK(onGrid(display, starts[i]));
+    const u64 interval = starts[i] - starts[i - 1];
+    CHECK(std::llabs(static_cast<s64>(interval - cadence * display.period)) <
+          1'000);
+  }
+}
+
+// A slow frame is counted as missed, the next frame starts right away and
+// the cadence recovers
+void testMissedDeadline() {
+  FramePacer pacer;
+  VsyncSource display{pacer, 60};
+  u64 now = display.next;
+  display.advance(now);
+
+  render(pacer, display, now, 200, [](usz) { return 10 * kMs; });
+  CHECK(pacer.stats().missedDeadlines == 0);
+  CHECK(pacer.stats().cadence == 1);
+
+  const u64 before = now;
+  const auto starts = render(pacer, display, now, 1,
+                             [](usz) { return 45 * kMs; });
+  CHECK(pacer.stats().missedDeadlines == 1);
+  CHECK(starts[0] == before + 45 * kMs);
+
+  const auto after =
+      render(pacer, display, now, 200, [](usz) { return 10 * kMs; });
+  CHECK(pacer.stats().cadence == 1);
+  CHECK(onGrid(display, after.back()));
+  CHECK(pacer.stats().maxFrameTimeMs >= 45);
+}
+
+// Without display timing the pacer never delays a frame
+void testNoDisplay() {
+  FramePacer pacer;
+  CHECK(pacer.refreshRate() == FramePacer::kDefaultRefreshRate);
+
+  u64 now = 1'000 * kMs;
+  for (int i = 0; i < 10; i++) {
+    now += 7 * kMs;
+    CHECK(pacer.onFrame(now) == now);
+  }
+
+  // Vsync reports stop in background, an old grid is not projected
+  pacer.onVsync(now, 90);
+  CHECK(pacer.refreshRate() == 90);
+  now += 2'000 * kMs;
+  CHECK(pacer.onFrame(now) == now);
+  CHECK(pacer.onFrame(now + 5 * kMs) == now + 5 * kMs);
+
+  pacer.reset();
+  const auto stats = pacer.stats();
+  CHECK(stats.frames == 0 && stats.missedDeadlines == 0);
+  CHECK(stats.maxFrameTimeMs == 0 && stats.cadence == 1);
+}
+} // namespace
+
+int main() {
+  testCadence(60, 10 * kMs, 1);
+  testCadence(60, 25 * kMs, 2);
+  testCadence(120, 30 * kMs, 4);
+  testCadence(90, 20 * kMs, 2);
+  testMissedDeadline();
+  testNoDisplay();
+  return testResult();
+}
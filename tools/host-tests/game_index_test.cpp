@@ -0,0 +1,143 @@
+#include "game_index.h"
+#include "test.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+GameIndex::Entry bootable(const std::string &path, s64 mtime, u64 size) {
+  return {.mtime = mtime,
+          .size = size,
+          .info = GameInfo{.path = path,
+                           .name = "Title " + path,
+                           .iconPath = path + "/ICON0.PNG"}};
+}
+
+std::vector<std::string> listPaths(GameIndex &index,
+                                   const std::vector<std::string> &roots) {
+  std::vector<std::string> paths;
+  for (auto &info : index.list(roots)) {
+    paths.push_back(info.path);
+  }
+
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+void testLookup(const std::string &file) {
+  GameIndex index(file);
+
+  CHECK(!index.find("/games/A", 1, 10));
+
+  index.update("/games/A", bootable("/games/A", 1, 10));
+  index.update("/games/B", {.mtime = 2, .size = 20});
+
+  const auto entry = index.find("/games/A", 1, 10);
+  CHECK(entry && entry->info && entry->info->name == "Title /games/A");
+
+  // A modified PARAM.SFO invalidates the entry
+  CHECK(!index.find("/games/A", 2, 10));
+  CHECK(!index.find("/games/A", 1, 11));
+
+  // Non bootable entries are cached but not listed
+  const auto other = index.find("/games/B", 2, 20);
+  CHECK(other && !other->info);
+  CHECK(listPaths(index, {"/games"}) == std::vector<std::string>{"/games/A"});
+}
+
+void testRoots(const std::string &file) {
+  GameIndex index(file);
+
+  index.update("/games/A", bootable("/games/A", 1, 1));
+  index.update("/games/sub/B", bootable("/games/sub/B", 1, 1));
+  index.update("/games2/C", bootable("/games2/C", 1, 1));
+  index.update("/mnt/D", bootable("/mnt/D", 1, 1));
+
+  // A root matches whole path components only
+  CHECK(listPaths(index, {"/games"}) ==
+        (std::vector<std::string>{"/games/A", "/games/sub/B"}));
+  CHECK(listPaths(index, {"/games/"}) ==
+        (std::vector<std::string>{"/games/A", "/games/sub/B"}));
+  CHECK(listPaths(index, {"/games2", "/mnt"}) ==
+        (std::vector<std::string>{"/games2/C", "/mnt/D"}));
+  CHECK(listPaths(index, {}).empty());
+
+  // Retaining one root leaves the others alone
+  index.retain("/games", {"/games/sub/B"});
+  CHECK(listPaths(index, {"/games", "/games2", "/mnt"}) ==
+        (std::vector<std::string>{"/games/sub/B", "/games2/C", "/mnt/D"}));
+}
+
+void testPersistence(const std::string &file) {
+  {
+    GameIndex index(file);
+    index.update("/games/A", bootable("/games/A", 5, 50));
+    index.update("/games/B", {.mtime = 6, .size = 60});
+    CHECK(index.save());
+  }
+
+  GameIndex index(file);
+  const auto entry = index.find("/games/A", 5, 50);
+  CHECK(entry && entry->info && entry->info->iconPath == "/games/A/ICON0.PNG");
+  CHECK(index.find("/games/B", 6, 60));
+
+  // Nothing changed, nothing is written
+  std::filesystem::remove(file);
+  CHECK(index.save());
+  CHECK(!std::filesystem::exists(file));
+
+  index.retain("/games", {"/games/A"});
+  CHECK(index.save());
+
+  GameIndex reloaded(file);
+  CHECK(reloaded.find("/games/A", 5, 50));
+  CHECK(!reloaded.find("/games/B", 6, 60));
+}
+
+void testCorrupt(const std::string &file) {
+  {
+    GameIndex index(file);
+    index.update("/games/A", bootable("/games/A", 1, 1));
+    index.update("/games/B", bootable("/games/B", 2, 2));
+    CHECK(index.save());
+  }
+
+  const auto size = std::filesystem::file_size(file);
+
+  // A truncated index is dropped as a whole, every cut must be caught
+  for (auto cut = size; cut-- > 0;) {
+    std::filesystem::resize_file(file, cut);
+
+    GameIndex index(file);
+    CHECK(listPaths(index, {"/games"}).empty());
+  }
+
+  std::ofstream(file, std::ios::binary | std::ios::trunc)
+      << "not a game index at all";
+  GameIndex garbage(file);
+  CHECK(listPaths(garbage, {"/"}).empty());
+
+  // A corrupt index is replaced by the next save
+  garbage.update("/games/C", bootable("/games/C", 3, 3));
+  CHECK(garbage.save());
+  GameIndex replaced(file);
+  CHECK(replaced.find("/games/C", 3, 3));
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/game_index_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+  const auto file = (base / "games.idx").string();
+
+  testLookup(file);
+  testRoots(file);
+  testPersistence(file);
+  std::filesystem::remove(file);
+  testCorrupt(file);
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
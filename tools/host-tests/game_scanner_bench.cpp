@@ -0,0 +1,60 @@
+// Times the worker scan against the serial walk it replaced on a synthetic
+// library. Usage: game_scanner_bench [directories] [root]
+// Pass a root on the storage to measure (an sdcard or FUSE mount), the
+// default tree in /tmp is mostly served from the dentry cache.
+
+#include "game_scanner.h"
+#include "scan_tree.h"
+#include "util/atomic.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+template <typename F> double timeMs(F &&func) {
+  const auto start = std::chrono::steady_clock::now();
+  func();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const usz directories =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+
+  std::filesystem::path base;
+  if (argc > 2) {
+    base = argv[2];
+  } else {
+    char tmpl[] = "/tmp/game_scanner_bench.XXXXXX";
+    base = ::mkdtemp(tmpl);
+  }
+
+  const auto root = base / "library";
+  const usz games = makeLibrary(root, directories, 6, 20);
+  const std::vector<std::string> roots{root.string()};
+
+  usz serialGames = 0;
+  atomic_t<usz> parallelGames = 0;
+
+  for (int run = 0; run < 3; run++) {
+    const double serial =
+        timeMs([&] { serialGames = serialScan(roots).size(); });
+    const double parallel = timeMs([&] {
+      parallelGames = 0;
+      scanGamePaths(roots, [&](GamePath &&) { parallelGames++; });
+    });
+
+    std::printf("%zu dirs, %zu games: serial %.1f ms (%zu), workers %.1f ms "
+                "(%zu)\n",
+                directories, games, serial, serialGames, parallel,
+                parallelGames.load());
+  }
+
+  std::filesystem::remove_all(root);
+  return serialGames == games && parallelGames == games ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "game_scanner.h"
+#include "scan_tree.h"
+#include "test.h"
+
+#include <mutex>
+#include <random>
+#include <unistd.h>
+
+namespace {
+std::set<std::string> parallelScan(const std::vector<std::string> &rootDirs) {
+  std::mutex mutex;
+  std::set<std::string> paths;
+  usz duplicates = 0;
+
+  scanGamePaths(rootDirs, [&](GamePath &&gamePath) {
+    std::lock_guard lock(mutex);
+    duplicates += !paths.insert(std::move(gamePath.path)).second;
+  });
+
+  CHECK(duplicates == 0);
+  return paths;
+}
+
+void testLayout(const std::filesystem::path &base) {
+  const auto root = base / "games";
+  const auto second = base / "second";
+  const auto outside = base / "outside";
+
+  writeFile(root / "BLUS00001" / "PARAM.SFO");
+  // Games do not contain other games
+  writeFile(root / "BLUS00001" / "nested" / "PARAM.SFO");
+  writeFile(root / "sub" / "deeper" / "NPUB00002" / "PARAM.SFO");
+  writeFile(root / "sub" / "image.rdim", "RDIM");
+  // Only regular files are images, only regular PARAM.SFO make a game
+  std::filesystem::create_directories(root / "folder.rdim" / "x");
+  std::filesystem::create_directories(root / "notgame" / "PARAM.SFO");
+  writeFile(root / "empty" / "readme.txt");
+
+  // A symlinked game is found, a symlinked directory is not descended into
+  writeFile(outside / "linked" / "PARAM.SFO");
+  writeFile(outside / "tree" / "BLES00003" / "PARAM.SFO");
+  std::filesystem::create_directory_symlink(outside / "linked",
+                                            root / "link-game");
+  std::filesystem::create_directory_symlink(outside / "tree",
+                                            root / "link-tree");
+
+  writeFile(second / "BCES00004" / "PARAM.SFO");
+
+  const std::vector<std::string> roots{root.string(), second.string(),
+                                       (base / "missing").string()};
+  const auto expected = serialScan(roots);
+
+  CHECK(expected.size() == 5);
+  CHECK(expected.contains((root / "link-game").string()));
+  CHECK(!expected.contains((root / "link-tree" / "BLES00003").string()));
+  CHECK(parallelScan(roots) == expected);
+
+  // A game root given as scan root is not probed itself
+  CHECK(parallelScan({(root / "BLUS00001").string()}) ==
+        serialScan({(root / "BLUS00001").string()}));
+}
+
+void testRandomTree(const std::filesystem::path &base) {
+  std::mt19937 rng(1234);
+  const auto root = base / "random";
+  std::vector<std::filesystem::path> dirs{root};
+
+  for (int i = 0; i < 2000; i++) {
+    const auto parent = dirs[rng() % dirs.size()];
+    const auto dir = parent / ("d" + std::to_string(i));
+
+    switch (rng() % 8) {
+    case 0:
+      writeFile(dir / "PARAM.SFO");
+      break;
+    case 1:
+      writeFile(parent / ("i" + std::to_string(i) + ".rdim"));
+      break;
+    default:
+      std::filesystem::create_directories(dir);
+      dirs.push_back(dir);
+      break;
+    }
+  }
+
+  const auto expected = serialScan({root.string()});
+  CHECK(!expected.empty());
+  CHECK(parallelScan({root.string()}) == expected);
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/game_scanner_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+
+  testLayout(base);
+  testRandomTree(base);
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
@@ -0,0 +1,182 @@
+#include "input_monitor.h"
+#include "test.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <unistd.h>
+
+namespace {
+u64 steadyClockNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Stands in for a pad: a report is a write to the pipe, the monitor watches
+// the read end like it watches a usbfs connection
+struct FakePad {
+  int fds[2] = {-1, -1};
+
+  FakePad() { CHECK(pipe(fds) == 0); }
+
+  ~FakePad() {
+    closeWriteEnd();
+    close(fds[0]);
+  }
+
+  int fd() const { return fds[0]; }
+
+  void report() {
+    const char data = 1;
+    CHECK(write(fds[1], &data, 1) == 1);
+  }
+
+  // The handler reads the report, like libusb reaping the transfer
+  void drain() {
+    char data[16];
+    [[maybe_unused]] auto r = read(fds[0], data, sizeof(data));
+  }
+
+  void closeWriteEnd() {
+    if (fds[1] >= 0) {
+      close(fds[1]);
+      fds[1] = -1;
+    }
+  }
+};
+
+// Counts wakeups of the pad thread
+struct WakeCounter {
+  std::mutex mutex;
+  std::condition_variable cv;
+  u32 count = 0;
+
+  void wake() {
+    {
+      std::lock_guard lock(mutex);
+      count++;
+    }
+
+    cv.notify_all();
+  }
+
+  bool waitFor(u32 expected) {
+    std::unique_lock lock(mutex);
+    return cv.wait_for(lock, std::chrono::seconds(1),
+                       [&] { return count >= expected; });
+  }
+
+  u32 get() {
+    std::lock_guard lock(mutex);
+    return count;
+  }
+};
+
+// The monitor records a wakeup once the wake callback returned
+bool waitForWakeups(const InputEventMonitor &monitor, u64 expected) {
+  for (int i = 0; i < 1000 && monitor.stats().wakeups < expected; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return monitor.stats().wakeups == expected;
+}
+
+void testWake() {
+  WakeCounter counter;
+  InputEventMonitor monitor;
+  CHECK(!monitor.running());
+  CHECK(monitor.start([&] { counter.wake(); }));
+  CHECK(monitor.running());
+
+  FakePad pad;
+  monitor.addDevice(pad.fd());
+
+  // Every report wakes the pad thread, after the reap delay
+  for (u32 i = 1; i <= 5; i++) {
+    const u64 sent = steadyClockNs();
+    pad.report();
+    CHECK(counter.waitFor(i));
+    CHECK(steadyClockNs() - sent >= InputEventMonitor::kReapDelayNs);
+    pad.drain();
+  }
+
+  CHECK(waitForWakeups(monitor, 5));
+  auto stats = monitor.stats();
+  CHECK(stats.reports == 5);
+  CHECK(stats.wakeups == 5);
+  CHECK(stats.averageWakeUs >= InputEventMonitor::kReapDelayNs / 1e3);
+  CHECK(stats.maxWakeUs >= stats.averageWakeUs);
+  std::printf("report to wake: %.0f us average, %.0f us max\n",
+              stats.averageWakeUs, stats.maxWakeUs);
+
+  // The first frame after a report counts, frames without one do not
+  monitor.onFrame(steadyClockNs());
+  monitor.onFrame(steadyClockNs());
+  stats = monitor.stats();
+  CHECK(stats.frames == 1);
+  CHECK(stats.averageFrameMs > 0);
+
+  monitor.resetStats();
+  stats = monitor.stats();
+  CHECK(stats.reports == 0 && stats.wakeups == 0 && stats.frames == 0);
+
+  // Removed pads wake nothing
+  monitor.removeDevice(pad.fd());
+  pad.report();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK(counter.get() == 5);
+  pad.drain();
+
+  monitor.stop();
+  CHECK(!monitor.running());
+}
+
+void testUnplug() {
+  WakeCounter counter;
+  InputEventMonitor monitor;
+  CHECK(monitor.start([&] { counter.wake(); }));
+
+  FakePad unplugged;
+  FakePad other;
+  monitor.addDevice(unplugged.fd());
+  monitor.addDevice(other.fd());
+
+  // A hangup drops the fd without waking the pad thread
+  unplugged.closeWriteEnd();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK(counter.get() == 0);
+
+  // The other pad still works
+  other.report();
+  CHECK(counter.waitFor(1));
+  CHECK(waitForWakeups(monitor, 1));
+  CHECK(monitor.stats().reports == 1);
+
+  // Stop returns while the monitor is blocked, and the monitor can be
+  // started again
+  monitor.stop();
+  monitor.stop();
+  CHECK(monitor.start([&] { counter.wake(); }));
+  other.drain();
+  monitor.addDevice(other.fd());
+  other.report();
+  CHECK(counter.waitFor(2));
+}
+
+void testStopped() {
+  // Devices added while stopped are ignored instead of failing
+  InputEventMonitor monitor;
+  FakePad pad;
+  monitor.addDevice(pad.fd());
+  monitor.removeDevice(pad.fd());
+  monitor.stop();
+  CHECK(!monitor.running());
+}
+} // namespace
+
+int main() {
+  testWake();
+  testUnplug();
+  testStopped();
+  return testResult();
+}
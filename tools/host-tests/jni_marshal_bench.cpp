@@ -0,0 +1,108 @@
+// Measures the native side of sendGameInfo per game entry: time, JNI calls
+// and the most local references alive at once, for the marshalling before
+// makeGameInfoArray (every entry kept in a std::vector, references released
+// with the frame) and with it.
+// Usage: jni_marshal_bench [entries per batch] [batches]
+//
+// The JNIEnv is fake_jni.h, so the times cover the marshalling loop and the
+// string copies but not allocation and reference bookkeeping in ART. Run the
+// app with a large library to measure those on a device.
+
+#include "fake_jni.h"
+#include "jni_marshal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  f64 nsPerEntry;
+  f64 callsPerEntry;
+  usz peakRefs;
+};
+
+// sendGameInfo before the binding cache, without its class and method lookups
+jobjectArray makeGameInfoArrayVector(JNIEnv *env, jclass gameInfo,
+                                     jmethodID constructor,
+                                     const std::vector<GameInfo> &infos) {
+  std::vector<jobject> objects;
+
+  for (const auto &info : infos) {
+    objects.push_back(env->NewObject(gameInfo, constructor,
+                                     env->NewStringUTF(info.path.c_str()),
+                                     env->NewStringUTF(info.name.c_str()),
+                                     env->NewStringUTF(info.iconPath.c_str())));
+  }
+
+  auto result = env->NewObjectArray(objects.size(), gameInfo, nullptr);
+
+  for (std::size_t i = 0; i < objects.size(); ++i) {
+    env->SetObjectArrayElement(result, i, objects[i]);
+  }
+
+  return result;
+}
+
+template <typename F>
+Result measure(const std::vector<GameInfo> &infos, usz batches, F &&marshal) {
+  FakeJni env;
+  Clock::duration total{};
+  u64 calls = 0;
+  usz peak = 0;
+
+  for (usz batch = 0; batch < batches; batch++) {
+    env.reset();
+    const auto start = Clock::now();
+
+    env.PushLocalFrame(16);
+    marshal(env);
+    env.PopLocalFrame(nullptr);
+
+    total += Clock::now() - start;
+    calls += env.calls();
+    peak = std::max(peak, env.peakRefs());
+  }
+
+  const auto entries = static_cast<f64>(infos.size() * batches);
+  return {std::chrono::duration<f64, std::nano>(total).count() / entries,
+          static_cast<f64>(calls) / entries, peak};
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const usz entries = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+  const usz batches = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 50;
+
+  std::vector<GameInfo> infos;
+  for (usz i = 0; i < entries; i++) {
+    infos.push_back({"/storage/emulated/0/games/BLES" + std::to_string(i),
+                     "Game title " + std::to_string(i),
+                     "/data/user/0/net.rpcs3/cache/icons/" +
+                         std::to_string(i) + ".png"});
+  }
+
+  const auto gameInfo = FakeJni::fakeClass();
+  const auto constructor = FakeJni::constructor(3);
+
+  const auto before = measure(infos, batches, [&](FakeJni &env) {
+    makeGameInfoArrayVector(&env, gameInfo, constructor, infos);
+  });
+  const auto after = measure(infos, batches, [&](FakeJni &env) {
+    makeGameInfoArray(&env, gameInfo, constructor, infos);
+  });
+
+  std::printf("%zu entries per batch, %zu batches\n", entries, batches);
+  std::printf("std::vector:       %7.1f ns/entry  %5.2f calls/entry  peak "
+              "%zu local refs\n",
+              before.nsPerEntry, before.callsPerEntry, before.peakRefs);
+  std::printf("makeGameInfoArray: %7.1f ns/entry  %5.2f calls/entry  peak "
+              "%zu local refs\n",
+              after.nsPerEntry, after.callsPerEntry, after.peakRefs);
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include "fake_jni.h"
+#include "jni_marshal.h"
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<GameInfo> makeInfos(usz count) {
+  std::vector<GameInfo> infos;
+
+  for (usz i = 0; i < count; i++) {
+    infos.push_back({.path = "/games/BLES" + std::to_string(i),
+                     .name = "Game " + std::to_string(i),
+                     .iconPath = i % 3 ? "/icons/" + std::to_string(i) : ""});
+  }
+
+  return infos;
+}
+
+void testGameInfoArray() {
+  FakeJni env;
+  const auto infos = makeInfos(5000);
+
+  // sendGameInfo runs inside a frame of its own
+  env.PushLocalFrame(8);
+  const jobjectArray array = makeGameInfoArray(
+      &env, FakeJni::fakeClass(), FakeJni::constructor(3), infos);
+
+  // The array plus the references of one entry, whatever the batch size
+  CHECK(env.peakRefs() <= 1 + 4);
+  CHECK(env.liveRefs() == 1);
+
+  const auto *result = env.object(array);
+  CHECK(result && result->references.size() == infos.size());
+
+  for (usz i = 0; result && i < infos.size(); i++) {
+    const auto &info = env.objectAt(result->references[i]);
+    CHECK(info.kind == FakeJni::Object::Kind::instance);
+    CHECK(info.references.size() == 3);
+
+    if (info.references.size() == 3) {
+      CHECK(env.objectAt(info.references[0]).text == infos[i].path);
+      CHECK(env.objectAt(info.references[1]).text == infos[i].name);
+      CHECK(env.objectAt(info.references[2]).text == infos[i].iconPath);
+    }
+  }
+
+  env.PopLocalFrame(nullptr);
+  CHECK(env.liveRefs() == 0);
+  CHECK(env.errors() == 0);
+}
+
+void testStringArray() {
+  FakeJni env;
+  const std::vector<std::string> strings = {"/games/a", "", "/games/c"};
+
+  env.PushLocalFrame(4);
+  const jobjectArray array =
+      makeStringArray(&env, FakeJni::fakeClass(), strings);
+  CHECK(env.peakRefs() <= 2 && env.liveRefs() == 1);
+
+  const auto *result = env.object(array);
+  CHECK(result && result->references.size() == strings.size());
+
+  for (usz i = 0; result && i < strings.size(); i++) {
+    CHECK(env.objectAt(result->references[i]).text == strings[i]);
+  }
+
+  env.PopLocalFrame(nullptr);
+  CHECK(env.errors() == 0);
+
+  // An empty batch still makes an array
+  env.reset();
+  CHECK(env.object(makeStringArray(&env, FakeJni::fakeClass(), {})) !=
+        nullptr);
+}
+} // namespace
+
+int main() {
+  testGameInfoArray();
+  testStringArray();
+  return testResult();
+}
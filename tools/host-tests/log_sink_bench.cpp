@@ -0,0 +1,119 @@
+// Compares the latency of a log call on an emulator thread when it writes to
+// logcat synchronously, as LogListener did, with AndroidLogSink.
+// Usage: log_sink_bench [logd latency in us] [messages per burst]
+//
+// logd is simulated by a write to /dev/null followed by a busy wait, a
+// socket write to logd takes tens of microseconds on a phone.
+
+#include "android_log_sink.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+int g_null_fd = -1;
+std::chrono::nanoseconds g_logd_latency{};
+
+using Clock = std::chrono::steady_clock;
+
+void simulateLogd(const char *text) {
+  const auto start = Clock::now();
+  [[maybe_unused]] auto written = ::write(g_null_fd, text, std::strlen(text));
+
+  while (Clock::now() - start < g_logd_latency) {
+  }
+}
+
+// The listener before AndroidLogSink
+class SyncLogListener final : public logs::listener {
+public:
+  void log(u64, const logs::message &msg, const std::string &,
+           const std::string &text) override {
+    __android_log_write(msg == logs::level::error ? ANDROID_LOG_ERROR
+                                                  : ANDROID_LOG_WARN,
+                        "RPCS3", text.c_str());
+  }
+};
+
+struct Result {
+  double p50;
+  double p99;
+  double max;
+};
+
+// A burst of messages from one hot thread, as during a shader compile storm,
+// with a pause in between so the sink can drain
+Result measure(logs::listener &listener, usz bursts, usz burstSize) {
+  const std::string text =
+      "RSX: Shader cache miss, compiling fragment program 0x1234abcd";
+  const logs::message msg{logs::level::warning};
+  std::vector<double> latencies;
+  latencies.reserve(bursts * burstSize);
+
+  for (usz burst = 0; burst < bursts; burst++) {
+    for (usz i = 0; i < burstSize; i++) {
+      const auto start = Clock::now();
+      listener.log(0, msg, {}, text);
+      latencies.push_back(
+          std::chrono::duration<double, std::micro>(Clock::now() - start)
+              .count());
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  return {latencies[latencies.size() / 2],
+          latencies[latencies.size() * 99 / 100], latencies.back()};
+}
+} // namespace
+
+extern "C" int __android_log_write(int, const char *, const char *text) {
+  simulateLogd(text);
+  return 1;
+}
+
+extern "C" int __android_log_print(int, const char *, const char *fmt, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, fmt);
+  std::vsnprintf(text, sizeof(text), fmt, args);
+  va_end(args);
+  simulateLogd(text);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  g_null_fd = ::open("/dev/null", O_WRONLY);
+  g_logd_latency = std::chrono::microseconds(
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 30);
+  const usz burstSize = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+  const usz bursts = 50;
+
+  SyncLogListener syncListener;
+  AndroidLogSink sink;
+
+  const auto sync = measure(syncListener, bursts, burstSize);
+  const auto async = measure(sink, bursts, burstSize);
+
+  std::printf("logd %lld us, %zu messages per burst\n",
+              static_cast<long long>(g_logd_latency.count() / 1000),
+              burstSize);
+  std::printf("synchronous:    p50 %7.2f us  p99 %7.2f us  max %8.2f us\n",
+              sync.p50, sync.p99, sync.max);
+  std::printf("AndroidLogSink: p50 %7.2f us  p99 %7.2f us  max %8.2f us, "
+              "%llu dropped, %llu truncated\n",
+              async.p50, async.p99, async.max,
+              static_cast<unsigned long long>(sink.dropped()),
+              static_cast<unsigned long long>(sink.truncated()));
+  return 0;
+}
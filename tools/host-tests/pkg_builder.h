@@ -0,0 +1,179 @@
+#pragma once
+
+// Builds synthetic PKG files for the PKG mount test and benchmark, with the
+// layout and keystreams package_reader expects
+
+#include "Crypto/aes.h"
+#include "Crypto/key_vault.h"
+#include "Crypto/sha1.h"
+#include "Crypto/unpkg.h"
+#include "util/types.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct PkgSource {
+  std::string name;
+  bool directory = false;
+  bool psp = false;
+  std::vector<u8> data = {};
+};
+
+struct PkgOptions {
+  bool debug = false;
+  bool pspPlatform = false;
+  std::string contentId = "UP0000-BLES00000_00-0000000000000000";
+};
+
+inline std::vector<u8> randomBytes(usz size, u64 seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<u8> data(size);
+
+  for (auto &byte : data) {
+    byte = static_cast<u8>(rng());
+  }
+
+  return data;
+}
+
+namespace pkg_builder {
+inline void putBe(u8 *out, u64 value, int size) {
+  for (int i = 0; i < size; i++) {
+    out[i] = static_cast<u8>(value >> (8 * (size - 1 - i)));
+  }
+}
+
+// Encryption and decryption are the same XOR with the keystream
+inline void crypt(const PkgOptions &options, const u8 *qaDigest,
+                  const u8 *klicensee, bool psp, u64 offset, u8 *data,
+                  u64 size) {
+  aes_context key;
+  aes_setkey_enc(&key, psp ? PKG_AES_KEY2 : PKG_AES_KEY, 128);
+
+  for (u64 pos = 0; pos < size; pos += 16) {
+    const u64 index = (offset + pos) / 16;
+    u8 keystream[20];
+
+    if (options.debug) {
+      u8 input[64]{};
+      std::memcpy(input + 0, qaDigest, 8);
+      std::memcpy(input + 8, qaDigest, 8);
+      std::memcpy(input + 16, qaDigest + 8, 8);
+      std::memcpy(input + 24, qaDigest + 8, 8);
+      putBe(input + 56, index, 8);
+      sha1(input, sizeof(input), keystream);
+    } else {
+      // The 128-bit big-endian counter starts at the klicensee
+      u8 counter[16];
+      std::memcpy(counter, klicensee, 16);
+
+      u64 add = index;
+      unsigned carry = 0;
+      for (int i = 15; i >= 0; i--) {
+        const unsigned sum = counter[i] + (add & 0xff) + carry;
+        counter[i] = static_cast<u8>(sum);
+        carry = sum >> 8;
+        add >>= 8;
+      }
+
+      aes_crypt_ecb(&key, AES_ENCRYPT, counter, keystream);
+    }
+
+    for (u64 i = 0; i < 16 && pos + i < size; i++) {
+      data[pos + i] ^= keystream[i];
+    }
+  }
+}
+} // namespace pkg_builder
+
+// Writes a package with the given entries to path. Names and data are 16
+// byte aligned, like in official packages
+inline bool buildPkg(const std::string &path,
+                     const std::vector<PkgSource> &sources,
+                     const PkgOptions &options = {}) {
+  using pkg_builder::putBe;
+
+  const u64 count = sources.size();
+  u64 pos = count * sizeof(PKGEntry);
+  std::vector<u64> nameOffsets;
+  std::vector<u64> dataOffsets;
+
+  for (auto &source : sources) {
+    nameOffsets.push_back(pos);
+    pos += (source.name.size() + 15) & ~u64{15};
+  }
+
+  for (auto &source : sources) {
+    dataOffsets.push_back(pos);
+    pos += (source.data.size() + 15) & ~u64{15};
+  }
+
+  std::vector<u8> data(pos);
+
+  for (u64 i = 0; i < count; i++) {
+    const auto &source = sources[i];
+    u8 *entry = data.data() + i * sizeof(PKGEntry);
+    const u32 type =
+        (source.directory ? PKG_FILE_ENTRY_FOLDER : PKG_FILE_ENTRY_REGULAR) |
+        (source.psp ? u32{PKG_FILE_ENTRY_PSP} : 0u);
+
+    putBe(entry, nameOffsets[i], 4);
+    putBe(entry + 4, source.name.size(), 4);
+    putBe(entry + 8, dataOffsets[i], 8);
+    putBe(entry + 16, source.data.size(), 8);
+    putBe(entry + 24, type, 4);
+
+    std::copy(source.name.begin(), source.name.end(),
+              data.begin() + nameOffsets[i]);
+    std::copy(source.data.begin(), source.data.end(),
+              data.begin() + dataOffsets[i]);
+  }
+
+  // The last bytes of the klicensee carry into the upper half of the counter
+  u8 qaDigest[16];
+  u8 klicensee[16];
+  for (int i = 0; i < 16; i++) {
+    qaDigest[i] = static_cast<u8>(i * 7 + 1);
+    klicensee[i] = i < 14 ? static_cast<u8>(0xf0 + i) : 0xff;
+  }
+
+  pkg_builder::crypt(options, qaDigest, klicensee, options.pspPlatform, 0,
+                     data.data(), count * sizeof(PKGEntry));
+
+  for (u64 i = 0; i < count; i++) {
+    const auto &source = sources[i];
+    pkg_builder::crypt(options, qaDigest, klicensee, source.psp,
+                       nameOffsets[i], data.data() + nameOffsets[i],
+                       source.name.size());
+    pkg_builder::crypt(options, qaDigest, klicensee, source.psp,
+                       dataOffsets[i], data.data() + dataOffsets[i],
+                       source.data.size());
+  }
+
+  constexpr u64 kHeaderSize = 0xC0;
+  std::vector<u8> header(kHeaderSize);
+  putBe(&header[0], 0x7F504B47, 4);
+  putBe(&header[4],
+        options.debug ? PKG_RELEASE_TYPE_DEBUG : PKG_RELEASE_TYPE_RELEASE, 2);
+  putBe(&header[6],
+        options.pspPlatform ? PKG_PLATFORM_TYPE_PSP_PSVITA
+                            : PKG_PLATFORM_TYPE_PS3,
+        2);
+  putBe(&header[20], count, 4);
+  putBe(&header[24], kHeaderSize + data.size(), 8);
+  putBe(&header[32], kHeaderSize, 8);
+  putBe(&header[40], data.size(), 8);
+  std::memcpy(&header[48], options.contentId.data(),
+              std::min<usz>(options.contentId.size(), 48));
+  std::memcpy(&header[96], qaDigest, 16);
+  std::memcpy(&header[112], klicensee, 16);
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(header.data()), header.size());
+  out.write(reinterpret_cast<const char *>(data.data()), data.size());
+  return static_cast<bool>(out);
+}
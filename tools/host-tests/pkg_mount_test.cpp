@@ -0,0 +1,190 @@
+#include "pkg_builder.h"
+#include "pkg_mount.h"
+#include "test.h"
+
+#include <filesystem>
+
+namespace {
+std::vector<PkgSource> gameSources() {
+  return {
+      {.name = "PARAM.SFO", .data = randomBytes(100, 1)},
+      {.name = "ICON0.PNG", .data = randomBytes(3000, 2)},
+      {.name = "USRDIR", .directory = true},
+      {.name = "USRDIR/EBOOT.BIN", .data = randomBytes(70001, 3)},
+      {.name = "USRDIR/data", .directory = true},
+      {.name = "USRDIR/data/big.dat", .data = randomBytes(300000, 4)},
+      {.name = "USRDIR/empty"},
+      {.name = "USRDIR/psp.bin", .psp = true, .data = randomBytes(5000, 5)},
+  };
+}
+
+std::shared_ptr<PkgDevice> mountPkg(const std::string &path) {
+  const auto archive = PkgArchive::open(fs::file(path), 4);
+  CHECK(archive != nullptr);
+
+  if (!archive) {
+    return nullptr;
+  }
+
+  auto device = std::make_shared<PkgDevice>(archive);
+  ArchiveDevice::mount(device);
+  return device;
+}
+
+// Every file reads back whole and at random offsets, through the VFS
+void checkContents(const std::shared_ptr<PkgDevice> &device,
+                   const std::vector<PkgSource> &sources) {
+  const std::string root = device->root();
+  std::mt19937_64 rng(42);
+
+  for (auto &source : sources) {
+    fs::stat_t info{};
+    CHECK(device->stat(root + source.name, info));
+    CHECK(info.is_directory == source.directory);
+
+    if (source.directory) {
+      continue;
+    }
+
+    CHECK(info.size == source.data.size());
+
+    const auto file = device->open(root + source.name, fs::read);
+    CHECK(file != nullptr);
+
+    if (!file) {
+      continue;
+    }
+
+    std::vector<u8> contents(source.data.size());
+    CHECK(file->read(contents.data(), contents.size()) == contents.size());
+    CHECK(contents == source.data);
+
+    for (int i = 0; i < 200 && !source.data.empty(); i++) {
+      const u64 offset = rng() % source.data.size();
+      const u64 size = rng() % 40000;
+      std::vector<u8> buffer(size);
+
+      const u64 read = file->read_at(offset, buffer.data(), size);
+      CHECK(read == std::min(size, source.data.size() - offset));
+      CHECK(std::equal(buffer.begin(), buffer.begin() + read,
+                       source.data.begin() + offset));
+    }
+  }
+}
+
+void testPackage(const std::filesystem::path &base, const PkgOptions &options) {
+  const auto sources = gameSources();
+  const auto path = (base / "game.pkg").string();
+  CHECK(buildPkg(path, sources, options));
+
+  const auto device = mountPkg(path);
+  if (!device) {
+    return;
+  }
+
+  const auto &archive = device->archive();
+  CHECK(archive->contentId() == options.contentId);
+  CHECK(archive->entries().size() == sources.size());
+
+  for (usz i = 0; i < sources.size() && i < archive->entries().size(); i++) {
+    CHECK(archive->entries()[i].name == sources[i].name);
+    CHECK(archive->entries()[i].psp == sources[i].psp);
+  }
+
+  checkContents(device, sources);
+
+  // Small reads went through the cache
+  const auto stats = archive->cacheStats();
+  CHECK(stats.hits > 0 && stats.misses > 0);
+
+  // A memory trim drops whole blocks, the cache never exceeds its capacity
+  const u64 cached = archive->cacheMemory();
+  CHECK(cached > 0 && cached <= 4 * PkgArchive::kBlockSize);
+
+  const u64 freed = archive->trimCache(1);
+  CHECK(freed > 0 && archive->cacheMemory() == cached - freed);
+  CHECK(archive->trimCache(UINT64_MAX) == cached - freed);
+  CHECK(archive->cacheMemory() == 0);
+
+  // and reads fill it again
+  checkContents(device, sources);
+  CHECK(archive->cacheMemory() > 0);
+}
+
+void testDevice(const std::filesystem::path &base) {
+  const auto sources = gameSources();
+  const auto path = (base / "device.pkg").string();
+  CHECK(buildPkg(path, sources));
+
+  const auto device = mountPkg(path);
+  if (!device) {
+    return;
+  }
+
+  const std::string root = device->root();
+  CHECK(fs::get_virtual_device(root + "PARAM.SFO") == device);
+
+  fs::stat_t info{};
+  CHECK(device->stat(root, info) && info.is_directory);
+  CHECK(device->stat(root + "USRDIR//./data/../EBOOT.BIN", info) &&
+        info.size == 70001);
+  CHECK(!device->stat(root + "missing", info));
+  CHECK(fs::g_tls_error == fs::error::noent);
+
+  // Read-only
+  CHECK(device->open(root + "PARAM.SFO", fs::write) == nullptr);
+  CHECK(fs::g_tls_error == fs::error::readonly);
+  CHECK(device->open(root + "USRDIR", fs::read) == nullptr);
+  CHECK(fs::g_tls_error == fs::error::isdir);
+
+  const auto dir = device->open_dir(root + "USRDIR");
+  CHECK(dir != nullptr);
+
+  std::vector<std::string> names;
+  fs::dir_entry entry;
+  while (dir && dir->read(entry)) {
+    names.push_back(entry.name);
+  }
+
+  CHECK((names == std::vector<std::string>{".", "..", "EBOOT.BIN", "data",
+                                           "empty", "psp.bin"}));
+
+  const auto file = device->open(root + "USRDIR/EBOOT.BIN", fs::read);
+  CHECK(file && file->seek(-1, fs::seek_set) == static_cast<u64>(-1));
+}
+
+void testInvalid(const std::filesystem::path &base) {
+  const auto path = (base / "invalid.pkg").string();
+
+  // Not a PKG
+  std::ofstream(path, std::ios::binary) << std::string(0x200, 'x');
+  CHECK(PkgArchive::open(fs::file(path)) == nullptr);
+
+  // Truncated in the data area
+  CHECK(buildPkg(path, gameSources()));
+  std::filesystem::resize_file(path, 0x1000);
+  CHECK(PkgArchive::open(fs::file(path)) == nullptr);
+
+  CHECK(PkgArchive::open(fs::file((base / "missing.pkg").string())) ==
+        nullptr);
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/pkg_mount_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+
+  testPackage(base, {});
+  testPackage(base, {.debug = true});
+
+  // Only the entry table of a PSP package uses the PSP key, entries without
+  // PKG_FILE_ENTRY_PSP still use the PS3 one
+  testPackage(base, {.pspPlatform = true,
+                     .contentId = "UP0000-NPUZ00000_00-0000000000000000"});
+
+  testDevice(base);
+  testInvalid(base);
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Helpers for the game scanner test and benchmark: synthetic library trees
+// and the serial reference scan the worker scan has to match
+
+#include "disc_image_format.h"
+#include "util/types.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+inline void writeFile(const std::filesystem::path &path,
+                      const std::string &contents = "PSF") {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path, std::ios::binary) << contents;
+}
+
+// A recursive_directory_iterator walk which stops below game roots, like the
+// scan did before it was spread over workers
+inline std::set<std::string>
+serialScan(const std::vector<std::string> &rootDirs) {
+  std::set<std::string> paths;
+
+  for (auto &rootDir : rootDirs) {
+    std::error_code ec;
+
+    for (std::filesystem::recursive_directory_iterator it(rootDir, ec), end;
+         !ec && it != end; it.increment(ec)) {
+      std::error_code entry_ec;
+
+      if (!it->is_directory(entry_ec)) {
+        if (it->path().extension() == discimg::kExtension &&
+            std::filesystem::is_regular_file(it->path(), entry_ec)) {
+          paths.insert(it->path().string());
+        }
+
+        continue;
+      }
+
+      if (std::filesystem::is_regular_file(it->path() / "PARAM.SFO",
+                                           entry_ec)) {
+        paths.insert(it->path().string());
+        it.disable_recursion_pending();
+      }
+    }
+  }
+
+  return paths;
+}
+
+// A library of directories spread over depth levels below root, every
+// gameEvery-th directory is a game with a few files of its own. Returns the
+// number of games.
+inline usz makeLibrary(const std::filesystem::path &root, usz directories,
+                       usz depth, usz gameEvery) {
+  usz games = 0;
+  std::vector<std::vector<std::filesystem::path>> levels{{root}};
+
+  for (usz i = 0; i < directories; i++) {
+    const usz level = std::min(i % depth, levels.size() - 1);
+    const auto &parents = levels[level];
+    const auto dir =
+        parents[i % parents.size()] / ("dir" + std::to_string(i));
+
+    if (i % gameEvery == 0) {
+      writeFile(dir / "PARAM.SFO");
+      writeFile(dir / "USRDIR" / "EBOOT.BIN");
+      games++;
+      continue;
+    }
+
+    writeFile(dir / "readme.txt");
+
+    if (levels.size() == level + 1) {
+      levels.emplace_back();
+    }
+
+    levels[level + 1].push_back(dir);
+  }
+
+  return games;
+}
@@ -0,0 +1,155 @@
+#include "surface_manager.h"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+// Mock window, metrics are read through the NDK functions below
+struct ANativeWindow {
+  s32 width;
+  s32 height;
+  s32 format;
+  std::atomic<int> references = 1;
+};
+
+int32_t ANativeWindow_getWidth(ANativeWindow *window) { return window->width; }
+int32_t ANativeWindow_getHeight(ANativeWindow *window) {
+  return window->height;
+}
+int32_t ANativeWindow_getFormat(ANativeWindow *window) {
+  return window->format;
+}
+void ANativeWindow_release(ANativeWindow *window) { window->references--; }
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double threadCpuMs() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+// A thread blocked in wait() must sleep, not spin, and wake promptly once a
+// window arrives
+void testWakeLatency() {
+  constexpr int kRuns = 20;
+  double worstUs = 0;
+  double totalUs = 0;
+
+  for (int run = 0; run < kRuns; run++) {
+    SurfaceManager surface;
+    ANativeWindow window{.width = 1920, .height = 1080, .format = 1};
+    std::atomic<Clock::time_point> woken;
+    double waiterCpuMs = 0;
+
+    std::thread waiter([&] {
+      const double cpuStart = threadCpuMs();
+      const auto state = surface.wait();
+      woken = Clock::now();
+      waiterCpuMs = threadCpuMs() - cpuStart;
+      CHECK(state.window == &window && state.width == 1920);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto created = Clock::now();
+    surface.onCreated(&window);
+    waiter.join();
+
+    const double latencyUs =
+        std::chrono::duration<double, std::micro>(woken.load() - created)
+            .count();
+    worstUs = std::max(worstUs, latencyUs);
+    totalUs += latencyUs;
+
+    // 50 ms of waiting costs next to no CPU time
+    CHECK(waiterCpuMs < 5);
+
+    surface.onLost();
+    CHECK(window.references == 0);
+  }
+
+  std::printf("wake latency: mean %.1f us, worst %.1f us\n", totalUs / kRuns,
+              worstUs);
+  CHECK(worstUs < 50'000);
+}
+
+void testEvents() {
+  SurfaceManager surface;
+  ANativeWindow first{.width = 1280, .height = 720, .format = 1};
+  ANativeWindow second{.width = 1280, .height = 720, .format = 1};
+
+  std::vector<std::pair<SurfaceManager::Event, u64>> events;
+  surface.addListener(
+      [&](SurfaceManager::Event event, const SurfaceManager::State &state) {
+        // A lost window is still valid while listeners run
+        CHECK(state.window != nullptr && state.window->references == 1);
+        events.emplace_back(event, state.generation);
+      });
+
+  surface.onChanged();
+  surface.onLost();
+  CHECK(events.empty());
+
+  surface.onCreated(&first);
+  surface.onChanged();
+
+  // Only a real change of the metrics is an event
+  first.width = 1920;
+  surface.onChanged();
+  CHECK(surface.state().width == 1920);
+
+  // A new window without a lost event replaces the stale one
+  surface.onCreated(&second);
+  CHECK(first.references == 0);
+
+  surface.onLost();
+  CHECK(second.references == 0);
+  CHECK(surface.state().window == nullptr);
+
+  using Event = SurfaceManager::Event;
+  CHECK((events == std::vector<std::pair<Event, u64>>{{Event::created, 1},
+                                                      {Event::changed, 2},
+                                                      {Event::created, 3},
+                                                      {Event::lost, 3}}));
+}
+
+// Emulation is resumed once the renderer took the new window
+void testAcquire() {
+  SurfaceManager surface;
+  ANativeWindow window{.width = 1280, .height = 720, .format = 1};
+
+  surface.onCreated(&window);
+  const u64 generation = surface.state().generation;
+  CHECK(!surface.waitAcquired(generation, std::chrono::milliseconds(10)));
+
+  std::thread renderer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(surface.acquire().window == &window);
+  });
+
+  CHECK(surface.waitAcquired(generation, std::chrono::seconds(5)));
+  renderer.join();
+
+  // A window which replaced the acquired one has to be acquired again
+  surface.onLost();
+  window.references = 1;
+  surface.onCreated(&window);
+  CHECK(!surface.waitAcquired(surface.state().generation,
+                              std::chrono::milliseconds(10)));
+  surface.acquire();
+  CHECK(surface.waitAcquired(surface.state().generation,
+                             std::chrono::milliseconds(10)));
+  surface.onLost();
+}
+} // namespace
+
+int main() {
+  testWakeLatency();
+  testEvents();
+  testAcquire();
+  return testResult();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Every test is its own executable, run by ctest. CHECK records a failure
+// and carries on, so one run reports everything that broke.
+
+#include <cstdio>
+
+inline int g_test_failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,    \
+                   #condition);                                                \
+      g_test_failures++;                                                       \
+    }                                                                          \
+  } while (false)
+
+inline int testResult() {
+  if (g_test_failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", g_test_failures);
+    return 1;
+  }
+
+  return 0;
+}
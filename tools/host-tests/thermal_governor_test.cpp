@@ -0,0 +1,283 @@
+#include "thermal_governor.h"
+#include "test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+constexpr u64 kSecond = 1'000'000'000;
+
+// Controller without smoothing, so every sample of a trace is taken as is
+ThermalController::Config unsmoothed() {
+  ThermalController::Config config;
+  config.smoothing = 1;
+  return config;
+}
+
+void testLevelsGoUp() {
+  ThermalController controller(unsmoothed());
+
+  CHECK(!controller.update(0, {.temperature = 60}));
+  CHECK(controller.level() == ThermalLevel::nominal);
+  CHECK(controller.tunables() == ThermalTunables{});
+
+  // Straight to the level of the sample, skipping the ones in between
+  CHECK(controller.update(kSecond, {.temperature = 85}));
+  CHECK(controller.level() == ThermalLevel::hot);
+  CHECK(controller.tunables().frameLimit == 30);
+
+  CHECK(controller.update(2 * kSecond, {.temperature = 91}));
+  CHECK(controller.level() == ThermalLevel::critical);
+  CHECK(controller.tunables().spuThreads == 2);
+
+  // The kernel capping the clocks counts even while the sensors read cool
+  ThermalController capped(unsmoothed());
+  CHECK(capped.update(0, {.temperature = 50, .freqCap = 0.8}));
+  CHECK(capped.level() == ThermalLevel::hot);
+  CHECK(capped.update(kSecond, {.temperature = 50, .freqCap = 0.5}));
+  CHECK(capped.level() == ThermalLevel::critical);
+}
+
+void testHysteresis() {
+  ThermalController controller(unsmoothed());
+  CHECK(controller.update(0, {.temperature = 71}));
+  CHECK(controller.level() == ThermalLevel::warm);
+
+  // Hovering around the threshold, but never below it minus the hysteresis
+  u64 now = 0;
+  for (const f64 temperature : {68, 71, 66, 72, 69, 67, 70, 66}) {
+    for (int i = 0; i < 10; i++) {
+      now += 5 * kSecond;
+      CHECK(!controller.update(now, {.temperature = temperature}));
+    }
+  }
+
+  CHECK(controller.level() == ThermalLevel::warm);
+
+  // Same for a cap hovering around hotFreqCap
+  ThermalController capped(unsmoothed());
+  CHECK(capped.update(0, {.temperature = 50, .freqCap = 0.85}));
+
+  now = 0;
+  for (const f64 freqCap : {0.88, 0.85, 0.89, 0.86}) {
+    for (int i = 0; i < 10; i++) {
+      now += 5 * kSecond;
+      CHECK(!capped.update(now, {.temperature = 50, .freqCap = freqCap}));
+    }
+  }
+
+  CHECK(capped.level() == ThermalLevel::hot);
+}
+
+void testCooldown() {
+  ThermalController controller(unsmoothed());
+  CHECK(controller.update(0, {.temperature = 95}));
+  CHECK(controller.level() == ThermalLevel::critical);
+
+  // Cool enough for warm, but the first cooldown only steps down to hot
+  u64 now = kSecond;
+  CHECK(!controller.update(now, {.temperature = 70}));
+  CHECK(!controller.update(now + 29 * kSecond, {.temperature = 70}));
+  CHECK(controller.level() == ThermalLevel::critical);
+
+  now += 30 * kSecond;
+  CHECK(controller.update(now, {.temperature = 70}));
+  CHECK(controller.level() == ThermalLevel::hot);
+
+  // The next step needs a cooldown of its own
+  CHECK(!controller.update(now + kSecond, {.temperature = 70}));
+  CHECK(!controller.update(now + 29 * kSecond, {.temperature = 70}));
+  CHECK(controller.level() == ThermalLevel::hot);
+
+  now += 30 * kSecond;
+  CHECK(controller.update(now, {.temperature = 70}));
+  CHECK(controller.level() == ThermalLevel::warm);
+
+  // Within the hysteresis of warm, stays there
+  for (int i = 0; i < 10; i++) {
+    now += 10 * kSecond;
+    CHECK(!controller.update(now, {.temperature = 70}));
+  }
+
+  // A sample above threshold minus hysteresis restarts the cooldown
+  CHECK(!controller.update(now += kSecond, {.temperature = 60}));
+  CHECK(!controller.update(now += 20 * kSecond, {.temperature = 60}));
+  CHECK(!controller.update(now += kSecond, {.temperature = 66}));
+  CHECK(!controller.update(now += kSecond, {.temperature = 60}));
+  CHECK(!controller.update(now += 29 * kSecond, {.temperature = 60}));
+  CHECK(controller.level() == ThermalLevel::warm);
+
+  CHECK(controller.update(now += kSecond, {.temperature = 60}));
+  CHECK(controller.level() == ThermalLevel::nominal);
+}
+
+void testSmoothing() {
+  ThermalController controller;
+  CHECK(!controller.update(0, {.temperature = 60}));
+
+  // A single hot spot is averaged out
+  CHECK(controller.update(kSecond, {.temperature = 95}));
+  CHECK(controller.level() == ThermalLevel::warm);
+  CHECK(controller.temperature() < 71);
+
+  // A sustained one is not
+  u64 now = kSecond;
+  for (int i = 0; i < 20; i++) {
+    controller.update(now += kSecond, {.temperature = 95});
+  }
+
+  CHECK(controller.level() == ThermalLevel::critical);
+}
+
+struct FakeZone {
+  std::string type;
+  s64 temp;
+};
+
+struct FakePolicy {
+  u64 cap;
+  u64 max;
+};
+
+void makeSysfs(const std::filesystem::path &root,
+               const std::vector<FakeZone> &zones,
+               const std::vector<FakePolicy> &policies) {
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "thermal");
+  std::filesystem::create_directories(root / "cpufreq");
+
+  // Siblings of the zones on a real system
+  std::filesystem::create_directories(root / "thermal" / "cooling_device0");
+
+  for (usz i = 0; i < zones.size(); i++) {
+    const auto dir = root / "thermal" / ("thermal_zone" + std::to_string(i));
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "type") << zones[i].type << "\n";
+    std::ofstream(dir / "temp") << zones[i].temp << "\n";
+  }
+
+  for (usz i = 0; i < policies.size(); i++) {
+    const auto dir = root / "cpufreq" / ("policy" + std::to_string(i * 4));
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "scaling_max_freq") << policies[i].cap << "\n";
+    std::ofstream(dir / "cpuinfo_max_freq") << policies[i].max << "\n";
+  }
+}
+
+ThermalSensor sensorAt(const std::filesystem::path &root) {
+  return ThermalSensor((root / "thermal").string(),
+                       (root / "cpufreq").string());
+}
+
+void testSensor(const std::filesystem::path &base) {
+  // Battery zones are ignored, disabled CPU zones skipped
+  makeSysfs(base / "soc",
+            {{"battery", 98000},
+             {"cpu-1-0-usr", 65000},
+             {"cpuss-0", 72500},
+             {"cpu-1-1-usr", 0}},
+            {{1'800'000, 1'800'000}, {2'000'000, 2'500'000}});
+
+  const auto sensor = sensorAt(base / "soc");
+  CHECK(sensor.zoneCount() == 3);
+
+  const auto sample = sensor.read();
+  CHECK(sample.has_value());
+
+  if (sample) {
+    CHECK(sample->temperature == 72.5);
+    CHECK(sample->freqCap == 0.8);
+  }
+
+  // Degrees instead of millidegrees, and no cpufreq at all
+  makeSysfs(base / "degrees", {{"mtktscpu", 64}}, {});
+  const auto degrees = sensorAt(base / "degrees").read();
+  CHECK(degrees && degrees->temperature == 64 && degrees->freqCap == 1);
+
+  // Only anonymous zones, the hottest one is used
+  makeSysfs(base / "anonymous", {{"tz0", 41000}, {"tz1", 55000}}, {});
+  const auto anonymous = sensorAt(base / "anonymous");
+  CHECK(anonymous.zoneCount() == 2);
+  CHECK(anonymous.read() && anonymous.read()->temperature == 55);
+
+  CHECK(!sensorAt(base / "missing").read());
+}
+
+void testGovernorPause(const std::filesystem::path &base) {
+  const auto root = base / "governor";
+  makeSysfs(root, {{"cpu-0", 50000}}, {});
+
+  auto config = unsmoothed();
+  config.cooldownNs = 0;
+
+  std::mutex appliedMutex;
+  std::vector<ThermalTunables> applied;
+
+  ThermalGovernor governor;
+  governor.start(
+      sensorAt(root), ThermalController(config),
+      [&](const ThermalTunables &tunables) {
+        std::lock_guard lock(appliedMutex);
+        applied.push_back(tunables);
+      },
+      std::chrono::milliseconds(1));
+
+  const auto setTemperature = [&](s64 millidegrees) {
+    std::ofstream(root / "thermal" / "thermal_zone0" / "temp")
+        << millidegrees << "\n";
+  };
+
+  const auto waitForLevel = [&](ThermalLevel level) {
+    for (int i = 0; i < 1000 && governor.level() != level; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return governor.level() == level;
+  };
+
+  const auto appliedCount = [&] {
+    std::lock_guard lock(appliedMutex);
+    return applied.size();
+  };
+
+  // Tracked while paused, but nothing is applied until resume()
+  governor.pause();
+  setTemperature(95000);
+  CHECK(waitForLevel(ThermalLevel::critical));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CHECK(appliedCount() == 0);
+
+  governor.resume();
+  CHECK(appliedCount() == 1);
+
+  setTemperature(50000);
+  CHECK(waitForLevel(ThermalLevel::nominal));
+  governor.stop();
+
+  std::lock_guard lock(appliedMutex);
+  CHECK(!applied.empty() && applied.front() == config.tunables[3]);
+  CHECK(!applied.empty() && applied.back() == ThermalTunables{});
+
+  // Nothing to reapply at nominal
+  const auto count = applied.size();
+  governor.pause();
+  governor.resume();
+  CHECK(applied.size() == count);
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/thermal_governor_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+
+  testLevelsGoUp();
+  testHysteresis();
+  testCooldown();
+  testSmoothing();
+  testSensor(base);
+  testGovernorPause(base);
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
@@ -0,0 +1,205 @@
+#include "thread_affinity.h"
+#include "test.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+struct FakeCpu {
+  u32 id;
+  u32 capacity;
+  u64 maxFreqKhz;
+};
+
+// A sysfs cpu directory with the files CpuTopology reads, zero values are
+// left out like on kernels which do not export them
+std::string makeSysfs(const std::filesystem::path &root,
+                      const std::vector<FakeCpu> &cpus) {
+  std::filesystem::remove_all(root);
+
+  // Siblings of the cpuN directories on a real system
+  for (auto name : {"cpufreq", "cpuidle", "power", "cpu"}) {
+    std::filesystem::create_directories(root / name);
+  }
+
+  std::ofstream(root / "online") << "0-" << cpus.size() - 1;
+
+  for (auto &cpu : cpus) {
+    const auto dir = root / ("cpu" + std::to_string(cpu.id));
+    std::filesystem::create_directories(dir / "cpufreq");
+
+    if (cpu.capacity != 0) {
+      std::ofstream(dir / "cpu_capacity") << cpu.capacity << "\n";
+    }
+
+    if (cpu.maxFreqKhz != 0) {
+      std::ofstream(dir / "cpufreq" / "cpuinfo_max_freq")
+          << cpu.maxFreqKhz << "\n";
+    }
+  }
+
+  return root.string();
+}
+
+void testTopologies(const std::filesystem::path &base) {
+  // 4 little, 3 big and a prime core, listed out of order
+  const auto triCluster = CpuTopology::detect(
+      makeSysfs(base / "tri", {{7, 1024, 3'000'000},
+                               {0, 325, 1'800'000},
+                               {4, 870, 2'400'000},
+                               {1, 325, 1'800'000},
+                               {5, 870, 2'400'000},
+                               {2, 325, 1'800'000},
+                               {6, 870, 2'400'000},
+                               {3, 325, 1'800'000}}));
+
+  CHECK(triCluster.clusters().size() == 3);
+  CHECK(triCluster.cpuCount() == 8 && triCluster.mask() == 0xff);
+  CHECK(triCluster.isHeterogeneous());
+  CHECK(triCluster.toString() ==
+        "4x cap 325 1800 MHz, 3x cap 870 2400 MHz, 1x cap 1024 3000 MHz");
+
+  if (triCluster.clusters().size() == 3) {
+    CHECK(triCluster.clusters()[0].mask() == 0x0f);
+    CHECK(triCluster.clusters()[1].mask() == 0x70);
+    CHECK(triCluster.clusters()[2].mask() == 0x80);
+  }
+
+  const auto policy = AffinityPolicy::fromTopology(triCluster);
+  CHECK(policy.mask(ThreadRole::ppu) == 0xf0);
+  CHECK(policy.mask(ThreadRole::spu) == 0xf0);
+  CHECK(policy.mask(ThreadRole::rsx) == 0xf0);
+  CHECK(policy.mask(ThreadRole::compiler) == 0xff);
+  CHECK(policy.mask(ThreadRole::io) == 0x0f);
+  CHECK(policy.mask(ThreadRole::other) == 0xff);
+  CHECK(policy.toString() == "PPU: 4,5,6,7, SPU: 4,5,6,7, RSX: 4,5,6,7, "
+                             "Compiler: 0,1,2,3,4,5,6,7, I/O: 0,1,2,3, "
+                             "Other: 0,1,2,3,4,5,6,7");
+
+  // Without cpu_capacity the clusters are told apart by frequency
+  const auto noCapacity = CpuTopology::detect(makeSysfs(
+      base / "freq",
+      {{0, 0, 1'700'000}, {1, 0, 1'700'000}, {2, 0, 2'800'000},
+       {3, 0, 2'800'000}, {4, 0, 2'800'000}}));
+  CHECK(noCapacity.clusters().size() == 2);
+  CHECK(AffinityPolicy::fromTopology(noCapacity).mask(ThreadRole::spu) ==
+        0x1c);
+
+  // A single fast core is shared rather than queued on
+  const auto singleBig = CpuTopology::detect(
+      makeSysfs(base / "single",
+                {{0, 400, 0}, {1, 400, 0}, {2, 400, 0}, {3, 1024, 0}}));
+  CHECK(singleBig.isHeterogeneous());
+  const auto singlePolicy = AffinityPolicy::fromTopology(singleBig);
+  CHECK(singlePolicy.mask(ThreadRole::ppu) == 0);
+  CHECK(singlePolicy.mask(ThreadRole::io) == 0x07);
+
+  // Homogeneous CPUs are left alone
+  const auto homogeneous = CpuTopology::detect(makeSysfs(
+      base / "same",
+      {{0, 1024, 2'000'000}, {1, 1024, 2'000'000}, {2, 1024, 2'000'000}}));
+  CHECK(homogeneous.clusters().size() == 1 && !homogeneous.isHeterogeneous());
+  CHECK(AffinityPolicy::fromTopology(homogeneous).empty());
+
+  const auto missing = CpuTopology::detect((base / "missing").string());
+  CHECK(missing.clusters().empty() && missing.toString() == "unknown");
+  CHECK(AffinityPolicy::fromTopology(missing).empty());
+}
+
+void testRoles() {
+  CHECK(classifyThreadRole("PPU[0x1000000] ") == ThreadRole::ppu);
+  CHECK(classifyThreadRole("SPU[0x2000000] ") == ThreadRole::spu);
+  CHECK(classifyThreadRole("rsx::thread") == ThreadRole::rsx);
+  CHECK(classifyThreadRole("PPU Worker 1") == ThreadRole::compiler);
+  CHECK(classifyThreadRole("SPU Worker 0") == ThreadRole::compiler);
+  CHECK(classifyThreadRole("LLVM Compiler") == ThreadRole::compiler);
+  CHECK(classifyThreadRole("Log Sink") == ThreadRole::io);
+  CHECK(classifyThreadRole("cellFsAio") == ThreadRole::io);
+  CHECK(classifyThreadRole("RenderThread") == ThreadRole::other);
+}
+
+u64 processMask() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  sched_getaffinity(0, sizeof(set), &set);
+
+  u64 mask = 0;
+  for (u32 cpu = 0; cpu < 64; cpu++) {
+    if (CPU_ISSET(cpu, &set)) {
+      mask |= u64{1} << cpu;
+    }
+  }
+
+  return mask;
+}
+
+// Places this process' own threads, with masks the host allows
+void testPlacer() {
+  AffinityPolicy policy;
+  policy.masks.fill(processMask());
+
+  std::atomic<int> step = 0;
+  std::thread worker([&] {
+    pthread_setname_np(pthread_self(), "SPU[0x1] ");
+    step = 1;
+    step.notify_all();
+    step.wait(1);
+
+    // named_thread renames itself after it started
+    pthread_setname_np(pthread_self(), "SPU[0x1] T1");
+    step = 3;
+    step.notify_all();
+    step.wait(3);
+  });
+
+  step.wait(0);
+
+  // Started inactive, the placer thread leaves the scans to this test
+  ThreadPlacer placer;
+  placer.start(policy, std::chrono::milliseconds(1),
+               std::chrono::milliseconds(8));
+
+  // Gives the placer thread time to name itself, it would count as renamed
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK(placer.scan() >= 3);
+  CHECK(placer.scan() == 0);
+
+  step = 2;
+  step.notify_all();
+  step.wait(2);
+  CHECK(placer.scan() == 1);
+
+  step = 4;
+  step.notify_all();
+  worker.join();
+  CHECK(placer.scan() == 0);
+
+  // Activation, deactivation and stop return promptly
+  placer.activate();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  placer.deactivate();
+  placer.activate();
+  placer.stop();
+
+  ThreadPlacer idle;
+  idle.start(policy, std::chrono::milliseconds(1),
+             std::chrono::milliseconds(8));
+  idle.stop();
+}
+} // namespace
+
+int main() {
+  char tmpl[] = "/tmp/thread_affinity_test.XXXXXX";
+  const std::filesystem::path base = ::mkdtemp(tmpl);
+
+  testTopologies(base);
+  testRoles();
+  testPlacer();
+
+  std::filesystem::remove_all(base);
+  return testResult();
+}
@@ -0,0 +1,219 @@
+// Converts binary logs written by BinaryLogListener back to the RPCS3.log
+// text format.
+//
+// Usage: rpcs3-log-decoder [-o output] file...
+//
+// Files are decoded in the given order, so rotated logs should be passed
+// oldest first (RPCS3.3.blog RPCS3.2.blog RPCS3.1.blog RPCS3.blog).
+
+#include "binary_log_format.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+// Same values as logs::level
+const char *const kLevelPrefix[] = {
+    "·A ", "·F ", "·E ", "·U ", "·S ", "·W ", "·! ", "·T ",
+};
+
+constexpr std::uint8_t kLevelTodo = 3;
+
+bool readFile(const char *path, std::vector<std::uint8_t> &data) {
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return false;
+  }
+
+  data.assign(std::istreambuf_iterator<char>(stream),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Inflates as much as possible, a log which was not closed properly ends
+// after the last sync flush
+bool inflateAll(const std::uint8_t *data, std::size_t size,
+                std::vector<std::uint8_t> &out) {
+  z_stream stream{};
+  if (inflateInit(&stream) != Z_OK) {
+    return false;
+  }
+
+  stream.next_in = const_cast<Bytef *>(data);
+  stream.avail_in = static_cast<uInt>(size);
+
+  std::uint8_t buffer[64 * 1024];
+  int result;
+
+  do {
+    stream.next_out = buffer;
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      std::fprintf(stderr, "inflate failed: %s\n",
+                   stream.msg ? stream.msg : "unknown error");
+      break;
+    }
+
+    out.insert(out.end(), buffer, buffer + sizeof(buffer) - stream.avail_out);
+  } while (result == Z_OK);
+
+  inflateEnd(&stream);
+  return true;
+}
+
+void formatMessage(std::string &out, std::uint64_t stamp,
+                   std::string_view channel, std::uint8_t level,
+                   std::string_view prefix, std::string_view text) {
+  // Matches logs::file_listener
+  if (stamp != 0) {
+    out += level < std::size(kLevelPrefix) ? kLevelPrefix[level] : "·? ";
+
+    char time[64];
+    std::snprintf(time, sizeof(time), "%" PRIu64 ":%02" PRIu64 ":%02" PRIu64
+                  ".%06" PRIu64 " ",
+                  stamp / 3600'000'000, stamp % 3600'000'000 / 60'000'000,
+                  stamp % 60'000'000 / 1'000'000, stamp % 1'000'000);
+    out += time;
+  }
+
+  if (!prefix.empty()) {
+    out += '{';
+    out += prefix;
+    out += "} ";
+  }
+
+  if (!channel.empty()) {
+    out += channel;
+    out += level == kLevelTodo ? " TODO: " : ": ";
+  } else if (level == kLevelTodo) {
+    out += "TODO: ";
+  }
+
+  out += text;
+  out += '\n';
+}
+
+bool decodeFile(const char *path, std::FILE *output) {
+  std::vector<std::uint8_t> data;
+  if (!readFile(path, data)) {
+    std::fprintf(stderr, "%s: cannot open file\n", path);
+    return false;
+  }
+
+  binlog::FileHeader header;
+  if (data.size() < sizeof(header)) {
+    std::fprintf(stderr, "%s: file is too small\n", path);
+    return false;
+  }
+
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  if (header.magic != binlog::kMagic || header.version != binlog::kVersion) {
+    std::fprintf(stderr, "%s: not a binary log or unsupported version\n",
+                 path);
+    return false;
+  }
+
+  std::vector<std::uint8_t> inflated;
+  binlog::RecordReader reader{data.data() + sizeof(header),
+                              data.size() - sizeof(header)};
+
+  if (header.flags & binlog::kFlagCompressed) {
+    if (!inflateAll(reader.data, reader.size, inflated)) {
+      std::fprintf(stderr, "%s: cannot decompress file\n", path);
+      return false;
+    }
+
+    reader = {inflated.data(), inflated.size()};
+  }
+
+  std::unordered_map<std::uint64_t, std::string_view> channels;
+  std::string text;
+
+  while (reader.pos < reader.size) {
+    std::uint8_t type;
+    reader.getByte(type);
+
+    bool valid = false;
+
+    if (type == static_cast<std::uint8_t>(binlog::RecordType::channel)) {
+      std::uint64_t id;
+      std::string_view name;
+      valid = reader.getVarint(id) && reader.getString(name);
+
+      if (valid) {
+        channels[id] = name;
+      }
+    } else if (type == static_cast<std::uint8_t>(binlog::RecordType::message)) {
+      std::uint64_t stamp, channelId;
+      std::uint8_t level;
+      std::string_view prefix, message;
+      valid = reader.getVarint(stamp) && reader.getVarint(channelId) &&
+              reader.getByte(level) && reader.getString(prefix) &&
+              reader.getString(message);
+
+      if (valid) {
+        auto it = channels.find(channelId);
+        formatMessage(text, stamp,
+                      it != channels.end() ? it->second : std::string_view{},
+                      level, prefix, message);
+      }
+    }
+
+    if (!valid) {
+      std::fprintf(stderr, "%s: truncated or corrupted record at %zu\n", path,
+                   reader.pos);
+      break;
+    }
+
+    if (text.size() >= 1024 * 1024) {
+      std::fwrite(text.data(), 1, text.size(), output);
+      text.clear();
+    }
+  }
+
+  std::fwrite(text.data(), 1, text.size(), output);
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::FILE *output = stdout;
+  int first = 1;
+
+  if (argc > 2 && std::strcmp(argv[1], "-o") == 0) {
+    output = std::fopen(argv[2], "wb");
+    if (output == nullptr) {
+      std::fprintf(stderr, "%s: cannot create file\n", argv[2]);
+      return 1;
+    }
+
+    first = 3;
+  }
+
+  if (first >= argc) {
+    std::fprintf(stderr, "Usage: %s [-o output] file...\n", argv[0]);
+    return 1;
+  }
+
+  bool success = true;
+
+  for (int i = first; i < argc; i++) {
+    success &= decodeFile(argv[i], output);
+  }
+
+  if (output != stdout) {
+    std::fclose(output);
+  }
+
+  return success ? 0 : 1;
+}